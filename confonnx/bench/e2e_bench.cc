@@ -0,0 +1,406 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// End-to-end throughput and latency of score requests through Enclave::HandleRequest,
+// from client-side encryption to client-side decryption, without the HTTP layer.
+// Runs every combination of model, payload size and thread count and reports
+// requests/s plus latency percentiles for each phase:
+//   encrypt    confmsg::Client::MakeRequest
+//   ecall      Enclave::HandleRequest (includes inference), or the HTTP request
+//              handler around it with --handler
+//   inference  conversion and run inside the enclave
+//   decrypt    confmsg::Client::HandleMessage
+// Usage: confonnx_e2e_bench --enclave-path <path> --model <a.onnx> [--model <b.onnx>]
+//          [--payload-size 1024 65536] [--threads 1 4] [--handler] [--simulation | --in-process]
+// Payload sizes are reached by scaling the first symbolic dimension of each input,
+// models with static shapes always use their fixed input size.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+#include "boost/program_options.hpp"
+
+#include <confmsg/client/api.h>
+#include <confmsg/shared/crypto.h>
+
+#include "server/host/core/context.h"
+#include "server/host/environment.h"
+#include "server/host/enclave.h"
+#include "server/host/request_handler.h"
+#include "server/shared/constants.h"
+#include "server/shared/key_vault_config.h"
+#include "server/shared/request_type.h"
+#include "test/helpers/onnx_protobuf.h"
+#include "test/helpers/predict_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+namespace bench {
+
+namespace po = boost::program_options;
+using Clock = std::chrono::steady_clock;
+
+enum Phase {
+  kEncrypt,
+  kEcall,
+  kInference,
+  kDecrypt,
+  kPhaseCount
+};
+
+static const char* const phase_names[kPhaseCount] = {"encrypt", "ecall", "inference", "decrypt"};
+
+struct Config {
+  std::string enclave_path;
+  std::vector<std::string> model_paths;
+  std::vector<size_t> payload_sizes{1024, 64 * 1024, 1024 * 1024};
+  std::vector<int> thread_counts{1, 2, 4};
+  int requests = 2000;
+  int warmup = 10;
+  bool handler = false;
+  bool debug = true;
+  bool simulation = false;
+  bool in_process = false;
+};
+
+static std::vector<uint8_t> ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+static size_t ElementSize(int32_t data_type) {
+  switch (data_type) {
+    case onnx::TensorProto_DataType_BOOL:
+    case onnx::TensorProto_DataType_INT8:
+    case onnx::TensorProto_DataType_UINT8:
+      return 1;
+    case onnx::TensorProto_DataType_INT16:
+    case onnx::TensorProto_DataType_UINT16:
+    case onnx::TensorProto_DataType_FLOAT16:
+    case onnx::TensorProto_DataType_BFLOAT16:
+      return 2;
+    case onnx::TensorProto_DataType_INT32:
+    case onnx::TensorProto_DataType_UINT32:
+    case onnx::TensorProto_DataType_FLOAT:
+      return 4;
+    case onnx::TensorProto_DataType_INT64:
+    case onnx::TensorProto_DataType_UINT64:
+    case onnx::TensorProto_DataType_DOUBLE:
+      return 8;
+    default:
+      throw std::runtime_error("Unsupported input element type " + std::to_string(data_type));
+  }
+}
+
+// Builds a request with random raw_data inputs whose total size is close to payload_size.
+// Returns the actual size of all input tensors in bytes.
+static size_t MakeRequest(const onnx::ModelProto& model, size_t payload_size, PredictRequest& request) {
+  const auto& graph = model.graph();
+  std::vector<const onnx::ValueInfoProto*> inputs;
+  for (const auto& input : graph.input()) {
+    // Inputs with initializers are optional.
+    bool has_initializer = std::any_of(graph.initializer().begin(), graph.initializer().end(),
+                                       [&](const onnx::TensorProto& t) { return t.name() == input.name(); });
+    if (!has_initializer) {
+      inputs.push_back(&input);
+    }
+  }
+  if (inputs.empty()) {
+    throw std::runtime_error("Model has no inputs");
+  }
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  size_t total = 0;
+  for (const auto* input : inputs) {
+    if (!input->type().has_tensor_type()) {
+      throw std::runtime_error("Input '" + input->name() + "' is not a tensor");
+    }
+    const auto& tensor_type = input->type().tensor_type();
+    size_t element_size = ElementSize(tensor_type.elem_type());
+
+    // Fixed part of the shape, symbolic dimensions other than the first are set to 1.
+    std::vector<int64_t> dims;
+    int scaled_dim = -1;
+    size_t fixed_bytes = element_size;
+    for (const auto& dim : tensor_type.shape().dim()) {
+      if (dim.has_dim_value()) {
+        dims.push_back(dim.dim_value());
+        fixed_bytes *= dim.dim_value();
+      } else {
+        if (scaled_dim < 0) {
+          scaled_dim = static_cast<int>(dims.size());
+        }
+        dims.push_back(1);
+      }
+    }
+    if (scaled_dim >= 0) {
+      size_t per_input = payload_size / inputs.size();
+      dims[scaled_dim] = std::max<int64_t>(1, per_input / fixed_bytes);
+    }
+
+    size_t bytes = element_size;
+    onnx::TensorProto& tensor = (*request.mutable_inputs())[input->name()];
+    tensor.set_data_type(tensor_type.elem_type());
+    for (int64_t dim : dims) {
+      tensor.add_dims(dim);
+      bytes *= dim;
+    }
+    std::string data(bytes, '\0');
+    if (tensor_type.elem_type() == onnx::TensorProto_DataType_FLOAT) {
+      // Random bit patterns would include NaNs and denormals.
+      std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+      float* p = reinterpret_cast<float*>(&data[0]);
+      for (size_t i = 0; i < bytes / sizeof(float); i++) {
+        p[i] = dist(rng);
+      }
+    } else if (tensor_type.elem_type() != onnx::TensorProto_DataType_BOOL) {
+      for (char& c : data) {
+        c = static_cast<char>(byte_dist(rng));
+      }
+    }
+    tensor.set_raw_data(std::move(data));
+    total += bytes;
+  }
+  return total;
+}
+
+// Samples of all phases, in microseconds.
+struct Samples {
+  std::vector<double> phases[kPhaseCount];
+
+  void Append(const Samples& other) {
+    for (int i = 0; i < kPhaseCount; i++) {
+      phases[i].insert(phases[i].end(), other.phases[i].begin(), other.phases[i].end());
+    }
+  }
+};
+
+static double ToMicros(Clock::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// Sends a request to the enclave, through the HTTP request handler if context is given.
+// Returns the response, which is only valid until the next call.
+static confmsg::CBuffer Send(Enclave& enclave, const std::shared_ptr<ServerEnvironment>& env,
+                             HttpContext* context, const std::vector<uint8_t>& request_buf, size_t request_size,
+                             std::vector<uint8_t>& response_buf) {
+  if (context) {
+    context->request.body().assign(request_buf.data(), request_size);
+    HandleRequest(*context, RequestType::Score, enclave, env);
+    if (context->response.result_int() != 200) {
+      throw std::runtime_error("Unexpected HTTP status " + std::to_string(context->response.result_int()));
+    }
+    return confmsg::CBuffer(context->response.body().data(), context->response.body().size());
+  }
+  size_t response_size;
+  enclave.HandleRequest("bench", RequestType::Score, request_buf.data(), request_size,
+                        response_buf.data(), &response_size, env);
+  return confmsg::CBuffer(response_buf.data(), response_size);
+}
+
+static void Worker(Enclave& enclave, const std::shared_ptr<ServerEnvironment>& env, bool handler,
+                   const std::vector<uint8_t>& service_id, const std::vector<uint8_t>& plaintext,
+                   int warmup, int requests, std::atomic<int>& ready, const std::atomic<bool>& go,
+                   Samples& samples) {
+  // No expected enclave identity, quotes are not available in simulation and in-process mode.
+  confmsg::Client client(confmsg::RandomKeyProvider::Create(KEY_SIZE), "", {}, service_id, true);
+
+  std::vector<uint8_t> request_buf(plaintext.size() + 1024);
+  std::vector<uint8_t> response_buf(handler ? 0 : MAX_OUTPUT_SIZE);
+  std::unique_ptr<HttpContext> context(handler ? new HttpContext() : nullptr);
+  size_t request_size;
+
+  client.MakeKeyRequest(request_buf.data(), &request_size, request_buf.size());
+  confmsg::CBuffer response = Send(enclave, env, context.get(), request_buf, request_size, response_buf);
+  if (!client.HandleMessage(response.p, response.n).IsKeyResponse()) {
+    throw std::runtime_error("Unexpected response to key request");
+  }
+
+  for (auto& phase : samples.phases) {
+    phase.reserve(requests);
+  }
+
+  for (int i = -warmup; i < requests; i++) {
+    if (i == 0) {
+      // Start all threads at once so that the measured interval only contains contended requests.
+      ready++;
+      while (!go) {
+        std::this_thread::yield();
+      }
+    }
+    auto t0 = Clock::now();
+    client.MakeRequest(plaintext, request_buf.data(), &request_size, request_buf.size());
+    auto t1 = Clock::now();
+    response = Send(enclave, env, context.get(), request_buf, request_size, response_buf);
+    auto t2 = Clock::now();
+    auto inference = enclave.GetLastInferenceTime();
+    confmsg::Client::Result r = client.HandleMessage(response.p, response.n);
+    auto t3 = Clock::now();
+    if (!r.IsResponse()) {
+      throw std::runtime_error("Unexpected response to score request");
+    }
+    if (i >= 0) {
+      samples.phases[kEncrypt].push_back(ToMicros(t1 - t0));
+      samples.phases[kEcall].push_back(ToMicros(t2 - t1));
+      samples.phases[kInference].push_back(ToMicros(inference));
+      samples.phases[kDecrypt].push_back(ToMicros(t3 - t2));
+    }
+  }
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+  size_t index = static_cast<size_t>(p / 100 * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+static void Report(Samples& samples, double seconds, size_t request_bytes) {
+  size_t count = samples.phases[0].size();
+  double rps = count / seconds;
+  std::printf("  %.1f req/s, %.1f MB/s request payload\n", rps, rps * request_bytes / (1024 * 1024));
+  std::printf("  %-10s %10s %10s %10s %10s %10s %10s  (us)\n", "phase", "mean", "p50", "p90", "p99", "p99.9", "max");
+  for (int i = 0; i < kPhaseCount; i++) {
+    auto& v = samples.phases[i];
+    std::sort(v.begin(), v.end());
+    double mean = 0;
+    for (double x : v) {
+      mean += x;
+    }
+    mean /= v.size();
+    std::printf("  %-10s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", phase_names[i], mean,
+                Percentile(v, 50), Percentile(v, 90), Percentile(v, 99), Percentile(v, 99.9), v.back());
+  }
+}
+
+static void Run(const Config& config) {
+  // Logging per request would dominate the measurement.
+  const auto env = std::make_shared<ServerEnvironment>(spdlog::level::level_enum::warn,
+                                                       spdlog::sinks_init_list{std::make_shared<spdlog::sinks::null_sink_mt>()},
+                                                       "");
+
+  for (const std::string& model_path : config.model_paths) {
+    onnx::ModelProto model;
+    std::vector<uint8_t> model_data = ReadFile(model_path);
+    if (!model.ParseFromArray(model_data.data(), static_cast<int>(model_data.size()))) {
+      throw std::runtime_error("Cannot parse " + model_path);
+    }
+    std::vector<uint8_t> service_id;
+    confmsg::internal::SHA256(confmsg::CBuffer(model_data.data(), model_data.size()), service_id);
+
+    Enclave enclave(config.enclave_path, config.debug, config.simulation, config.in_process, env,
+                    KeyVaultConfig(), KeyVaultConfig());
+    enclave.Initialize(model_path, env);
+    enclave.SetTimingEnabled(true);
+
+    for (size_t payload_size : config.payload_sizes) {
+      PredictRequest request;
+      size_t request_bytes = MakeRequest(model, payload_size, request);
+      std::vector<uint8_t> plaintext(request.ByteSizeLong());
+      if (!request.SerializeToArray(plaintext.data(), static_cast<int>(plaintext.size()))) {
+        throw std::runtime_error("protobuf serialization error");
+      }
+
+      for (int thread_count : config.thread_counts) {
+        int requests_per_thread = std::max(1, config.requests / thread_count);
+        std::vector<Samples> samples(thread_count);
+        std::vector<std::thread> threads;
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        for (int t = 0; t < thread_count; t++) {
+          threads.emplace_back([&, t]() {
+            try {
+              Worker(enclave, env, config.handler, service_id, plaintext, config.warmup, requests_per_thread,
+                     ready, go, samples[t]);
+            } catch (...) {
+              std::lock_guard<std::mutex> lock(error_mutex);
+              error = std::current_exception();
+              // Release the other threads.
+              ready++;
+            }
+          });
+        }
+        while (ready < thread_count) {
+          std::this_thread::yield();
+        }
+        auto start = Clock::now();
+        go = true;
+        for (auto& thread : threads) {
+          thread.join();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (error) {
+          std::rethrow_exception(error);
+        }
+
+        Samples all;
+        for (const auto& s : samples) {
+          all.Append(s);
+        }
+        std::printf("%s payload=%zuB threads=%d requests=%zu\n", model_path.c_str(), request_bytes,
+                    thread_count, all.phases[0].size());
+        Report(all, seconds, request_bytes);
+      }
+    }
+  }
+}
+
+}  // namespace bench
+}  // namespace server
+}  // namespace onnxruntime
+
+int main(int argc, char** argv) {
+  using namespace onnxruntime::server::bench;
+  Config config;
+  po::options_description desc("End-to-end benchmark of Enclave::HandleRequest");
+  desc.add_options()("help,h", "Shows a help message and exits");
+  desc.add_options()("enclave-path", po::value(&config.enclave_path)->required(), "Path to enclave binary, or in-process enclave library with --in-process");
+  desc.add_options()("model", po::value(&config.model_paths)->required()->composing(), "ONNX model to benchmark, can be repeated");
+  desc.add_options()("payload-size", po::value(&config.payload_sizes)->multitoken(), "Target input sizes in bytes (default: 1024 65536 1048576)");
+  desc.add_options()("threads", po::value(&config.thread_counts)->multitoken(), "Thread counts, at most the enclave TCS count minus one (default: 1 2 4)");
+  desc.add_options()("requests", po::value(&config.requests)->default_value(config.requests), "Measured requests per configuration, split across threads");
+  desc.add_options()("warmup", po::value(&config.warmup)->default_value(config.warmup), "Unmeasured requests per thread");
+  desc.add_options()("handler", po::bool_switch(&config.handler), "Send requests through the HTTP request handler instead of calling the enclave directly");
+  desc.add_options()("simulation", po::bool_switch(&config.simulation), "Run in simulation mode on non-SGX hardware");
+  desc.add_options()("in-process", po::bool_switch(&config.in_process), "Load the in-process build of the enclave code");
+
+  try {
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      std::cout << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << std::endl
+              << desc << std::endl;
+    return 1;
+  }
+
+  try {
+    Run(config);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
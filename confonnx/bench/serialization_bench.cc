@@ -0,0 +1,284 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Benchmarks for the tensor (de)serialization that runs on every request:
+// TensorProto -> Ort::Value for inputs and Ort::Value -> TensorProto for outputs.
+// Runs on the host, without an enclave.
+// Benchmark names are <function>/<dtype>/<raw|typed>/<tensor bytes>, e.g.
+//   confonnx_serialization_bench --benchmark_filter='TensorProtoToMLValue/float/.*'
+// The typed cases go through serializing/bulk_convert.h. confonnx_serialization_bench_per_element
+// runs the same cases with the per-element conversion loops it replaced.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include "core/session/onnxruntime_cxx_api.h"
+
+#include "server/enclave/core/converter.h"
+#include "server/enclave/core/onnx_protobuf.h"
+#include "server/enclave/core/util.h"
+#include "server/enclave/core/serializing/mem_buffer.h"
+#include "server/enclave/core/serializing/tensorprotoutils.h"
+
+// Counts all heap allocations in the process (including those made by ONNX Runtime
+// and protobuf), reported per call as "allocs".
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace onnxruntime {
+namespace server {
+namespace bench {
+
+struct DataType {
+  const char* name;
+  onnx::TensorProto_DataType type;
+  size_t element_size;
+};
+
+// All types supported by TensorProtoToMLValue and MLValueToTensorProto.
+static const DataType kDataTypes[] = {
+    {"float", onnx::TensorProto_DataType_FLOAT, sizeof(float)},
+    {"double", onnx::TensorProto_DataType_DOUBLE, sizeof(double)},
+    {"int8", onnx::TensorProto_DataType_INT8, sizeof(int8_t)},
+    {"uint8", onnx::TensorProto_DataType_UINT8, sizeof(uint8_t)},
+    {"int16", onnx::TensorProto_DataType_INT16, sizeof(int16_t)},
+    {"uint16", onnx::TensorProto_DataType_UINT16, sizeof(uint16_t)},
+    {"int32", onnx::TensorProto_DataType_INT32, sizeof(int32_t)},
+    {"uint32", onnx::TensorProto_DataType_UINT32, sizeof(uint32_t)},
+    {"int64", onnx::TensorProto_DataType_INT64, sizeof(int64_t)},
+    {"uint64", onnx::TensorProto_DataType_UINT64, sizeof(uint64_t)},
+    {"bool", onnx::TensorProto_DataType_BOOL, sizeof(bool)},
+    {"float16", onnx::TensorProto_DataType_FLOAT16, sizeof(uint16_t)},
+    {"bfloat16", onnx::TensorProto_DataType_BFLOAT16, sizeof(uint16_t)},
+};
+
+// Long enough to not fit into the small string buffer.
+static const size_t kStringLength = 32;
+static const DataType kStringType = {"string", onnx::TensorProto_DataType_STRING, kStringLength};
+
+// Tensor sizes in bytes (of the unpacked tensor). 0 denotes a scalar.
+static const size_t kSizes[] = {0, 1024, 64 * 1024, 1024 * 1024, 32 * 1024 * 1024};
+
+static onnx::TensorProto MakeTensorProto(onnx::TensorProto_DataType type, size_t element_size,
+                                         size_t bytes, bool raw) {
+  onnx::TensorProto proto;
+  proto.set_data_type(type);
+  size_t count = 1;
+  if (bytes > 0) {
+    count = bytes / element_size;
+    proto.add_dims(static_cast<int64_t>(count));
+  }
+
+  if (type == onnx::TensorProto_DataType_STRING) {
+    proto.mutable_string_data()->Reserve(static_cast<int>(count));
+    for (size_t i = 0; i < count; i++) {
+      proto.add_string_data(std::string(kStringLength, static_cast<char>('a' + i % 26)));
+    }
+  } else if (raw) {
+    proto.set_raw_data(std::string(count * element_size, '\0'));
+  } else {
+    switch (type) {
+      case onnx::TensorProto_DataType_FLOAT:
+        proto.mutable_float_data()->Resize(static_cast<int>(count), 1.0f);
+        break;
+      case onnx::TensorProto_DataType_DOUBLE:
+        proto.mutable_double_data()->Resize(static_cast<int>(count), 1.0);
+        break;
+      case onnx::TensorProto_DataType_INT64:
+        proto.mutable_int64_data()->Resize(static_cast<int>(count), 1);
+        break;
+      case onnx::TensorProto_DataType_UINT32:
+      case onnx::TensorProto_DataType_UINT64:
+        proto.mutable_uint64_data()->Resize(static_cast<int>(count), 1);
+        break;
+      default:
+        proto.mutable_int32_data()->Resize(static_cast<int>(count), 1);
+        break;
+    }
+  }
+  return proto;
+}
+
+// Large fixtures take a while to build and a lot of memory, so only the most recent
+// one is kept. Benchmarks run in registration order and both directions of the
+// same tensor are registered next to each other.
+static const onnx::TensorProto& GetTensorProto(onnx::TensorProto_DataType type, size_t element_size,
+                                               size_t bytes, bool raw) {
+  static std::string cached_key;
+  static onnx::TensorProto cached;
+  std::string key = std::to_string(type) + "/" + std::to_string(bytes) + (raw ? "/raw" : "/typed");
+  if (key != cached_key) {
+    cached = MakeTensorProto(type, element_size, bytes, raw);
+    cached_key = key;
+  }
+  return cached;
+}
+
+static void DestroyStrings(const onnx::TensorProto& proto, uint8_t* buf, size_t len) {
+  if (proto.data_type() == onnx::TensorProto_DataType_STRING) {
+    auto* strings = reinterpret_cast<std::string*>(buf);
+    for (size_t i = 0; i < len / sizeof(std::string); i++) {
+      strings[i].~basic_string();
+    }
+  }
+}
+
+static void SetCounters(benchmark::State& state, size_t bytes_per_call, uint64_t allocations_before) {
+  if (bytes_per_call > 0) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes_per_call));
+  }
+  state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocation_count.load() - allocations_before),
+                                                benchmark::Counter::kAvgIterations);
+}
+
+static size_t TensorBytes(const onnx::TensorProto& proto, size_t element_size) {
+  size_t count = 1;
+  for (int64_t dim : proto.dims()) {
+    count *= static_cast<size_t>(dim);
+  }
+  return count * element_size;
+}
+
+static void BM_MLDataTypeToTensorProtoDataType(benchmark::State& state) {
+  const ONNXTensorElementDataType types[] = {
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8,
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32,
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING, ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL,
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE, ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32,
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64, ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16};
+  uint64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    for (auto type : types) {
+      auto proto_type = MLDataTypeToTensorProtoDataType(type);
+      benchmark::DoNotOptimize(proto_type);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (sizeof(types) / sizeof(types[0]))));
+  SetCounters(state, 0, allocations_before);
+}
+
+static void BM_GetSizeInBytesFromTensorProto(benchmark::State& state, const DataType& dt) {
+  const onnx::TensorProto& proto = GetTensorProto(dt.type, dt.element_size, 1024, true);
+  uint64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    size_t size = 0;
+    GetSizeInBytesFromTensorProto<0>(proto, &size);
+    benchmark::DoNotOptimize(size);
+  }
+  SetCounters(state, 0, allocations_before);
+}
+
+// Mirrors Executor::SetMLValue: size the buffer, allocate it, unpack into it.
+static void BM_TensorProtoToMLValue(benchmark::State& state, const DataType& dt, size_t bytes, bool raw) {
+  const onnx::TensorProto& proto = GetTensorProto(dt.type, dt.element_size, bytes, raw);
+  Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  const OrtMemoryInfo* cpu_memory_info = memory_info;
+  uint64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    size_t len = 0;
+    GetSizeInBytesFromTensorProto<0>(proto, &len);
+    MemBufferArray buffers;
+    uint8_t* buf = buffers.AllocNewBuffer(len);
+    Ort::Value value{nullptr};
+    TensorProtoToMLValue(proto, MemBuffer(buf, len, *cpu_memory_info), value);
+    benchmark::DoNotOptimize(value);
+    DestroyStrings(proto, buf, len);
+  }
+  SetCounters(state, TensorBytes(proto, dt.element_size), allocations_before);
+}
+
+// Mirrors Executor::AddOutput without output encodings.
+static void BM_MLValueToTensorProto(benchmark::State& state, const DataType& dt, size_t bytes, bool raw) {
+  const onnx::TensorProto& proto = GetTensorProto(dt.type, dt.element_size, bytes, raw);
+  Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  const OrtMemoryInfo* cpu_memory_info = memory_info;
+  size_t len = 0;
+  GetSizeInBytesFromTensorProto<0>(proto, &len);
+  MemBufferArray buffers;
+  uint8_t* buf = buffers.AllocNewBuffer(len);
+  Ort::Value value{nullptr};
+  TensorProtoToMLValue(proto, MemBuffer(buf, len, *cpu_memory_info), value);
+
+  spdlog::logger null_logger("bench", std::make_shared<spdlog::sinks::null_sink_mt>());
+  RequestLogger logger(&null_logger, "bench");
+  uint64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    onnx::TensorProto output;
+    MLValueToTensorProto(value, raw, logger, output);
+    benchmark::DoNotOptimize(output);
+  }
+  SetCounters(state, TensorBytes(proto, dt.element_size), allocations_before);
+
+  value = Ort::Value{nullptr};
+  DestroyStrings(proto, buf, len);
+}
+
+static std::string SizeName(size_t bytes) {
+  return bytes == 0 ? "scalar" : std::to_string(bytes);
+}
+
+static void RegisterAll() {
+  benchmark::RegisterBenchmark("MLDataTypeToTensorProtoDataType", BM_MLDataTypeToTensorProtoDataType);
+
+  for (const DataType& dt : kDataTypes) {
+    benchmark::RegisterBenchmark(("GetSizeInBytesFromTensorProto/" + std::string(dt.name)).c_str(),
+                                 BM_GetSizeInBytesFromTensorProto, dt);
+  }
+
+  for (const DataType& dt : kDataTypes) {
+    for (bool raw : {true, false}) {
+      for (size_t bytes : kSizes) {
+        std::string suffix = std::string(dt.name) + (raw ? "/raw/" : "/typed/") + SizeName(bytes);
+        benchmark::RegisterBenchmark(("TensorProtoToMLValue/" + suffix).c_str(),
+                                     BM_TensorProtoToMLValue, dt, bytes, raw);
+        benchmark::RegisterBenchmark(("MLValueToTensorProto/" + suffix).c_str(),
+                                     BM_MLValueToTensorProto, dt, bytes, raw);
+      }
+    }
+  }
+
+  // Strings only have a typed encoding. Sizes count the string payload, not sizeof(std::string).
+  for (size_t bytes : kSizes) {
+    std::string suffix = "string/typed/" + SizeName(bytes);
+    benchmark::RegisterBenchmark(("TensorProtoToMLValue/" + suffix).c_str(),
+                                 BM_TensorProtoToMLValue, kStringType, bytes, false);
+    benchmark::RegisterBenchmark(("MLValueToTensorProto/" + suffix).c_str(),
+                                 BM_MLValueToTensorProto, kStringType, bytes, false);
+  }
+}
+
+}  // namespace bench
+}  // namespace server
+}  // namespace onnxruntime
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  onnxruntime::server::bench::RegisterAll();
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
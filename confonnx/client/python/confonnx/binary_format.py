@@ -0,0 +1,66 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT License.
+
+# Compact binary tensor format, see server/enclave/core/binary_format.h.
+
+from typing import Mapping, Tuple
+import struct
+
+import numpy as np
+
+import confonnx.mapping as mapping
+
+MAGIC = 0x42545843  # "CXTB"
+VERSION = 1
+MAX_RANK = 8
+ALIGNMENT = 64
+
+HEADER = struct.Struct('<IHHII')
+DESCRIPTOR = struct.Struct('<IIiIQQ' + 'q' * MAX_RANK)
+
+# Types without a fixed-size binary representation.
+UNSUPPORTED_DTYPES = (np.dtype('object'), np.dtype('complex64'), np.dtype('complex128'))
+
+def _align(offset: int) -> int:
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+def encode(tensors: Mapping[str,np.ndarray], model_version: int=0) -> bytes:
+    arrays = []
+    for name, arr in tensors.items():
+        arr = np.asarray(arr)
+        if arr.dtype in UNSUPPORTED_DTYPES or arr.dtype not in mapping.NP_TYPE_TO_TENSOR_TYPE:
+            raise ValueError(f'{name}: dtype {arr.dtype} not supported by binary format')
+        if arr.ndim > MAX_RANK:
+            raise ValueError(f'{name}: rank {arr.ndim} exceeds {MAX_RANK}')
+        arrays.append((name.encode('utf-8'), arr))
+
+    buf = bytearray(HEADER.size + len(arrays) * DESCRIPTOR.size)
+    HEADER.pack_into(buf, 0, MAGIC, VERSION, len(arrays), model_version, 0)
+    for i, (name, arr) in enumerate(arrays):
+        name_offset = len(buf)
+        data_offset = _align(name_offset + len(name))
+        dims = list(arr.shape) + [0] * (MAX_RANK - arr.ndim)
+        DESCRIPTOR.pack_into(buf, HEADER.size + i * DESCRIPTOR.size,
+                             name_offset, len(name), mapping.NP_TYPE_TO_TENSOR_TYPE[arr.dtype],
+                             arr.ndim, data_offset, arr.nbytes, *dims)
+        buf += name
+        buf += bytes(data_offset - len(buf))
+        buf += arr.astype(arr.dtype.newbyteorder('<'), copy=False).tobytes()
+    return bytes(buf)
+
+def decode(buf: bytes) -> Tuple[Mapping[str,np.ndarray], int]:
+    magic, version, tensor_count, model_version, _ = HEADER.unpack_from(buf, 0)
+    if magic != MAGIC:
+        raise ValueError('not a binary tensor message')
+    if version != VERSION:
+        raise ValueError(f'unsupported binary format version {version}')
+
+    tensors = {}
+    for i in range(tensor_count):
+        name_offset, name_length, data_type, rank, data_offset, data_length, *dims = \
+            DESCRIPTOR.unpack_from(buf, HEADER.size + i * DESCRIPTOR.size)
+        name = bytes(buf[name_offset:name_offset + name_length]).decode('utf-8')
+        dtype = mapping.TENSOR_TYPE_TO_NP_TYPE[data_type].newbyteorder('<')
+        arr = np.frombuffer(buf, dtype=dtype, count=data_length // dtype.itemsize, offset=data_offset)
+        tensors[name] = arr.reshape(dims[:rank])
+    return tensors, model_version
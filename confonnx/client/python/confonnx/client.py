@@ -10,8 +10,10 @@ from requests.auth import HTTPBasicAuth, AuthBase
 import numpy as np
 
 import confonnx.predict_pb2 as predict_pb2
+import confonnx.onnx_ml_pb2 as onnx_ml_pb2
 # Cannot use onnx.numpy_helper as the Python types between predict.proto and onnx.proto differ.
 import confonnx.numpy_helper as numpy_helper
+import confonnx.binary_format as binary_format
 
 import confonnx.confonnx_py as confonnx_py
 import confonnx.colors as C
@@ -22,7 +24,9 @@ REQUEST_HEADERS = {
 }
 
 PREDICT_URL_PATH = 'score'
+PREDICT_BINARY_URL_PATH = 'scoreBinary'
 MODEL_KEY_PROVISIONING_URL_PATH = 'provisionModelKey'
+MODEL_UPDATE_URL_PATH = 'updateModel'
 
 class HTTPBearerKeyAuth(AuthBase):
     def __init__(self, key):
@@ -45,6 +49,7 @@ class Client(object):
         self.key_outdated = True
         self.key_rollover_count = -1 # initial key exchange brings it to 0
         self.key_invalid_count = 0
+        self.model_version = None # version of the model that served the last response
         # Currently, service identifier is equal to the hash of the model loaded in the enclave.
         enclave_service_id = ''
         if enclave_model_hash:
@@ -75,21 +80,86 @@ class Client(object):
         self._send_request(req_msg, MODEL_KEY_PROVISIONING_URL_PATH)
         print('Model key provisioned')
 
-    def predict(self, data: Mapping[str,np.ndarray]) -> Mapping[str,np.ndarray]:
+    def update_model(self, encrypted_model: bytes) -> int:
+        """Replaces the served model. The model must be encrypted with the model key."""
+        self._request_key_if_outdated()
+        req_msg = self._create_request(encrypted_model)
+        resp_msg = self._send_request(req_msg, MODEL_UPDATE_URL_PATH)
+        resp_obj = self._client.handle_message(resp_msg)
+        assert resp_obj.has_data()
+        update_response = predict_pb2.UpdateModelResponse()
+        update_response.ParseFromString(resp_obj.get_data())
+        print(f'Model updated to version {update_response.model_version}')
+        # The service identifier changed together with the model.
+        self.key_outdated = True
+        self.model_version = update_response.model_version
+        return update_response.model_version
+
+    def predict(self, data: Mapping[str,np.ndarray],
+                post_processing: Optional[Mapping[str,predict_pb2.PostProcessing]]=None,
+                input_encodings: Optional[Mapping[str,predict_pb2.WireEncoding]]=None,
+                output_encodings: Optional[Mapping[str,predict_pb2.WireEncoding]]=None) -> Mapping[str,np.ndarray]:
+        input_encodings = input_encodings or {}
+
         # Create Protobuf inference request payload
         predict_request = predict_pb2.PredictRequest()
         for input_name, arr in data.items():
-            tensor = numpy_helper.from_array(arr)
+            if input_name in input_encodings:
+                tensor = encode_tensor(arr, input_encodings[input_name])
+                predict_request.input_encodings[input_name].CopyFrom(input_encodings[input_name])
+            else:
+                tensor = numpy_helper.from_array(arr)
             predict_request.inputs[input_name].CopyFrom(tensor)
+        for output_name, spec in (post_processing or {}).items():
+            predict_request.post_processing[output_name].CopyFrom(spec)
+        for output_name, encoding in (output_encodings or {}).items():
+            predict_request.output_encodings[output_name].CopyFrom(encoding)
 
         req_data = predict_request.SerializeToString()
+        resp_data = self._predict(req_data, PREDICT_URL_PATH)
+
+        # Parse Protobuf inference result payload
+        print('Parsing inference response')
+        predict_response = predict_pb2.PredictResponse()
+        predict_response.ParseFromString(resp_data)
+
+        self._check_model_version(predict_response.model_version)
+
+        # Convert to numpy arrays
+        outputs = {}
+        for output_name, tensor in predict_response.outputs.items():
+            if output_name in predict_response.output_encodings:
+                outputs[output_name] = decode_tensor(tensor, predict_response.output_encodings[output_name])
+            else:
+                outputs[output_name] = numpy_helper.to_array(tensor)
+        #for output_name, arr in outputs.items():
+        #    print(' {}: dtype={} shape={}'.format(output_name, arr.dtype, arr.shape))
+
+        print(f'{C.OKGREEN}{C.BOLD}Inference response successfully processed{C.END}')
+
+        return outputs
 
+    def predict_binary(self, data: Mapping[str,np.ndarray]) -> Mapping[str,np.ndarray]:
+        """ Like predict(), but uses the compact binary tensor format instead of protobuf.
+        Post-processing and wire encodings are not available with this format. """
+        req_data = binary_format.encode(data)
+        resp_data = self._predict(req_data, PREDICT_BINARY_URL_PATH)
+
+        print('Parsing inference response')
+        outputs, model_version = binary_format.decode(resp_data)
+        self._check_model_version(model_version)
+
+        print(f'{C.OKGREEN}{C.BOLD}Inference response successfully processed{C.END}')
+
+        return outputs
+
+    def _predict(self, req_data, url_path):
         # Encrypt and send request
         self._request_key_if_outdated()
         print(f'{C.HEADER}{C.BOLD}{C.UNDERLINE}STEP 2{C.END}: Inference request')
         try:
             req_msg = self._create_request(req_data)
-            resp_msg = self._send_request(req_msg, PREDICT_URL_PATH)
+            resp_msg = self._send_request(req_msg, url_path)
         except RequestError as e:
             # Retry once from scratch (incl. key refresh) if we got a crypto error.
             # This may happen if the server did a key rollover and we hold a key
@@ -97,7 +167,7 @@ class Client(object):
             if e.error_code == 2: # CRYPTO_ERROR
                 self._request_key_if_outdated(force=True)
                 req_msg = self._create_request(req_data)
-                resp_msg = self._send_request(req_msg, PREDICT_URL_PATH)
+                resp_msg = self._send_request(req_msg, url_path)
                 self.key_invalid_count += 1
             else:
                 raise
@@ -113,20 +183,15 @@ class Client(object):
         if resp_obj.is_key_outdated():
             self.key_outdated = True
 
-        # Parse Protobuf inference result payload
-        print('Parsing inference response')
-        predict_response = predict_pb2.PredictResponse()
-        predict_response.ParseFromString(resp_data)
+        return resp_data
 
-        # Convert to numpy arrays
-        outputs = {output_name: numpy_helper.to_array(tensor)
-                   for output_name, tensor in predict_response.outputs.items()}
-        #for output_name, arr in outputs.items():
-        #    print(' {}: dtype={} shape={}'.format(output_name, arr.dtype, arr.shape))
-
-        print(f'{C.OKGREEN}{C.BOLD}Inference response successfully processed{C.END}')
-
-        return outputs
+    def _check_model_version(self, model_version):
+        # The model was replaced since our last request. Re-establish the connection
+        # so that the new service identifier gets verified for the next request.
+        if self.model_version is not None and model_version != self.model_version:
+            print(f'Model changed from version {self.model_version} to {model_version}')
+            self.key_outdated = True
+        self.model_version = model_version
 
     def _create_request(self, data):
         print('Encrypting data')
@@ -171,6 +236,37 @@ class RequestError(Exception):
             self.error_message = response_text
         super().__init__(f"HTTP status={status_code}, error code={self.error_code}, error message={self.error_message}")
 
+def encode_tensor(arr: np.ndarray, encoding: predict_pb2.WireEncoding) -> onnx_ml_pb2.TensorProto:
+    """Encodes a float32 array into a reduced-precision TensorProto."""
+    arr = np.ascontiguousarray(arr, dtype=np.float32)
+    if encoding.type == predict_pb2.WireEncoding.FLOAT16:
+        return numpy_helper.from_array(arr.astype(np.float16))
+    elif encoding.type == predict_pb2.WireEncoding.BFLOAT16:
+        bits = arr.view(np.uint32)
+        # round to nearest even
+        rounded = ((bits + 0x7fff + ((bits >> 16) & 1)) >> 16).astype(np.uint16)
+        rounded = np.where(np.isnan(arr), (bits >> 16).astype(np.uint16) | 0x40, rounded)
+        tensor = onnx_ml_pb2.TensorProto()
+        tensor.dims.extend(arr.shape)
+        tensor.data_type = onnx_ml_pb2.TensorProto.BFLOAT16
+        tensor.raw_data = rounded.astype('<u2').tobytes()
+        return tensor
+    elif encoding.type == predict_pb2.WireEncoding.INT8:
+        q = np.rint(arr / encoding.scale + encoding.zero_point)
+        return numpy_helper.from_array(np.clip(q, -128, 127).astype(np.int8))
+    else:
+        return numpy_helper.from_array(arr)
+
+def decode_tensor(tensor: onnx_ml_pb2.TensorProto, encoding: predict_pb2.WireEncoding) -> np.ndarray:
+    """Decodes a reduced-precision TensorProto into a float32 array."""
+    if encoding.type == predict_pb2.WireEncoding.BFLOAT16:
+        bits = np.frombuffer(tensor.raw_data, dtype='<u2').astype(np.uint32) << 16
+        return bits.view(np.float32).reshape(tuple(tensor.dims))
+    arr = numpy_helper.to_array(tensor).astype(np.float32)
+    if encoding.type == predict_pb2.WireEncoding.INT8:
+        arr = encoding.scale * (arr - encoding.zero_point)
+    return arr
+
 def _do_request(url: str, data: bytes, headers: Mapping[str,str], auth: Optional[AuthBase]):
     response = requests.post(url, headers=headers, data=data, auth=auth)
     try:
@@ -4,22 +4,43 @@
 import argparse
 import os
 import secrets
+import struct
 from Crypto.Cipher import AES
 
 IV_SIZE = 12
 SYMMETRIC_KEY_SIZE = 32
 
-def encrypt_model(model_path, encrypted_model_path, key=None, key_path=None) -> None:
+def encrypt_model(model_path, encrypted_model_path, key=None, key_path=None, update_version=None) -> None:
+    """Encrypts a model with the model key.
+
+    For an update of a running server, update_version must be greater than
+    the version currently served (the initial model is version 1).
+    The server only remembers the served version until it restarts, after
+    which any update encrypted with the same key is accepted again.
+    """
     if key_path:
         with open(key_path) as f:
             key = f.read()
     key = bytes.fromhex(key)
-    nonce = bytes(IV_SIZE) # zeros
+    update = update_version is not None
+    if update:
+        # Model updates reuse the model key, so they need a fresh nonce.
+        # The version is authenticated so that the server can reject replayed
+        # older updates. Both are stored in front of the ciphertext.
+        nonce = secrets.token_bytes(IV_SIZE)
+        version = struct.pack('>I', update_version)
+    else:
+        nonce = bytes(IV_SIZE) # zeros
     with open(model_path, 'rb') as f:
         model = f.read()
     cipher = AES.new(key, AES.MODE_GCM, nonce=nonce)
+    if update:
+        cipher.update(version)
     ciphertext, tag = cipher.encrypt_and_digest(model)
     with open(encrypted_model_path, 'wb') as f:
+        if update:
+            f.write(version)
+            f.write(nonce)
         f.write(ciphertext)
         f.write(tag)
 
@@ -42,6 +63,7 @@ if __name__ == '__main__':
     parser.add_argument('model', help='Path to model')
     parser.add_argument('--key', help='Path to key, will be generated if not existing (default: <filename>.key)')
     parser.add_argument('--out', help='Path to encrypted model (default: <filename>.enc)')
+    parser.add_argument('--update', type=int, metavar='VERSION', help='Encrypt for a model update of a running server, VERSION must be greater than the served version')
     args = parser.parse_args()
 
     if not os.path.exists(args.model):
@@ -53,4 +75,4 @@ if __name__ == '__main__':
     if not os.path.exists(args.key):
         generate_key_file(args.key)
     
-    encrypt_model(args.model, args.out, key_path=args.key)
+    encrypt_model(args.model, args.out, key_path=args.key, update_version=args.update)
@@ -113,6 +113,23 @@ def _main_provision_model_key(args) -> None:
 
     c.provision_model_key(key)
 
+def _main_update_model(args) -> None:
+    with open(args.model_file, 'rb') as fp:
+        encrypted_model = fp.read()
+
+    enclave_signing_key = None
+    if args.enclave_signing_key_file:
+        with open(args.enclave_signing_key_file) as fp:
+            enclave_signing_key = fp.read()
+
+    c = Client(url=args.url,
+               auth=get_auth(args),
+               enclave_signing_key=enclave_signing_key,
+               enclave_hash=args.enclave_hash,
+               enclave_allow_debug=args.enclave_allow_debug)
+
+    c.update_model(encrypted_model)
+
 def get_auth(args):
     if args.auth_key:
         auth = {'key': args.auth_key}
@@ -124,9 +141,10 @@ def get_auth(args):
 
 def main(argv: List[str]) -> None:
     parser = argparse.ArgumentParser(description='Test client for sending inference requests')
-    parser.add_argument('--mode', help='Request mode', choices=['predict', 'provision-model-key'], default='predict')
+    parser.add_argument('--mode', help='Request mode', choices=['predict', 'provision-model-key', 'update-model'], default='predict')
     parser.add_argument('--model-key', help='Model key (if --mode provision-model-key)')
     parser.add_argument('--model-key-file', help='Path to model key file (if --mode provision-model-key)')
+    parser.add_argument('--model-file', help='Path to new model encrypted with the model key using encrypt_model --update VERSION (if --mode update-model)')
     parser.add_argument('--url', help='Server URL', default='http://localhost:8001/')
     parser.add_argument('--auth-key', help='Authentication key (HTTP Bearer)')
     parser.add_argument('--auth-user', default='api', help='Authentication username (HTTP Basic)')
@@ -164,6 +182,12 @@ def main(argv: List[str]) -> None:
             parser.error('One of --model-key-file/--model-key is required for --mode provision-model-key')
     
         _main_provision_model_key(args)
+
+    elif args.mode == 'update-model':
+        if not args.model_file:
+            parser.error('--model-file is required for --mode update-model')
+
+        _main_update_model(args)
     else:
         assert False    
 
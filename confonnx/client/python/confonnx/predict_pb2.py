@@ -5,6 +5,7 @@
 
 import sys
 _b=sys.version_info[0]<3 and (lambda x:x) or (lambda x:x.encode('latin1'))
+from google.protobuf.internal import enum_type_wrapper
 from google.protobuf import descriptor as _descriptor
 from google.protobuf import message as _message
 from google.protobuf import reflection as _reflection
@@ -22,12 +23,72 @@ DESCRIPTOR = _descriptor.FileDescriptor(
   package='onnxruntime.server',
   syntax='proto3',
   serialized_options=None,
-  serialized_pb=_b('\n\rpredict.proto\x12\x12onnxruntime.server\x1a\ronnx-ml.proto\"\xaf\x01\n\x0ePredictRequest\x12>\n\x06inputs\x18\x02 \x03(\x0b\x32..onnxruntime.server.PredictRequest.InputsEntry\x12\x15\n\routput_filter\x18\x03 \x03(\t\x1a@\n\x0bInputsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12 \n\x05value\x18\x02 \x01(\x0b\x32\x11.onnx.TensorProto:\x02\x38\x01J\x04\x08\x01\x10\x02\"\x97\x01\n\x0fPredictResponse\x12\x41\n\x07outputs\x18\x01 \x03(\x0b\x32\x30.onnxruntime.server.PredictResponse.OutputsEntry\x1a\x41\n\x0cOutputsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12 \n\x05value\x18\x02 \x01(\x0b\x32\x11.onnx.TensorProto:\x02\x38\x01\x62\x06proto3')
+  serialized_pb=_b('\n\rpredict.proto\x12\x12onnxruntime.server\x1a\ronnx-ml.proto\"\xb2\x05\n\x0ePredictRequest\x12>\n\x06inputs\x18\x02 \x03(\x0b\x32..onnxruntime.server.PredictRequest.InputsEntry\x12\x15\n\routput_filter\x18\x03 \x03(\t\x12O\n\x0fpost_processing\x18\x04 \x03(\x0b\x32\x36.onnxruntime.server.PredictRequest.PostProcessingEntry\x12O\n\x0finput_encodings\x18\x05 \x03(\x0b\x32\x36.onnxruntime.server.PredictRequest.InputEncodingsEntry\x12Q\n\x10output_encodings\x18\x06 \x03(\x0b\x32\x37.onnxruntime.server.PredictRequest.OutputEncodingsEntry\x1a@\n\x0bInputsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12 \n\x05value\x18\x02 \x01(\x0b\x32\x11.onnx.TensorProto:\x02\x38\x01\x1aY\n\x13PostProcessingEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12\x31\n\x05value\x18\x02 \x01(\x0b\x32\".onnxruntime.server.PostProcessing:\x02\x38\x01\x1aW\n\x13InputEncodingsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12/\n\x05value\x18\x02 \x01(\x0b\x32 .onnxruntime.server.WireEncoding:\x02\x38\x01\x1aX\n\x14OutputEncodingsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12/\n\x05value\x18\x02 \x01(\x0b\x32 .onnxruntime.server.WireEncoding:\x02\x38\x01J\x04\x08\x01\x10\x02\"\x9e\x01\n\x0cWireEncoding\x12\x33\n\x04type\x18\x01 \x01(\x0e\x32%.onnxruntime.server.WireEncoding.Type\x12\r\n\x05scale\x18\x02 \x01(\x02\x12\x12\n\nzero_point\x18\x03 \x01(\x05\"6\n\x04Type\x12\t\n\x05\x46LOAT\x10\x00\x12\x0b\n\x07\x46LOAT16\x10\x01\x12\x0c\n\x08\x42\x46LOAT16\x10\x02\x12\x08\n\x04INT8\x10\x03\"\x9d\x01\n\x0ePostProcessing\x12\x35\n\x04type\x18\x01 \x01(\x0e\x32\'.onnxruntime.server.PostProcessing.Type\x12\t\n\x01k\x18\x02 \x01(\r\x12\x11\n\tthreshold\x18\x03 \x01(\x02\"6\n\x04Type\x12\x08\n\x04NONE\x10\x00\x12\t\n\x05TOP_K\x10\x01\x12\n\n\x06\x41RGMAX\x10\x02\x12\r\n\tTHRESHOLD\x10\x03\"\xdc\x02\n\x0fPredictResponse\x12\x41\n\x07outputs\x18\x01 \x03(\x0b\x32\x30.onnxruntime.server.PredictResponse.OutputsEntry\x12\x15\n\rmodel_version\x18\x02 \x01(\r\x12R\n\x10output_encodings\x18\x03 \x03(\x0b\x32\x38.onnxruntime.server.PredictResponse.OutputEncodingsEntry\x1a\x41\n\x0cOutputsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12 \n\x05value\x18\x02 \x01(\x0b\x32\x11.onnx.TensorProto:\x02\x38\x01\x1aX\n\x14OutputEncodingsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12/\n\x05value\x18\x02 \x01(\x0b\x32 .onnxruntime.server.WireEncoding:\x02\x38\x01\",\n\x13UpdateModelResponse\x12\x15\n\rmodel_version\x18\x01 \x01(\rb\x06proto3')
   ,
   dependencies=[onnx__ml__pb2.DESCRIPTOR,])
 
 
 
+_WIREENCODING_TYPE = _descriptor.EnumDescriptor(
+  name='Type',
+  full_name='onnxruntime.server.WireEncoding.Type',
+  filename=None,
+  file=DESCRIPTOR,
+  values=[
+    _descriptor.EnumValueDescriptor(
+      name='FLOAT', index=0, number=0,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='FLOAT16', index=1, number=1,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='BFLOAT16', index=2, number=2,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='INT8', index=3, number=3,
+      serialized_options=None,
+      type=None),
+  ],
+  containing_type=None,
+  serialized_options=None,
+  serialized_start=850,
+  serialized_end=904,
+)
+_sym_db.RegisterEnumDescriptor(_WIREENCODING_TYPE)
+
+_POSTPROCESSING_TYPE = _descriptor.EnumDescriptor(
+  name='Type',
+  full_name='onnxruntime.server.PostProcessing.Type',
+  filename=None,
+  file=DESCRIPTOR,
+  values=[
+    _descriptor.EnumValueDescriptor(
+      name='NONE', index=0, number=0,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='TOP_K', index=1, number=1,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='ARGMAX', index=2, number=2,
+      serialized_options=None,
+      type=None),
+    _descriptor.EnumValueDescriptor(
+      name='THRESHOLD', index=3, number=3,
+      serialized_options=None,
+      type=None),
+  ],
+  containing_type=None,
+  serialized_options=None,
+  serialized_start=1010,
+  serialized_end=1064,
+)
+_sym_db.RegisterEnumDescriptor(_POSTPROCESSING_TYPE)
+
 
 _PREDICTREQUEST_INPUTSENTRY = _descriptor.Descriptor(
   name='InputsEntry',
@@ -62,8 +123,119 @@ _PREDICTREQUEST_INPUTSENTRY = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=158,
-  serialized_end=222,
+  serialized_start=403,
+  serialized_end=467,
+)
+
+_PREDICTREQUEST_POSTPROCESSINGENTRY = _descriptor.Descriptor(
+  name='PostProcessingEntry',
+  full_name='onnxruntime.server.PredictRequest.PostProcessingEntry',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='key', full_name='onnxruntime.server.PredictRequest.PostProcessingEntry.key', index=0,
+      number=1, type=9, cpp_type=9, label=1,
+      has_default_value=False, default_value=_b("").decode('utf-8'),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='value', full_name='onnxruntime.server.PredictRequest.PostProcessingEntry.value', index=1,
+      number=2, type=11, cpp_type=10, label=1,
+      has_default_value=False, default_value=None,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  serialized_options=_b('8\001'),
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=469,
+  serialized_end=558,
+)
+
+_PREDICTREQUEST_INPUTENCODINGSENTRY = _descriptor.Descriptor(
+  name='InputEncodingsEntry',
+  full_name='onnxruntime.server.PredictRequest.InputEncodingsEntry',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='key', full_name='onnxruntime.server.PredictRequest.InputEncodingsEntry.key', index=0,
+      number=1, type=9, cpp_type=9, label=1,
+      has_default_value=False, default_value=_b("").decode('utf-8'),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='value', full_name='onnxruntime.server.PredictRequest.InputEncodingsEntry.value', index=1,
+      number=2, type=11, cpp_type=10, label=1,
+      has_default_value=False, default_value=None,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  serialized_options=_b('8\001'),
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=560,
+  serialized_end=647,
+)
+
+_PREDICTREQUEST_OUTPUTENCODINGSENTRY = _descriptor.Descriptor(
+  name='OutputEncodingsEntry',
+  full_name='onnxruntime.server.PredictRequest.OutputEncodingsEntry',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='key', full_name='onnxruntime.server.PredictRequest.OutputEncodingsEntry.key', index=0,
+      number=1, type=9, cpp_type=9, label=1,
+      has_default_value=False, default_value=_b("").decode('utf-8'),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='value', full_name='onnxruntime.server.PredictRequest.OutputEncodingsEntry.value', index=1,
+      number=2, type=11, cpp_type=10, label=1,
+      has_default_value=False, default_value=None,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  serialized_options=_b('8\001'),
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=649,
+  serialized_end=737,
 )
 
 _PREDICTREQUEST = _descriptor.Descriptor(
@@ -87,10 +259,31 @@ _PREDICTREQUEST = _descriptor.Descriptor(
       message_type=None, enum_type=None, containing_type=None,
       is_extension=False, extension_scope=None,
       serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='post_processing', full_name='onnxruntime.server.PredictRequest.post_processing', index=2,
+      number=4, type=11, cpp_type=10, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='input_encodings', full_name='onnxruntime.server.PredictRequest.input_encodings', index=3,
+      number=5, type=11, cpp_type=10, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='output_encodings', full_name='onnxruntime.server.PredictRequest.output_encodings', index=4,
+      number=6, type=11, cpp_type=10, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
   ],
   extensions=[
   ],
-  nested_types=[_PREDICTREQUEST_INPUTSENTRY, ],
+  nested_types=[_PREDICTREQUEST_INPUTSENTRY, _PREDICTREQUEST_POSTPROCESSINGENTRY, _PREDICTREQUEST_INPUTENCODINGSENTRY, _PREDICTREQUEST_OUTPUTENCODINGSENTRY, ],
   enum_types=[
   ],
   serialized_options=None,
@@ -100,7 +293,99 @@ _PREDICTREQUEST = _descriptor.Descriptor(
   oneofs=[
   ],
   serialized_start=53,
-  serialized_end=228,
+  serialized_end=743,
+)
+
+
+_WIREENCODING = _descriptor.Descriptor(
+  name='WireEncoding',
+  full_name='onnxruntime.server.WireEncoding',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='type', full_name='onnxruntime.server.WireEncoding.type', index=0,
+      number=1, type=14, cpp_type=8, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='scale', full_name='onnxruntime.server.WireEncoding.scale', index=1,
+      number=2, type=2, cpp_type=6, label=1,
+      has_default_value=False, default_value=float(0),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='zero_point', full_name='onnxruntime.server.WireEncoding.zero_point', index=2,
+      number=3, type=5, cpp_type=1, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+    _WIREENCODING_TYPE,
+  ],
+  serialized_options=None,
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=746,
+  serialized_end=904,
+)
+
+
+_POSTPROCESSING = _descriptor.Descriptor(
+  name='PostProcessing',
+  full_name='onnxruntime.server.PostProcessing',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='type', full_name='onnxruntime.server.PostProcessing.type', index=0,
+      number=1, type=14, cpp_type=8, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='k', full_name='onnxruntime.server.PostProcessing.k', index=1,
+      number=2, type=13, cpp_type=3, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='threshold', full_name='onnxruntime.server.PostProcessing.threshold', index=2,
+      number=3, type=2, cpp_type=6, label=1,
+      has_default_value=False, default_value=float(0),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+    _POSTPROCESSING_TYPE,
+  ],
+  serialized_options=None,
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=907,
+  serialized_end=1064,
 )
 
 
@@ -137,8 +422,45 @@ _PREDICTRESPONSE_OUTPUTSENTRY = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=317,
-  serialized_end=382,
+  serialized_start=1260,
+  serialized_end=1325,
+)
+
+_PREDICTRESPONSE_OUTPUTENCODINGSENTRY = _descriptor.Descriptor(
+  name='OutputEncodingsEntry',
+  full_name='onnxruntime.server.PredictResponse.OutputEncodingsEntry',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='key', full_name='onnxruntime.server.PredictResponse.OutputEncodingsEntry.key', index=0,
+      number=1, type=9, cpp_type=9, label=1,
+      has_default_value=False, default_value=_b("").decode('utf-8'),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='value', full_name='onnxruntime.server.PredictResponse.OutputEncodingsEntry.value', index=1,
+      number=2, type=11, cpp_type=10, label=1,
+      has_default_value=False, default_value=None,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  serialized_options=_b('8\001'),
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=1327,
+  serialized_end=1415,
 )
 
 _PREDICTRESPONSE = _descriptor.Descriptor(
@@ -155,10 +477,24 @@ _PREDICTRESPONSE = _descriptor.Descriptor(
       message_type=None, enum_type=None, containing_type=None,
       is_extension=False, extension_scope=None,
       serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='model_version', full_name='onnxruntime.server.PredictResponse.model_version', index=1,
+      number=2, type=13, cpp_type=3, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+    _descriptor.FieldDescriptor(
+      name='output_encodings', full_name='onnxruntime.server.PredictResponse.output_encodings', index=2,
+      number=3, type=11, cpp_type=10, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
   ],
   extensions=[
   ],
-  nested_types=[_PREDICTRESPONSE_OUTPUTSENTRY, ],
+  nested_types=[_PREDICTRESPONSE_OUTPUTSENTRY, _PREDICTRESPONSE_OUTPUTENCODINGSENTRY, ],
   enum_types=[
   ],
   serialized_options=None,
@@ -167,18 +503,68 @@ _PREDICTRESPONSE = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=231,
-  serialized_end=382,
+  serialized_start=1067,
+  serialized_end=1415,
+)
+
+
+_UPDATEMODELRESPONSE = _descriptor.Descriptor(
+  name='UpdateModelResponse',
+  full_name='onnxruntime.server.UpdateModelResponse',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='model_version', full_name='onnxruntime.server.UpdateModelResponse.model_version', index=0,
+      number=1, type=13, cpp_type=3, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      serialized_options=None, file=DESCRIPTOR),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  serialized_options=None,
+  is_extendable=False,
+  syntax='proto3',
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=1417,
+  serialized_end=1461,
 )
 
 _PREDICTREQUEST_INPUTSENTRY.fields_by_name['value'].message_type = onnx__ml__pb2._TENSORPROTO
 _PREDICTREQUEST_INPUTSENTRY.containing_type = _PREDICTREQUEST
+_PREDICTREQUEST_POSTPROCESSINGENTRY.fields_by_name['value'].message_type = _POSTPROCESSING
+_PREDICTREQUEST_POSTPROCESSINGENTRY.containing_type = _PREDICTREQUEST
+_PREDICTREQUEST_INPUTENCODINGSENTRY.fields_by_name['value'].message_type = _WIREENCODING
+_PREDICTREQUEST_INPUTENCODINGSENTRY.containing_type = _PREDICTREQUEST
+_PREDICTREQUEST_OUTPUTENCODINGSENTRY.fields_by_name['value'].message_type = _WIREENCODING
+_PREDICTREQUEST_OUTPUTENCODINGSENTRY.containing_type = _PREDICTREQUEST
 _PREDICTREQUEST.fields_by_name['inputs'].message_type = _PREDICTREQUEST_INPUTSENTRY
+_PREDICTREQUEST.fields_by_name['post_processing'].message_type = _PREDICTREQUEST_POSTPROCESSINGENTRY
+_PREDICTREQUEST.fields_by_name['input_encodings'].message_type = _PREDICTREQUEST_INPUTENCODINGSENTRY
+_PREDICTREQUEST.fields_by_name['output_encodings'].message_type = _PREDICTREQUEST_OUTPUTENCODINGSENTRY
+_WIREENCODING.fields_by_name['type'].enum_type = _WIREENCODING_TYPE
+_WIREENCODING_TYPE.containing_type = _WIREENCODING
+_POSTPROCESSING.fields_by_name['type'].enum_type = _POSTPROCESSING_TYPE
+_POSTPROCESSING_TYPE.containing_type = _POSTPROCESSING
 _PREDICTRESPONSE_OUTPUTSENTRY.fields_by_name['value'].message_type = onnx__ml__pb2._TENSORPROTO
 _PREDICTRESPONSE_OUTPUTSENTRY.containing_type = _PREDICTRESPONSE
+_PREDICTRESPONSE_OUTPUTENCODINGSENTRY.fields_by_name['value'].message_type = _WIREENCODING
+_PREDICTRESPONSE_OUTPUTENCODINGSENTRY.containing_type = _PREDICTRESPONSE
 _PREDICTRESPONSE.fields_by_name['outputs'].message_type = _PREDICTRESPONSE_OUTPUTSENTRY
+_PREDICTRESPONSE.fields_by_name['output_encodings'].message_type = _PREDICTRESPONSE_OUTPUTENCODINGSENTRY
 DESCRIPTOR.message_types_by_name['PredictRequest'] = _PREDICTREQUEST
+DESCRIPTOR.message_types_by_name['WireEncoding'] = _WIREENCODING
+DESCRIPTOR.message_types_by_name['PostProcessing'] = _POSTPROCESSING
 DESCRIPTOR.message_types_by_name['PredictResponse'] = _PREDICTRESPONSE
+DESCRIPTOR.message_types_by_name['UpdateModelResponse'] = _UPDATEMODELRESPONSE
 _sym_db.RegisterFileDescriptor(DESCRIPTOR)
 
 PredictRequest = _reflection.GeneratedProtocolMessageType('PredictRequest', (_message.Message,), dict(
@@ -189,12 +575,50 @@ PredictRequest = _reflection.GeneratedProtocolMessageType('PredictRequest', (_me
     # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictRequest.InputsEntry)
     ))
   ,
+
+  PostProcessingEntry = _reflection.GeneratedProtocolMessageType('PostProcessingEntry', (_message.Message,), dict(
+    DESCRIPTOR = _PREDICTREQUEST_POSTPROCESSINGENTRY,
+    __module__ = 'predict_pb2'
+    # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictRequest.PostProcessingEntry)
+    ))
+  ,
+
+  InputEncodingsEntry = _reflection.GeneratedProtocolMessageType('InputEncodingsEntry', (_message.Message,), dict(
+    DESCRIPTOR = _PREDICTREQUEST_INPUTENCODINGSENTRY,
+    __module__ = 'predict_pb2'
+    # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictRequest.InputEncodingsEntry)
+    ))
+  ,
+
+  OutputEncodingsEntry = _reflection.GeneratedProtocolMessageType('OutputEncodingsEntry', (_message.Message,), dict(
+    DESCRIPTOR = _PREDICTREQUEST_OUTPUTENCODINGSENTRY,
+    __module__ = 'predict_pb2'
+    # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictRequest.OutputEncodingsEntry)
+    ))
+  ,
   DESCRIPTOR = _PREDICTREQUEST,
   __module__ = 'predict_pb2'
   # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictRequest)
   ))
 _sym_db.RegisterMessage(PredictRequest)
 _sym_db.RegisterMessage(PredictRequest.InputsEntry)
+_sym_db.RegisterMessage(PredictRequest.PostProcessingEntry)
+_sym_db.RegisterMessage(PredictRequest.InputEncodingsEntry)
+_sym_db.RegisterMessage(PredictRequest.OutputEncodingsEntry)
+
+WireEncoding = _reflection.GeneratedProtocolMessageType('WireEncoding', (_message.Message,), dict(
+  DESCRIPTOR = _WIREENCODING,
+  __module__ = 'predict_pb2'
+  # @@protoc_insertion_point(class_scope:onnxruntime.server.WireEncoding)
+  ))
+_sym_db.RegisterMessage(WireEncoding)
+
+PostProcessing = _reflection.GeneratedProtocolMessageType('PostProcessing', (_message.Message,), dict(
+  DESCRIPTOR = _POSTPROCESSING,
+  __module__ = 'predict_pb2'
+  # @@protoc_insertion_point(class_scope:onnxruntime.server.PostProcessing)
+  ))
+_sym_db.RegisterMessage(PostProcessing)
 
 PredictResponse = _reflection.GeneratedProtocolMessageType('PredictResponse', (_message.Message,), dict(
 
@@ -204,14 +628,33 @@ PredictResponse = _reflection.GeneratedProtocolMessageType('PredictResponse', (_
     # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictResponse.OutputsEntry)
     ))
   ,
+
+  OutputEncodingsEntry = _reflection.GeneratedProtocolMessageType('OutputEncodingsEntry', (_message.Message,), dict(
+    DESCRIPTOR = _PREDICTRESPONSE_OUTPUTENCODINGSENTRY,
+    __module__ = 'predict_pb2'
+    # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictResponse.OutputEncodingsEntry)
+    ))
+  ,
   DESCRIPTOR = _PREDICTRESPONSE,
   __module__ = 'predict_pb2'
   # @@protoc_insertion_point(class_scope:onnxruntime.server.PredictResponse)
   ))
 _sym_db.RegisterMessage(PredictResponse)
 _sym_db.RegisterMessage(PredictResponse.OutputsEntry)
+_sym_db.RegisterMessage(PredictResponse.OutputEncodingsEntry)
+
+UpdateModelResponse = _reflection.GeneratedProtocolMessageType('UpdateModelResponse', (_message.Message,), dict(
+  DESCRIPTOR = _UPDATEMODELRESPONSE,
+  __module__ = 'predict_pb2'
+  # @@protoc_insertion_point(class_scope:onnxruntime.server.UpdateModelResponse)
+  ))
+_sym_db.RegisterMessage(UpdateModelResponse)
 
 
 _PREDICTREQUEST_INPUTSENTRY._options = None
+_PREDICTREQUEST_POSTPROCESSINGENTRY._options = None
+_PREDICTREQUEST_INPUTENCODINGSENTRY._options = None
+_PREDICTREQUEST_OUTPUTENCODINGSENTRY._options = None
 _PREDICTRESPONSE_OUTPUTSENTRY._options = None
+_PREDICTRESPONSE_OUTPUTENCODINGSENTRY._options = None
 # @@protoc_insertion_point(module_scope)
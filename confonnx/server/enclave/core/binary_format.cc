@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "onnx_protobuf.h"
+#include "binary_format.h"
+
+namespace onnxruntime {
+namespace server {
+
+namespace protobufutil = google::protobuf::util;
+
+// Size of one element, or 0 for types the binary format does not support.
+static size_t ElementSize(int32_t data_type) {
+  switch (data_type) {
+    case onnx::TensorProto_DataType_UINT8:
+    case onnx::TensorProto_DataType_INT8:
+    case onnx::TensorProto_DataType_BOOL:
+      return 1;
+    case onnx::TensorProto_DataType_UINT16:
+    case onnx::TensorProto_DataType_INT16:
+    case onnx::TensorProto_DataType_FLOAT16:
+    case onnx::TensorProto_DataType_BFLOAT16:
+      return 2;
+    case onnx::TensorProto_DataType_FLOAT:
+    case onnx::TensorProto_DataType_INT32:
+    case onnx::TensorProto_DataType_UINT32:
+      return 4;
+    case onnx::TensorProto_DataType_DOUBLE:
+    case onnx::TensorProto_DataType_INT64:
+    case onnx::TensorProto_DataType_UINT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+static size_t AlignUp(size_t offset) {
+  return (offset + kBinaryFormatAlignment - 1) / kBinaryFormatAlignment * kBinaryFormatAlignment;
+}
+
+static protobufutil::Status InvalidMessage(const std::string& message) {
+  return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Invalid binary message: " + message);
+}
+
+protobufutil::Status ParseBinaryMessage(uint8_t* message, size_t size,
+                                        /* out */ std::vector<BinaryTensorView>& tensors) {
+  if (size < sizeof(BinaryFormatHeader)) {
+    return InvalidMessage("truncated header");
+  }
+  const auto* header = reinterpret_cast<const BinaryFormatHeader*>(message);
+  if (header->magic != kBinaryFormatMagic) {
+    return InvalidMessage("bad magic");
+  }
+  if (header->version != kBinaryFormatVersion) {
+    return InvalidMessage("unsupported version " + std::to_string(header->version));
+  }
+  size_t descriptors_end = sizeof(BinaryFormatHeader) + header->tensor_count * sizeof(BinaryFormatTensorDescriptor);
+  if (size < descriptors_end) {
+    return InvalidMessage("truncated tensor descriptors");
+  }
+
+  const auto* descriptors = reinterpret_cast<const BinaryFormatTensorDescriptor*>(message + sizeof(BinaryFormatHeader));
+  tensors.clear();
+  tensors.reserve(header->tensor_count);
+  for (size_t i = 0; i < header->tensor_count; i++) {
+    const BinaryFormatTensorDescriptor& desc = descriptors[i];
+    if (desc.name_offset < descriptors_end || desc.name_offset > size || desc.name_length > size - desc.name_offset) {
+      return InvalidMessage("tensor name out of bounds");
+    }
+    size_t element_size = ElementSize(desc.data_type);
+    if (element_size == 0) {
+      return InvalidMessage("unsupported data type " + std::to_string(desc.data_type));
+    }
+    if (desc.rank > kBinaryFormatMaxRank) {
+      return InvalidMessage("rank exceeds " + std::to_string(kBinaryFormatMaxRank));
+    }
+    uint64_t element_count = 1;
+    for (size_t d = 0; d < desc.rank; d++) {
+      if (desc.dims[d] < 0) {
+        return InvalidMessage("negative dimension");
+      }
+      if (desc.dims[d] != 0 && element_count > UINT64_MAX / element_size / static_cast<uint64_t>(desc.dims[d])) {
+        return InvalidMessage("tensor too large");
+      }
+      element_count *= static_cast<uint64_t>(desc.dims[d]);
+    }
+    if (desc.data_offset % kBinaryFormatAlignment != 0) {
+      return InvalidMessage("misaligned tensor data");
+    }
+    if (desc.data_offset < descriptors_end || desc.data_offset > size || desc.data_length > size - desc.data_offset) {
+      return InvalidMessage("tensor data out of bounds");
+    }
+    if (desc.data_length != element_count * element_size) {
+      return InvalidMessage("tensor data length does not match dimensions");
+    }
+
+    BinaryTensorView view;
+    view.name = reinterpret_cast<const char*>(message + desc.name_offset);
+    view.name_length = desc.name_length;
+    // ONNX Runtime uses the same numbering as onnx::TensorProto_DataType.
+    view.element_type = static_cast<ONNXTensorElementDataType>(desc.data_type);
+    view.dims = desc.dims;
+    view.rank = desc.rank;
+    view.data = message + desc.data_offset;
+    view.data_length = desc.data_length;
+    tensors.push_back(view);
+  }
+
+  // Tensor data is bound as mutable input, so no two tensors may share bytes.
+  std::vector<std::pair<size_t, size_t>> data_ranges;
+  data_ranges.reserve(tensors.size());
+  for (const BinaryTensorView& view : tensors) {
+    if (view.data_length > 0) {
+      size_t offset = static_cast<uint8_t*>(view.data) - message;
+      data_ranges.emplace_back(offset, offset + view.data_length);
+    }
+  }
+  std::sort(data_ranges.begin(), data_ranges.end());
+  for (size_t i = 1; i < data_ranges.size(); i++) {
+    if (data_ranges[i].first < data_ranges[i - 1].second) {
+      return InvalidMessage("overlapping tensor data");
+    }
+  }
+
+  return protobufutil::Status::OK;
+}
+
+protobufutil::Status WriteBinaryMessage(const std::vector<const char*>& names,
+                                        std::vector<Ort::Value>& values,
+                                        uint32_t model_version,
+                                        /* out */ std::vector<uint8_t>& message) {
+  if (values.size() > UINT16_MAX) {
+    return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Too many outputs for binary format");
+  }
+
+  // First pass: layout
+  std::vector<BinaryFormatTensorDescriptor> descriptors(values.size());
+  size_t offset = sizeof(BinaryFormatHeader) + values.size() * sizeof(BinaryFormatTensorDescriptor);
+  for (size_t i = 0; i < values.size(); i++) {
+    if (!values[i].IsTensor()) {
+      return protobufutil::Status(protobufutil::error::Code::UNIMPLEMENTED, "Don't support Non-Tensor values");
+    }
+    auto info = values[i].GetTensorTypeAndShapeInfo();
+    auto shape = info.GetShape();
+    BinaryFormatTensorDescriptor& desc = descriptors[i];
+    desc.data_type = static_cast<int32_t>(info.GetElementType());
+    size_t element_size = ElementSize(desc.data_type);
+    if (element_size == 0) {
+      return protobufutil::Status(protobufutil::error::Code::UNIMPLEMENTED,
+                                  std::string("Output type not supported by binary format: ") + names[i]);
+    }
+    if (shape.size() > kBinaryFormatMaxRank) {
+      return protobufutil::Status(protobufutil::error::Code::UNIMPLEMENTED,
+                                  std::string("Output rank not supported by binary format: ") + names[i]);
+    }
+    desc.rank = static_cast<uint32_t>(shape.size());
+    std::memset(desc.dims, 0, sizeof(desc.dims));
+    std::copy(shape.begin(), shape.end(), desc.dims);
+
+    desc.name_offset = static_cast<uint32_t>(offset);
+    desc.name_length = static_cast<uint32_t>(std::strlen(names[i]));
+    offset = AlignUp(offset + desc.name_length);
+    desc.data_offset = offset;
+    desc.data_length = info.GetElementCount() * element_size;
+    offset += desc.data_length;
+  }
+
+  // Second pass: copy
+  message.assign(offset, 0);
+  BinaryFormatHeader header{};
+  header.magic = kBinaryFormatMagic;
+  header.version = kBinaryFormatVersion;
+  header.tensor_count = static_cast<uint16_t>(values.size());
+  header.model_version = model_version;
+  std::memcpy(message.data(), &header, sizeof(header));
+  if (!descriptors.empty()) {
+    std::memcpy(message.data() + sizeof(header), descriptors.data(), descriptors.size() * sizeof(BinaryFormatTensorDescriptor));
+  }
+  for (size_t i = 0; i < values.size(); i++) {
+    const BinaryFormatTensorDescriptor& desc = descriptors[i];
+    std::memcpy(message.data() + desc.name_offset, names[i], desc.name_length);
+    if (desc.data_length > 0) {
+      std::memcpy(message.data() + desc.data_offset, values[i].GetTensorMutableData<uint8_t>(), desc.data_length);
+    }
+  }
+
+  return protobufutil::Status::OK;
+}
+
+}  // namespace server
+}  // namespace onnxruntime
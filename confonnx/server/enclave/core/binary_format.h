@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/stubs/status.h>
+
+#include "core/session/onnxruntime_cxx_api.h"
+
+namespace onnxruntime {
+namespace server {
+
+// Compact binary tensor format, used by RequestType::ScoreBinary as an
+// alternative to PredictRequest/PredictResponse. Tensors are referenced in
+// place, so a request is validated and bound without a parser.
+//
+// All integers are little-endian. A message consists of a Header, followed by
+// header.tensor_count TensorDescriptors, followed by names and tensor data at
+// the offsets given in the descriptors. Offsets are relative to the start of
+// the message, tensor data offsets are multiples of kBinaryFormatAlignment.
+// Names and data must lie after the descriptors, and the data of two tensors
+// must not overlap. Only numeric tensors are supported.
+// The Python client implements the same format in confonnx/binary_format.py.
+
+constexpr uint32_t kBinaryFormatMagic = 0x42545843;  // "CXTB"
+constexpr uint16_t kBinaryFormatVersion = 1;
+constexpr size_t kBinaryFormatMaxRank = 8;
+constexpr size_t kBinaryFormatAlignment = 64;
+
+struct BinaryFormatHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t tensor_count;
+  // Responses only: version of the model that produced the outputs.
+  uint32_t model_version;
+  uint32_t reserved;
+};
+static_assert(sizeof(BinaryFormatHeader) == 16, "unexpected header padding");
+
+struct BinaryFormatTensorDescriptor {
+  uint32_t name_offset;
+  uint32_t name_length;
+  // onnx::TensorProto_DataType
+  int32_t data_type;
+  uint32_t rank;
+  uint64_t data_offset;
+  uint64_t data_length;
+  int64_t dims[kBinaryFormatMaxRank];
+};
+static_assert(sizeof(BinaryFormatTensorDescriptor) == 96, "unexpected descriptor padding");
+
+// A tensor inside a binary message, pointing into the message buffer.
+struct BinaryTensorView {
+  const char* name;
+  size_t name_length;
+  ONNXTensorElementDataType element_type;
+  const int64_t* dims;
+  size_t rank;
+  void* data;
+  size_t data_length;
+};
+
+// Validates a binary message and returns views of its tensors.
+// The message buffer must be at least 8-byte aligned and outlive the views.
+google::protobuf::util::Status ParseBinaryMessage(uint8_t* message, size_t size,
+                                                  /* out */ std::vector<BinaryTensorView>& tensors);
+
+// Serializes numeric tensors into a binary message.
+google::protobuf::util::Status WriteBinaryMessage(const std::vector<const char*>& names,
+                                                  std::vector<Ort::Value>& values,
+                                                  uint32_t model_version,
+                                                  /* out */ std::vector<uint8_t>& message);
+
+}  // namespace server
+}  // namespace onnxruntime
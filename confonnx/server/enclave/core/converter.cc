@@ -7,6 +7,7 @@
 #include "predict_protobuf.h"
 
 #include "converter.h"
+#include "serializing/bulk_convert.h"
 #include "serializing/mem_buffer.h"
 
 namespace onnxruntime {
@@ -55,7 +56,7 @@ onnx::TensorProto_DataType MLDataTypeToTensorProtoDataType(ONNXTensorElementData
 }
 
 void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
-                          const std::shared_ptr<spdlog::logger>& logger,
+                          const RequestLogger& logger,
                           /* out */ onnx::TensorProto& tensor_proto) {
   if (!ml_value.IsTensor()) {
     throw Ort::Exception("Don't support Non-Tensor values", OrtErrorCode::ORT_NOT_IMPLEMENTED);
@@ -87,9 +88,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(float) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_float_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_float_data());
       }
       break;
     }
@@ -98,9 +97,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(int32_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -109,9 +106,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(uint8_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -120,9 +115,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(int8_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -131,9 +124,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(uint16_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -142,9 +133,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(int16_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -153,9 +142,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(bool) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -164,27 +151,17 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(onnxruntime::MLFloat16) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(reinterpret_cast<const uint16_t*>(data)[i]);
-        }
+        AppendToRepeatedField(reinterpret_cast<const uint16_t*>(data), elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
     case onnx::TensorProto_DataType_BFLOAT16: {  // Target: raw_data or int32_data
-      const auto* data = ml_value.GetTensorMutableData<onnxruntime::BFloat16>();
-
-      std::vector<uint16_t> raw_data;
-      raw_data.reserve(elem_count);
-      for (size_t i = 0; i < elem_count; ++i) {
-        raw_data.push_back(data[i].val);
-      }
-
+      static_assert(sizeof(onnxruntime::BFloat16) == sizeof(uint16_t), "unexpected BFloat16 layout");
+      const auto* data = reinterpret_cast<const uint16_t*>(ml_value.GetTensorMutableData<onnxruntime::BFloat16>());
       if (using_raw_data) {
-        tensor_proto.set_raw_data(raw_data.data(), raw_data.size() * sizeof(uint16_t));
+        tensor_proto.set_raw_data(data, sizeof(uint16_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_int32_data(raw_data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int32_data());
       }
       break;
     }
@@ -210,9 +187,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(int64_t) * elem_count);
       } else {
-        for (size_t x = 0, loop_length = elem_count; x < loop_length; ++x) {
-          tensor_proto.add_int64_data(data[x]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_int64_data());
       }
       break;
     }
@@ -221,9 +196,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(uint32_t) * elem_count);
       } else {
-        for (size_t i = 0, count = elem_count; i < count; ++i) {
-          tensor_proto.add_uint64_data(data[i]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_uint64_data());
       }
       break;
     }
@@ -232,9 +205,7 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(uint64_t) * elem_count);
       } else {
-        for (size_t x = 0, loop_length = elem_count; x < loop_length; ++x) {
-          tensor_proto.add_uint64_data(data[x]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_uint64_data());
       }
       break;
     }
@@ -243,14 +214,12 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
       if (using_raw_data) {
         tensor_proto.set_raw_data(data, sizeof(double) * elem_count);
       } else {
-        for (size_t x = 0, loop_length = elem_count; x < loop_length; ++x) {
-          tensor_proto.add_double_data(data[x]);
-        }
+        AppendToRepeatedField(data, elem_count, tensor_proto.mutable_double_data());
       }
       break;
     }
     default: {
-      logger->error("Unsupported TensorProto DataType: {}", data_type);
+      logger.error("Unsupported TensorProto DataType: {}", data_type);
       std::ostringstream ostr;
       ostr << "Initialized tensor with unexpected type: " << tensor_proto.data_type();
       throw Ort::Exception(ostr.str(), OrtErrorCode::ORT_INVALID_ARGUMENT);
@@ -260,4 +229,4 @@ void MLValueToTensorProto(Ort::Value& ml_value, bool using_raw_data,
   return;
 }
 }  // namespace server
-}  // namespace onnxruntime
\ No newline at end of file
+}  // namespace onnxruntime
\ No newline at end of file
@@ -0,0 +1,243 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "encoding.h"
+
+namespace onnxruntime {
+namespace server {
+
+// The conversion kernels below are branch-light loops over plain arrays
+// so that the compiler can vectorize them for the enclave target.
+
+static inline uint32_t FloatBits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static inline float BitsFloat(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// IEEE half to float, including subnormals, infinities and NaNs.
+static inline float HalfToFloat(uint16_t h) {
+  const uint32_t shifted_exp = 0x7c00u << 13;
+  uint32_t o = (h & 0x7fffu) << 13;
+  uint32_t exp = shifted_exp & o;
+  o += (127 - 15) << 23;
+  if (exp == shifted_exp) {
+    // Infinity or NaN
+    o += (128 - 16) << 23;
+  } else if (exp == 0) {
+    // Zero or subnormal, renormalize
+    o += 1 << 23;
+    o = FloatBits(BitsFloat(o) - BitsFloat(113 << 23));
+  }
+  return BitsFloat(o | (static_cast<uint32_t>(h & 0x8000u) << 16));
+}
+
+// Float to IEEE half with round-to-nearest-even.
+static inline uint16_t FloatToHalf(float value) {
+  const uint32_t f32_infinity = 255u << 23;
+  const uint32_t f16_max = (127u + 16) << 23;
+  const uint32_t denorm_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+  uint32_t f = FloatBits(value);
+  const uint32_t sign = f & 0x80000000u;
+  f ^= sign;
+  uint16_t o;
+  if (f >= f16_max) {
+    // Overflow to infinity, keep NaN
+    o = f > f32_infinity ? 0x7e00 : 0x7c00;
+  } else if (f < (113u << 23)) {
+    // Subnormal or zero
+    o = static_cast<uint16_t>(FloatBits(BitsFloat(f) + BitsFloat(denorm_magic)) - denorm_magic);
+  } else {
+    uint32_t mant_odd = (f >> 13) & 1;
+    f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+    f += mant_odd;
+    o = static_cast<uint16_t>(f >> 13);
+  }
+  return o | static_cast<uint16_t>(sign >> 16);
+}
+
+static inline float BFloat16ToFloat(uint16_t b) {
+  return BitsFloat(static_cast<uint32_t>(b) << 16);
+}
+
+// Float to bfloat16 with round-to-nearest-even.
+static inline uint16_t FloatToBFloat16(float value) {
+  uint32_t f = FloatBits(value);
+  if ((f & 0x7fffffffu) > 0x7f800000u) {
+    // Quiet NaN
+    return static_cast<uint16_t>((f >> 16) | 0x40);
+  }
+  f += 0x7fff + ((f >> 16) & 1);
+  return static_cast<uint16_t>(f >> 16);
+}
+
+static onnx::TensorProto_DataType EncodingDataType(WireEncoding::Type type) {
+  switch (type) {
+    case WireEncoding::FLOAT16:
+      return onnx::TensorProto_DataType_FLOAT16;
+    case WireEncoding::BFLOAT16:
+      return onnx::TensorProto_DataType_BFLOAT16;
+    case WireEncoding::INT8:
+      return onnx::TensorProto_DataType_INT8;
+    default:
+      throw Ort::Exception("Unsupported wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+// Gives access to the encoded elements, either in raw_data or in int32_data.
+template <typename T>
+class EncodedElements {
+ public:
+  EncodedElements(const onnx::TensorProto& tensor_proto, size_t count) : tensor_proto_(tensor_proto) {
+    CheckCount(tensor_proto, count);
+    if (tensor_proto.has_raw_data()) {
+      raw_ = reinterpret_cast<const T*>(tensor_proto.raw_data().data());
+    }
+  }
+
+  static void CheckCount(const onnx::TensorProto& tensor_proto, size_t count) {
+    if (tensor_proto.has_raw_data()) {
+      // Divide instead of multiplying count, which comes from the client and may overflow.
+      size_t size = tensor_proto.raw_data().size();
+      if (size % sizeof(T) != 0 || size / sizeof(T) != count) {
+        throw Ort::Exception("Encoded raw data does not match the tensor dimensions", OrtErrorCode::ORT_INVALID_ARGUMENT);
+      }
+    } else if (static_cast<size_t>(tensor_proto.int32_data_size()) != count) {
+      throw Ort::Exception("Encoded data does not match the tensor dimensions", OrtErrorCode::ORT_INVALID_ARGUMENT);
+    }
+  }
+
+  template <typename F>
+  void ForEach(F&& f, float* out, size_t count) const {
+    if (raw_ != nullptr) {
+      for (size_t i = 0; i < count; i++) {
+        out[i] = f(raw_[i]);
+      }
+    } else {
+      const int32_t* data = tensor_proto_.int32_data().data();
+      for (size_t i = 0; i < count; i++) {
+        out[i] = f(static_cast<T>(data[i]));
+      }
+    }
+  }
+
+ private:
+  const onnx::TensorProto& tensor_proto_;
+  const T* raw_ = nullptr;
+};
+
+void CheckEncodedTensor(const WireEncoding& encoding, const onnx::TensorProto& tensor_proto, size_t count) {
+  if (tensor_proto.data_type() != EncodingDataType(encoding.type())) {
+    throw Ort::Exception("Tensor data type does not match its wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+  switch (encoding.type()) {
+    case WireEncoding::FLOAT16:
+    case WireEncoding::BFLOAT16:
+      EncodedElements<uint16_t>::CheckCount(tensor_proto, count);
+      break;
+    case WireEncoding::INT8:
+      EncodedElements<int8_t>::CheckCount(tensor_proto, count);
+      break;
+    default:
+      throw Ort::Exception("Unsupported wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+void DecodeFloatTensor(const WireEncoding& encoding, const onnx::TensorProto& tensor_proto,
+                       /* out */ float* data, size_t count) {
+  if (tensor_proto.data_type() != EncodingDataType(encoding.type())) {
+    throw Ort::Exception("Tensor data type does not match its wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+  switch (encoding.type()) {
+    case WireEncoding::FLOAT16:
+      EncodedElements<uint16_t>(tensor_proto, count).ForEach(HalfToFloat, data, count);
+      break;
+    case WireEncoding::BFLOAT16:
+      EncodedElements<uint16_t>(tensor_proto, count).ForEach(BFloat16ToFloat, data, count);
+      break;
+    case WireEncoding::INT8: {
+      const float scale = encoding.scale();
+      const float zero_point = static_cast<float>(encoding.zero_point());
+      auto dequantize = [scale, zero_point](int8_t q) { return scale * (static_cast<float>(q) - zero_point); };
+      EncodedElements<int8_t>(tensor_proto, count).ForEach(dequantize, data, count);
+      break;
+    }
+    default:
+      throw Ort::Exception("Unsupported wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+void EncodeFloatTensor(Ort::Value& ml_value,
+                       /* in/out */ WireEncoding& encoding,
+                       /* out */ onnx::TensorProto& tensor_proto) {
+  if (!ml_value.IsTensor()) {
+    throw Ort::Exception("Don't support Non-Tensor values", OrtErrorCode::ORT_NOT_IMPLEMENTED);
+  }
+  const auto& shape = ml_value.GetTensorTypeAndShapeInfo();
+  if (shape.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+    throw Ort::Exception("Wire encodings require a float output", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+
+  for (const auto& dim : shape.GetShape()) {
+    tensor_proto.add_dims(dim);
+  }
+  tensor_proto.set_data_type(EncodingDataType(encoding.type()));
+
+  const size_t count = shape.GetElementCount();
+  const float* data = ml_value.GetTensorMutableData<float>();
+  std::string* raw_data = tensor_proto.mutable_raw_data();
+
+  switch (encoding.type()) {
+    case WireEncoding::FLOAT16: {
+      raw_data->resize(count * sizeof(uint16_t));
+      auto* out = reinterpret_cast<uint16_t*>(&(*raw_data)[0]);
+      for (size_t i = 0; i < count; i++) {
+        out[i] = FloatToHalf(data[i]);
+      }
+      break;
+    }
+    case WireEncoding::BFLOAT16: {
+      raw_data->resize(count * sizeof(uint16_t));
+      auto* out = reinterpret_cast<uint16_t*>(&(*raw_data)[0]);
+      for (size_t i = 0; i < count; i++) {
+        out[i] = FloatToBFloat16(data[i]);
+      }
+      break;
+    }
+    case WireEncoding::INT8: {
+      if (encoding.scale() == 0) {
+        float max_abs = 0;
+        for (size_t i = 0; i < count; i++) {
+          max_abs = std::max(max_abs, std::fabs(data[i]));
+        }
+        encoding.set_scale(max_abs > 0 ? max_abs / 127 : 1);
+        encoding.set_zero_point(0);
+      }
+      const float inv_scale = 1 / encoding.scale();
+      const float zero_point = static_cast<float>(encoding.zero_point());
+      raw_data->resize(count * sizeof(int8_t));
+      auto* out = reinterpret_cast<int8_t*>(&(*raw_data)[0]);
+      for (size_t i = 0; i < count; i++) {
+        float q = std::nearbyint(data[i] * inv_scale + zero_point);
+        out[i] = static_cast<int8_t>(std::min(127.0f, std::max(-128.0f, q)));
+      }
+      break;
+    }
+    default:
+      throw Ort::Exception("Unsupported wire encoding", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace server
+}  // namespace onnxruntime
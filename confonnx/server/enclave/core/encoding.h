@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+#include "core/session/onnxruntime_cxx_api.h"
+
+#include "onnx_protobuf.h"
+#include "predict_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+
+// Checks that the tensor has the data type of the encoding and that its encoded
+// data holds exactly count elements, so that callers can size buffers safely.
+// Throws Ort::Exception on mismatches.
+void CheckEncodedTensor(const WireEncoding& encoding, const onnx::TensorProto& tensor_proto, size_t count);
+
+// Decodes an encoded tensor into count floats.
+// The tensor must have the data type of the encoding and exactly count elements.
+// Throws Ort::Exception on mismatches.
+void DecodeFloatTensor(const WireEncoding& encoding, const onnx::TensorProto& tensor_proto,
+                       /* out */ float* data, size_t count);
+
+// Converts a float tensor to TensorProto using the given encoding.
+// For INT8 with a scale of 0, the scale is derived from the data
+// and stored in encoding.
+// Throws Ort::Exception if the value is not a float tensor.
+void EncodeFloatTensor(Ort::Value& ml_value,
+                       /* in/out */ WireEncoding& encoding,
+                       /* out */ onnx::TensorProto& tensor_proto);
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -35,13 +35,38 @@ void ORT_API_CALL Log(void* param, OrtLoggingLevel severity, const char* categor
   return;
 }
 
+Model::Model(Ort::Session&& ort_session, uint32_t model_version) : session(std::move(ort_session)),
+                                                                   plan(session),
+                                                                   version(model_version) {
+}
+
+std::unique_ptr<std::vector<Ort::Value>> Model::TakeOutputBuffers() const {
+  {
+    std::lock_guard<std::mutex> lock(output_buffers_mutex_);
+    if (!output_buffers_.empty()) {
+      auto buffers = std::move(output_buffers_.back());
+      output_buffers_.pop_back();
+      return buffers;
+    }
+  }
+  auto buffers = std::make_unique<std::vector<Ort::Value>>();
+  Ort::AllocatorWithDefaultOptions allocator;
+  for (const auto& output : plan.GetOutputs()) {
+    buffers->push_back(Ort::Value::CreateTensor(allocator, output.shape.data(), output.shape.size(), output.element_type));
+  }
+  return buffers;
+}
+
+void Model::ReturnOutputBuffers(std::unique_ptr<std::vector<Ort::Value>> buffers) const {
+  std::lock_guard<std::mutex> lock(output_buffers_mutex_);
+  output_buffers_.push_back(std::move(buffers));
+}
+
 ServerEnvironment::ServerEnvironment(OrtLoggingLevel severity, spdlog::sinks_init_list sink,
                                      std::unique_ptr<confmsg::KeyProvider>&& model_key_provider) : severity_(severity),
                                                                                                    logger_id_("ServerApp"),
-                                                                                                   sink_(sink),
                                                                                                    default_logger_(std::make_shared<spdlog::logger>(logger_id_, sink)),
                                                                                                    runtime_environment_(severity, logger_id_.c_str(), Log, default_logger_.get()),
-                                                                                                   session(nullptr),
                                                                                                    model_key_provider_(std::move(model_key_provider)) {
   spdlog::set_automatic_registration(false);
   spdlog::set_level(Convert(severity_));
@@ -53,15 +78,72 @@ void ServerEnvironment::SetEncryptedModel(const uint8_t* model_data, size_t mode
 }
 
 void ServerEnvironment::InitializeModel(std::unique_ptr<confmsg::KeyProvider>&& model_key_provider) {
-  if (!model_output_names_.empty()) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  if (GetModel() != nullptr) {
     throw ModelAlreadyInitializedError();
   }
   model_key_provider_ = std::move(model_key_provider);
-  InitializeModel(encrypted_model_.data(), encrypted_model_.size());
+  SetModel(LoadModel(encrypted_model_.data(), encrypted_model_.size(), std::vector<uint8_t>(IV_SIZE, 0), confmsg::CBuffer(), 1));
   encrypted_model_.clear();
 }
 
 void ServerEnvironment::InitializeModel(const uint8_t* model_data, size_t model_data_length) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  SetModel(LoadModel(model_data, model_data_length, std::vector<uint8_t>(IV_SIZE, 0), confmsg::CBuffer(), 1));
+}
+
+uint32_t ServerEnvironment::UpdateModel(const uint8_t* model_data, size_t model_data_length,
+                                        const std::function<void(const Model&)>& on_updated) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  if (model_key_provider_ == nullptr) {
+    // Without a model key there is nothing to authenticate the update with.
+    throw ModelUpdateError("Model updates require an encrypted model");
+  }
+  auto current = GetModel();
+  if (current == nullptr) {
+    throw ModelUpdateError("Model not initialized yet");
+  }
+
+  // Unlike the initial model, updates carry the version and a random IV in
+  // front of the ciphertext as the model key is reused for every version.
+  // The version is the additional authenticated data of the encryption.
+  const size_t version_size = sizeof(uint32_t);
+  if (model_data_length <= version_size + IV_SIZE) {
+    throw ModelUpdateError("Not enough encrypted model data");
+  }
+  confmsg::CBuffer version_data(model_data, version_size);
+  uint32_t version = (uint32_t(model_data[0]) << 24) | (uint32_t(model_data[1]) << 16) |
+                     (uint32_t(model_data[2]) << 8) | uint32_t(model_data[3]);
+  if (version <= current->version) {
+    throw ModelUpdateError("Model version " + std::to_string(version) +
+                           " is not newer than the current version " + std::to_string(current->version));
+  }
+  const uint8_t* iv_data = model_data + version_size;
+  std::vector<uint8_t> iv(iv_data, iv_data + IV_SIZE);
+
+  // The current model stays active while the new one is loaded.
+  // Requests that already hold the old model finish on it, the last one frees it.
+  const size_t header_size = version_size + IV_SIZE;
+  std::shared_ptr<const Model> updated = LoadModel(model_data + header_size, model_data_length - header_size,
+                                                   iv, version_data, version);
+
+  // The service identifier is switched before the model is published and under
+  // the same lock, so that a client which attested against the new identifier
+  // cannot have its request served by the old model.
+  std::shared_ptr<const Model> previous;
+  {
+    std::lock_guard<std::mutex> model_lock(model_mutex_);
+    on_updated(*updated);
+    previous = std::move(model_);
+    model_ = updated;
+  }
+  // The previous model is released outside of the lock.
+  return updated->version;
+}
+
+std::unique_ptr<Model> ServerEnvironment::LoadModel(const uint8_t* model_data, size_t model_data_length,
+                                                   const std::vector<uint8_t>& iv, const confmsg::CBuffer& additional_data,
+                                                   uint32_t version) {
   Ort::SessionOptions sess_opts;
   // TODO Allow customization of threading options.
   //      For now, every inference request runs sequentially, while multiple
@@ -71,46 +153,39 @@ void ServerEnvironment::InitializeModel(const uint8_t* model_data, size_t model_
   // sess_opts.SetExecutionMode(ORT_PARALLEL);
 
   if (model_key_provider_ == nullptr) {
-    session = Ort::Session(runtime_environment_, model_data, model_data_length, std::move(sess_opts));
-  } else {
-    if (model_data_length <= TAG_SIZE) {
-      throw std::runtime_error("Not enough encrypted model data");
-    }
+    Ort::Session session(runtime_environment_, model_data, model_data_length, std::move(sess_opts));
+    return std::unique_ptr<Model>(new Model(std::move(session), version));
+  }
 
-    std::vector<uint8_t> iv(IV_SIZE, 0);
-    confmsg::CBuffer cipher((const uint8_t*)model_data, model_data_length - TAG_SIZE);
-    confmsg::CBuffer tag((const uint8_t*)(model_data) + model_data_length - TAG_SIZE, TAG_SIZE);
-    std::vector<uint8_t> plain(cipher.n, 0);
-    confmsg::internal::Decrypt(model_key_provider_->GetCurrentKey(), iv, tag, cipher, confmsg::CBuffer(), plain);
-    session = Ort::Session(runtime_environment_, plain.data(), plain.size(), std::move(sess_opts));
+  if (model_data_length <= TAG_SIZE) {
+    throw std::runtime_error("Not enough encrypted model data");
   }
 
-  auto output_count = session.GetOutputCount();
+  confmsg::CBuffer cipher((const uint8_t*)model_data, model_data_length - TAG_SIZE);
+  confmsg::CBuffer tag((const uint8_t*)(model_data) + model_data_length - TAG_SIZE, TAG_SIZE);
+  std::vector<uint8_t> plain(cipher.n, 0);
+  confmsg::internal::Decrypt(model_key_provider_->GetCurrentKey(), iv, tag, cipher, additional_data, plain);
+  Ort::Session session(runtime_environment_, plain.data(), plain.size(), std::move(sess_opts));
+  return std::unique_ptr<Model>(new Model(std::move(session), version));
+}
 
-  Ort::AllocatorWithDefaultOptions allocator;
-  for (size_t i = 0; i < output_count; i++) {
-    auto name = session.GetOutputName(i, allocator);
-    model_output_names_.push_back(name);
-    allocator.Free(name);
-  }
+void ServerEnvironment::SetModel(std::shared_ptr<const Model> model) {
+  std::lock_guard<std::mutex> lock(model_mutex_);
+  model_.swap(model);
+  // The previous model, if any, is released outside of the lock.
 }
 
-const std::vector<std::string>& ServerEnvironment::GetModelOutputNames() const {
-  return model_output_names_;
+std::shared_ptr<const Model> ServerEnvironment::GetModel() const {
+  std::lock_guard<std::mutex> lock(model_mutex_);
+  return model_;
 }
 
 OrtLoggingLevel ServerEnvironment::GetLogSeverity() const {
   return severity_;
 }
 
-const Ort::Session& ServerEnvironment::GetSession() const {
-  return session;
-}
-
-std::shared_ptr<spdlog::logger> ServerEnvironment::GetLogger(const std::string& request_id) const {
-  auto logger = std::make_shared<spdlog::logger>(request_id, sink_.begin(), sink_.end());
-  spdlog::initialize_logger(logger);
-  return logger;
+RequestLogger ServerEnvironment::GetLogger(const char* request_id) const {
+  return RequestLogger(default_logger_.get(), request_id);
 }
 
 std::shared_ptr<spdlog::logger> ServerEnvironment::GetAppLogger() const {
@@ -3,17 +3,41 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "core/session/onnxruntime_cxx_api.h"
 #include <spdlog/spdlog.h>
 
 #include "confmsg/shared/keyprovider.h"
+#include "server/shared/request_logger.h"
+#include "inference_plan.h"
 
 namespace onnxruntime {
 namespace server {
 
+// A loaded model version. Requests keep a reference for the duration of
+// inference, so a replaced model is only freed once its requests drained.
+struct Model {
+  Model(Ort::Session&& ort_session, uint32_t model_version);
+
+  // Output tensors of a model with static output shapes, reused across requests.
+  // A set is used by one request at a time. Sets are freed together with the
+  // model, so that a replaced model does not leave buffers behind.
+  std::unique_ptr<std::vector<Ort::Value>> TakeOutputBuffers() const;
+  void ReturnOutputBuffers(std::unique_ptr<std::vector<Ort::Value>> buffers) const;
+
+  Ort::Session session;
+  const InferencePlan plan;
+  const uint32_t version;
+
+ private:
+  mutable std::mutex output_buffers_mutex_;  // guards output_buffers_
+  mutable std::vector<std::unique_ptr<std::vector<Ort::Value>>> output_buffers_;
+};
+
 class ServerEnvironment {
  public:
   explicit ServerEnvironment(OrtLoggingLevel severity, spdlog::sinks_init_list sink, std::unique_ptr<confmsg::KeyProvider>&& model_key_provider);
@@ -22,27 +46,45 @@ class ServerEnvironment {
 
   OrtLoggingLevel GetLogSeverity() const;
 
-  const Ort::Session& GetSession() const;
+  // Returns the currently active model, or nullptr if none is loaded yet.
+  std::shared_ptr<const Model> GetModel() const;
   void InitializeModel(const uint8_t* model_data, size_t model_data_length);
   void InitializeModel(std::unique_ptr<confmsg::KeyProvider>&& model_key_provider);
   void SetEncryptedModel(const uint8_t* model_data, size_t model_data_length);
-  const std::vector<std::string>& GetModelOutputNames() const;
-  std::shared_ptr<spdlog::logger> GetLogger(const std::string& request_id) const;
+  // Loads a new model encrypted with the model key (version || IV || ciphertext || tag)
+  // next to the current one and atomically switches to it. The big-endian uint32
+  // version is authenticated together with the model and must be greater than the
+  // current version, so that earlier updates cannot be replayed to roll back the model.
+  // on_updated is called right before the switch, serialized with other updates and
+  // with GetModel(), which it must not call. The version check only covers the
+  // lifetime of the enclave: after a restart the initial model is active again
+  // and any earlier update is accepted.
+  // Returns the new model version.
+  uint32_t UpdateModel(const uint8_t* model_data, size_t model_data_length,
+                       const std::function<void(const Model&)>& on_updated);
+  // request_id must outlive the returned logger.
+  RequestLogger GetLogger(const char* request_id) const;
   std::shared_ptr<spdlog::logger> GetAppLogger() const;
 
  private:
   const OrtLoggingLevel severity_;
   const std::string logger_id_;
-  const std::vector<spdlog::sink_ptr> sink_;
   const std::shared_ptr<spdlog::logger> default_logger_;
 
   Ort::Env runtime_environment_;
   Ort::SessionOptions options_;
-  Ort::Session session;
-  std::vector<std::string> model_output_names_;
+
+  mutable std::mutex model_mutex_;  // guards model_
+  std::shared_ptr<const Model> model_;
+  std::mutex update_mutex_;  // serializes model loading
   std::vector<uint8_t> encrypted_model_;  // only kept while model key not provisioned yet
 
   std::unique_ptr<confmsg::KeyProvider> model_key_provider_;
+
+  std::unique_ptr<Model> LoadModel(const uint8_t* model_data, size_t model_data_length,
+                                   const std::vector<uint8_t>& iv, const confmsg::CBuffer& additional_data,
+                                   uint32_t version);
+  void SetModel(std::shared_ptr<const Model> model);
 };
 
 }  // namespace server
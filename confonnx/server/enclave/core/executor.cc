@@ -3,6 +3,7 @@
 
 #include <cstdio>
 #include "core/common/logging/logging.h"
+#include "core/framework/allocator.h"
 #include "core/framework/data_types.h"
 #include "core/session/environment.h"
 #include "core/framework/framework_common.h"
@@ -15,7 +16,12 @@
 #include "predict_protobuf.h"
 
 #include "converter.h"
+#include "binary_format.h"
+#include "encoding.h"
 #include "executor.h"
+#include "metrics.h"
+#include "postprocessing.h"
+#include "run_watchdog.h"
 #include "util.h"
 
 namespace onnxruntime {
@@ -25,15 +31,13 @@ namespace protobufutil = google::protobuf::util;
 
 protobufutil::Status Executor::SetMLValue(const onnx::TensorProto& input_tensor,
                                           MemBufferArray& buffers,
-                                          OrtMemoryInfo* cpu_memory_info,
+                                          const OrtMemoryInfo* cpu_memory_info,
                                           /* out */ Ort::Value& ml_value) {
-  auto logger = env_->GetLogger(request_id_);
-
   size_t cpu_tensor_length = 0;
   try {
     onnxruntime::server::GetSizeInBytesFromTensorProto<0>(input_tensor, &cpu_tensor_length);
   } catch (const Ort::Exception& e) {
-    logger->error("GetSizeInBytesFromTensorProto() failed. Error Message: {}", e.what());
+    logger_.error("GetSizeInBytesFromTensorProto() failed. Error Message: {}", e.what());
     return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
   }
 
@@ -44,120 +48,357 @@ protobufutil::Status Executor::SetMLValue(const onnx::TensorProto& input_tensor,
                                               ml_value);
 
   } catch (const Ort::Exception& e) {
-    logger->error("TensorProtoToMLValue() failed. Message: {}", e.what());
+    logger_.error("TensorProtoToMLValue() failed. Message: {}", e.what());
     return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
   }
 
   return protobufutil::Status::OK;
 }
 
-protobufutil::Status Executor::SetNameMLValueMap(std::vector<std::string>& input_names,
-                                                 std::vector<Ort::Value>& input_values,
-                                                 const onnxruntime::server::PredictRequest& request,
-                                                 MemBufferArray& buffers) {
-  auto logger = env_->GetLogger(request_id_);
+protobufutil::Status Executor::DecodeMLValue(const onnx::TensorProto& input_tensor,
+                                             const WireEncoding& encoding,
+                                             MemBufferArray& buffers,
+                                             const OrtMemoryInfo* cpu_memory_info,
+                                             /* out */ Ort::Value& ml_value) {
+  std::vector<int64_t> shape(input_tensor.dims().begin(), input_tensor.dims().end());
+  size_t count = 1;
+  for (int64_t dim : shape) {
+    if (dim < 0) {
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Negative tensor dimension");
+    }
+    if (!IAllocator::CalcMemSizeForArray(count, static_cast<size_t>(dim), &count)) {
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Tensor size overflow");
+    }
+  }
+  size_t length;
+  if (!IAllocator::CalcMemSizeForArray(count, sizeof(float), &length)) {
+    return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Tensor size overflow");
+  }
 
-  OrtMemoryInfo* memory_info = nullptr;
-  auto ort_status = Ort::GetApi().CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memory_info);
+  // Only allocate once the encoded data is known to hold count elements,
+  // which bounds the decoded size by the size of the request.
+  try {
+    CheckEncodedTensor(encoding, input_tensor, count);
+  } catch (const Ort::Exception& e) {
+    logger_.error("CheckEncodedTensor() failed. Message: {}", e.what());
+    return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
+  }
 
-  if (ort_status != nullptr || memory_info == nullptr) {
-    logger->error("OrtCreateCpuMemoryInfo failed");
-    return protobufutil::Status(protobufutil::error::Code::RESOURCE_EXHAUSTED, "OrtCreateCpuMemoryInfo() failed");
+  auto* buf = reinterpret_cast<float*>(buffers.AllocNewBuffer(length));
+  try {
+    DecodeFloatTensor(encoding, input_tensor, buf, count);
+    ml_value = Ort::Value::CreateTensor<float>(cpu_memory_info, buf, count, shape.data(), shape.size());
+  } catch (const Ort::Exception& e) {
+    logger_.error("DecodeFloatTensor() failed. Message: {}", e.what());
+    return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
   }
 
+  return protobufutil::Status::OK;
+}
+
+protobufutil::Status Executor::SetNameMLValueMap(const InferencePlan& plan,
+                                                 std::vector<const char*>& input_names,
+                                                 std::vector<Ort::Value>& input_values,
+                                                 const onnxruntime::server::PredictRequest& request,
+                                                 MemBufferArray& buffers) {
+  input_names.reserve(request.inputs_size());
+  input_values.reserve(request.inputs_size());
+
   // Prepare the Value object
   for (const auto& input : request.inputs()) {
     using_raw_data_ = using_raw_data_ && input.second.has_raw_data();
 
+    int index = plan.FindInput(input.first);
+    if (index < 0) {
+      logger_.error("SetNameMLValueMap() failed! Unknown input name: {}", input.first);
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Unknown input name: " + input.first);
+    }
+    auto encoding = request.input_encodings().find(input.first);
+    bool encoded = encoding != request.input_encodings().end() && encoding->second.type() != WireEncoding::FLOAT;
+
+    auto status = plan.ValidateInput(index, encoded ? ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT : GetTensorElementType(input.second),
+                                     input.second.dims().data(), input.second.dims_size());
+    if (status != protobufutil::Status::OK) {
+      logger_.error("ValidateInput() failed! {}", status.error_message());
+      return status;
+    }
+
     Ort::Value ml_value{nullptr};
-    auto status = SetMLValue(input.second, buffers, memory_info, ml_value);
+    if (encoded) {
+      status = DecodeMLValue(input.second, encoding->second, buffers, plan.GetCpuMemoryInfo(), ml_value);
+    } else {
+      status = SetMLValue(input.second, buffers, plan.GetCpuMemoryInfo(), ml_value);
+    }
     if (status != protobufutil::Status::OK) {
-      Ort::GetApi().ReleaseMemoryInfo(memory_info);
-      logger->error("SetMLValue() failed! Input name: {}", input.first);
+      logger_.error("SetMLValue() failed! Input name: {}", input.first);
       return status;
     }
 
-    input_names.push_back(input.first);
+    // Point to the interned name, it outlives the request.
+    input_names.push_back(plan.GetInputs()[index].name.c_str());
     input_values.push_back(std::move(ml_value));
   }
 
-  Ort::GetApi().ReleaseMemoryInfo(memory_info);
   return protobufutil::Status::OK;
 }
 
-std::vector<Ort::Value> Run(const Ort::Session& session, const Ort::RunOptions& options, const std::vector<std::string>& input_names, const std::vector<Ort::Value>& input_values, const std::vector<std::string>& output_names) {
-  size_t input_count = input_names.size();
-  size_t output_count = output_names.size();
+std::vector<Ort::Value> Run(const Ort::Session& session, const Ort::RunOptions& options,
+                            const std::vector<const char*>& input_names, const std::vector<Ort::Value>& input_values,
+                            const std::vector<const char*>& output_names) {
+  return const_cast<Ort::Session&>(session).Run(options, input_names.data(), const_cast<Ort::Value*>(input_values.data()), input_names.size(), output_names.data(), output_names.size());
+}
+
+void Run(const Ort::Session& session, const Ort::RunOptions& options,
+         const std::vector<const char*>& input_names, const std::vector<Ort::Value>& input_values,
+         const std::vector<const char*>& output_names, std::vector<Ort::Value>& output_values) {
+  const_cast<Ort::Session&>(session).Run(options, input_names.data(), const_cast<Ort::Value*>(input_values.data()), input_names.size(), output_names.data(), output_values.data(), output_values.size());
+}
+
+Executor::~Executor() {
+  if (output_buffers_) {
+    output_model_->ReturnOutputBuffers(std::move(output_buffers_));
+  }
+}
 
-  std::vector<const char*> input_ptrs{};
-  input_ptrs.reserve(input_count);
-  for (const auto& input : input_names) {
-    input_ptrs.push_back(input.data());
+protobufutil::Status Executor::AddOutput(const std::string& name, Ort::Value& ml_value,
+                                         const onnxruntime::server::PredictRequest& request,
+                                         /* out */ onnxruntime::server::PredictResponse& response) {
+  onnx::TensorProto output_tensor{};
+  auto encoding = request.output_encodings().find(name);
+  try {
+    if (encoding != request.output_encodings().end() && encoding->second.type() != WireEncoding::FLOAT) {
+      WireEncoding used_encoding = encoding->second;
+      EncodeFloatTensor(ml_value, used_encoding, output_tensor);
+      (*response.mutable_output_encodings())[name] = used_encoding;
+    } else {
+      MLValueToTensorProto(ml_value, using_raw_data_, logger_, output_tensor);
+    }
+  } catch (const Ort::Exception& e) {
+    logger_.error("MLValueToTensorProto() failed. Output name: {}. Error Message: {}", name, e.what());
+    return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
   }
-  std::vector<const char*> output_ptrs{};
-  output_ptrs.reserve(output_count);
-  for (const auto& output : output_names) {
-    output_ptrs.push_back(output.data());
+
+  auto insertion_result = response.mutable_outputs()->insert({name, output_tensor});
+
+  if (!insertion_result.second) {
+    logger_.error("SetNameMLValueMap() failed. Output name: {}. Trying to overwrite existing output value", name);
+    return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "SetNameMLValueMap() failed: Cannot have two outputs with the same name");
   }
 
-  return const_cast<Ort::Session&>(session).Run(options, input_ptrs.data(), const_cast<Ort::Value*>(input_values.data()), input_count, output_ptrs.data(), output_count);
+  return protobufutil::Status::OK;
+}
+
+protobufutil::Status Executor::RunModel(const std::shared_ptr<const Model>& model,
+                                        const std::vector<const char*>& input_names,
+                                        const std::vector<Ort::Value>& input_values,
+                                        const std::vector<const char*>& output_names,
+                                        bool all_outputs,
+                                        std::vector<Ort::Value>& allocated_outputs,
+                                        /* out */ std::vector<Ort::Value>*& outputs) {
+  // Run options only differ in the run tag, so each worker thread reuses one instance.
+  // Runs with a deadline get their own, as the watchdog may terminate them at any time.
+  thread_local static std::unique_ptr<Ort::RunOptions> thread_run_options;
+  std::unique_ptr<Ort::RunOptions> deadline_run_options;
+  std::unique_ptr<RunWatchdog::Registration> registration;
+  Ort::RunOptions* run_options;
+  if (deadline_ == Clock::time_point::max()) {
+    if (!thread_run_options) {
+      thread_run_options.reset(new Ort::RunOptions());
+      thread_run_options->SetRunLogVerbosityLevel(static_cast<int>(env_->GetLogSeverity()));
+    }
+    run_options = thread_run_options.get();
+    run_options->SetRunTag(request_id_.c_str());
+  } else {
+    if (Clock::now() >= deadline_) {
+      return protobufutil::Status(protobufutil::error::Code::DEADLINE_EXCEEDED, "Deadline exceeded before run");
+    }
+    deadline_run_options.reset(new Ort::RunOptions());
+    deadline_run_options->SetRunLogVerbosityLevel(static_cast<int>(env_->GetLogSeverity()));
+    deadline_run_options->SetRunTag(request_id_.c_str());
+    run_options = deadline_run_options.get();
+    registration.reset(new RunWatchdog::Registration(GetRunWatchdog(), *run_options, deadline_));
+  }
+
+  // Outputs are written into reusable buffers if their shapes are known up front.
+  // Filtered requests are rare and use ORT-allocated outputs.
+  outputs = &allocated_outputs;
+  try {
+    if (model->plan.HasStaticOutputs() && all_outputs) {
+      // Outputs are copied into the response before the executor returns the buffers.
+      output_model_ = model;
+      output_buffers_ = model->TakeOutputBuffers();
+      outputs = output_buffers_.get();
+      Run(model->session, *run_options, input_names, input_values, output_names, *outputs);
+    } else {
+      allocated_outputs = Run(model->session, *run_options, input_names, input_values, output_names);
+    }
+  } catch (const Ort::Exception& e) {
+    if (registration && registration->Terminated()) {
+      return protobufutil::Status(protobufutil::error::Code::DEADLINE_EXCEEDED, "Deadline exceeded, run terminated");
+    }
+    return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
+  }
+
+  return protobufutil::Status::OK;
 }
 
 protobufutil::Status Executor::Predict(const onnxruntime::server::PredictRequest& request,
                                        /* out */ onnxruntime::server::PredictResponse& response) {
-  auto logger = env_->GetLogger(request_id_);
+  // Hold on to the model for the whole request, even if it gets replaced meanwhile.
+  auto model = env_->GetModel();
+  if (model == nullptr) {
+    return protobufutil::Status(protobufutil::error::Code::FAILED_PRECONDITION, "Model not initialized");
+  }
+  const InferencePlan& plan = model->plan;
+  EnclaveMetrics& metrics = GetEnclaveMetrics();
+  auto stage_start = metrics.Now();
 
   // Convert PredictRequest to NameMLValMap
   MemBufferArray buffer_array;
-  std::vector<std::string> input_names;
+  std::vector<const char*> input_names;
   std::vector<Ort::Value> input_values;
-  auto conversion_status = SetNameMLValueMap(input_names, input_values, request, buffer_array);
+  auto conversion_status = SetNameMLValueMap(plan, input_names, input_values, request, buffer_array);
   if (conversion_status != protobufutil::Status::OK) {
     return conversion_status;
   }
-
-  Ort::RunOptions run_options{};
-  run_options.SetRunLogVerbosityLevel(static_cast<int>(env_->GetLogSeverity()));
-  run_options.SetRunTag(request_id_.c_str());
+  stage_start = metrics.Record(EnclaveStage::ConvertInputs, stage_start);
 
   // Prepare the output names
-  std::vector<std::string> output_names;
-
+  std::vector<const char*> filtered_output_names;
+  std::vector<int> filtered_output_indices;
   if (!request.output_filter().empty()) {
-    output_names.reserve(request.output_filter_size());
+    filtered_output_names.reserve(request.output_filter_size());
+    filtered_output_indices.reserve(request.output_filter_size());
     for (const auto& name : request.output_filter()) {
-      output_names.push_back(name);
+      int index = plan.FindOutput(name);
+      if (index < 0) {
+        logger_.error("Unknown output name in output filter: {}", name);
+        return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Unknown output name: " + name);
+      }
+      filtered_output_names.push_back(plan.GetOutputs()[index].name.c_str());
+      filtered_output_indices.push_back(index);
     }
-  } else {
-    output_names = env_->GetModelOutputNames();
   }
+  const std::vector<const char*>& output_names = request.output_filter().empty() ? plan.GetOutputNames() : filtered_output_names;
 
-  std::vector<Ort::Value> outputs;
-  try {
-    outputs = Run(env_->GetSession(), run_options, input_names, input_values, output_names);
-  } catch (const Ort::Exception& e) {
-    return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
+  for (const auto& post_processing : request.post_processing()) {
+    if (plan.FindOutput(post_processing.first) < 0) {
+      logger_.error("Unknown output name in post-processing: {}", post_processing.first);
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Unknown output name: " + post_processing.first);
+    }
+    // The indices are returned as an extra output, which must not shadow a model output.
+    if (post_processing.second.type() != PostProcessing::NONE &&
+        plan.FindOutput(post_processing.first + "_indices") >= 0) {
+      logger_.error("Post-processing indices of {} collide with a model output", post_processing.first);
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT,
+                                  "Cannot post-process output " + post_processing.first + ", the model has an output named " +
+                                      post_processing.first + "_indices");
+    }
   }
 
+  std::vector<Ort::Value> allocated_outputs;
+  std::vector<Ort::Value>* outputs_ptr;
+  auto run_status = RunModel(model, input_names, input_values, output_names, request.output_filter().empty(),
+                             allocated_outputs, outputs_ptr);
+  if (run_status != protobufutil::Status::OK) {
+    return run_status;
+  }
+  stage_start = metrics.Record(EnclaveStage::Run, stage_start);
+  std::vector<Ort::Value>& outputs = *outputs_ptr;
+
   // Build the response
+  response.set_model_version(model->version);
   for (size_t i = 0, sz = outputs.size(); i < sz; ++i) {
-    onnx::TensorProto output_tensor{};
+    const std::string& output_name = plan.GetOutputs()[filtered_output_indices.empty() ? i : filtered_output_indices[i]].name;
+    auto post_processing = request.post_processing().find(output_name);
+    if (post_processing != request.post_processing().end() && post_processing->second.type() != PostProcessing::NONE) {
+      Ort::Value values{nullptr};
+      Ort::Value indices{nullptr};
+      try {
+        PostProcess(post_processing->second, outputs[i], values, indices);
+      } catch (const Ort::Exception& e) {
+        logger_.error("PostProcess() failed. Output name: {}. Error Message: {}", output_name, e.what());
+        return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
+      }
+      auto status = AddOutput(output_name, values, request, response);
+      if (status != protobufutil::Status::OK) {
+        return status;
+      }
+      status = AddOutput(output_name + "_indices", indices, request, response);
+      if (status != protobufutil::Status::OK) {
+        return status;
+      }
+    } else {
+      auto status = AddOutput(output_name, outputs[i], request, response);
+      if (status != protobufutil::Status::OK) {
+        return status;
+      }
+    }
+  }
+  metrics.Record(EnclaveStage::ConvertOutputs, stage_start);
+
+  return protobufutil::Status::OK;
+}
+
+protobufutil::Status Executor::PredictBinary(uint8_t* request, size_t request_size,
+                                             /* out */ std::vector<uint8_t>& response) {
+  auto model = env_->GetModel();
+  if (model == nullptr) {
+    return protobufutil::Status(protobufutil::error::Code::FAILED_PRECONDITION, "Model not initialized");
+  }
+  const InferencePlan& plan = model->plan;
+  EnclaveMetrics& metrics = GetEnclaveMetrics();
+  auto stage_start = metrics.Now();
+
+  std::vector<BinaryTensorView> tensors;
+  auto status = ParseBinaryMessage(request, request_size, tensors);
+  if (status != protobufutil::Status::OK) {
+    logger_.error("ParseBinaryMessage() failed! {}", status.error_message());
+    return status;
+  }
+  stage_start = metrics.Record(EnclaveStage::Parse, stage_start);
+
+  // Inputs are bound in place, the request buffer outlives the run.
+  std::vector<const char*> input_names;
+  std::vector<Ort::Value> input_values;
+  input_names.reserve(tensors.size());
+  input_values.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    std::string name(tensor.name, tensor.name_length);
+    int index = plan.FindInput(name);
+    if (index < 0) {
+      logger_.error("PredictBinary() failed! Unknown input name: {}", name);
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "Unknown input name: " + name);
+    }
+    status = plan.ValidateInput(index, tensor.element_type, tensor.dims, tensor.rank);
+    if (status != protobufutil::Status::OK) {
+      logger_.error("ValidateInput() failed! {}", status.error_message());
+      return status;
+    }
     try {
-      MLValueToTensorProto(outputs[i], using_raw_data_, logger, output_tensor);
+      input_values.push_back(Ort::Value::CreateTensor(plan.GetCpuMemoryInfo(), tensor.data, tensor.data_length,
+                                                      tensor.dims, tensor.rank, tensor.element_type));
     } catch (const Ort::Exception& e) {
-      logger = env_->GetLogger(request_id_);
-      logger->error("MLValueToTensorProto() failed. Output name: {}. Error Message: {}", output_names[i], e.what());
+      logger_.error("CreateTensor() failed. Input name: {}. Error Message: {}", name, e.what());
       return GenerateProtobufStatus(e.GetOrtErrorCode(), e.what());
     }
+    input_names.push_back(plan.GetInputs()[index].name.c_str());
+  }
+  stage_start = metrics.Record(EnclaveStage::ConvertInputs, stage_start);
 
-    auto insertion_result = response.mutable_outputs()->insert({output_names[i], output_tensor});
-
-    if (!insertion_result.second) {
-      logger->error("SetNameMLValueMap() failed. Output name: {}. Trying to overwrite existing output value", output_names[i]);
-      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, "SetNameMLValueMap() failed: Cannot have two outputs with the same name");
-    }
+  std::vector<Ort::Value> allocated_outputs;
+  std::vector<Ort::Value>* outputs;
+  status = RunModel(model, input_names, input_values, plan.GetOutputNames(), true, allocated_outputs, outputs);
+  if (status != protobufutil::Status::OK) {
+    return status;
   }
+  stage_start = metrics.Record(EnclaveStage::Run, stage_start);
 
+  status = WriteBinaryMessage(plan.GetOutputNames(), *outputs, model->version, response);
+  if (status != protobufutil::Status::OK) {
+    return status;
+  }
+  metrics.Record(EnclaveStage::ConvertOutputs, stage_start);
   return protobufutil::Status::OK;
 }
 
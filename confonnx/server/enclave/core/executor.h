@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include <chrono>
+
 #include <google/protobuf/stubs/status.h>
 
 #include "environment.h"
+#include "inference_plan.h"
 #include "predict_protobuf.h"
 #include "util.h"
 #include "core/session/onnxruntime_cxx_api.h"
@@ -15,28 +18,67 @@ namespace server {
 
 class Executor {
  public:
-  Executor(ServerEnvironment* server_env, std::string request_id) : env_(server_env),
+  using Clock = std::chrono::steady_clock;
+
+  // Runs still in progress at the deadline are terminated and fail with DEADLINE_EXCEEDED.
+  Executor(ServerEnvironment* server_env, std::string request_id,
+           Clock::time_point deadline = Clock::time_point::max()) : env_(server_env),
                                                                     request_id_(std::move(request_id)),
+                                                                    logger_(server_env->GetLogger(request_id_.c_str())),
+                                                                    deadline_(deadline),
                                                                     using_raw_data_(true) {}
+  ~Executor();
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
 
   // Prediction method
   google::protobuf::util::Status Predict(const onnxruntime::server::PredictRequest& request,
                                          /* out */ onnxruntime::server::PredictResponse& response);
 
+  // Prediction method for the compact binary format, see binary_format.h.
+  // Input tensors are bound in place, so the request buffer is not modified
+  // but must stay valid until the call returns.
+  google::protobuf::util::Status PredictBinary(uint8_t* request, size_t request_size,
+                                               /* out */ std::vector<uint8_t>& response);
+
  private:
   ServerEnvironment* env_;
   const std::string request_id_;
+  const RequestLogger logger_;
+  const Clock::time_point deadline_;
   bool using_raw_data_;
+  // Output buffers taken from output_model_ for this request, returned on destruction.
+  std::shared_ptr<const Model> output_model_;
+  std::unique_ptr<std::vector<Ort::Value>> output_buffers_;
 
   google::protobuf::util::Status SetMLValue(const onnx::TensorProto& input_tensor,
                                             MemBufferArray& buffers,
-                                            OrtMemoryInfo* cpu_memory_info,
+                                            const OrtMemoryInfo* cpu_memory_info,
                                             /* out */ Ort::Value& ml_value);
 
-  google::protobuf::util::Status SetNameMLValueMap(/* out */ std::vector<std::string>& input_names,
+  google::protobuf::util::Status SetNameMLValueMap(const InferencePlan& plan,
+                                                   /* out */ std::vector<const char*>& input_names,
                                                    /* out */ std::vector<Ort::Value>& input_values,
                                                    const onnxruntime::server::PredictRequest& request,
                                                    MemBufferArray& buffers);
+
+  google::protobuf::util::Status RunModel(const std::shared_ptr<const Model>& model,
+                                          const std::vector<const char*>& input_names,
+                                          const std::vector<Ort::Value>& input_values,
+                                          const std::vector<const char*>& output_names,
+                                          bool all_outputs,
+                                          std::vector<Ort::Value>& allocated_outputs,
+                                          /* out */ std::vector<Ort::Value>*& outputs);
+
+  google::protobuf::util::Status DecodeMLValue(const onnx::TensorProto& input_tensor,
+                                               const WireEncoding& encoding,
+                                               MemBufferArray& buffers,
+                                               const OrtMemoryInfo* cpu_memory_info,
+                                               /* out */ Ort::Value& ml_value);
+
+  google::protobuf::util::Status AddOutput(const std::string& name, Ort::Value& ml_value,
+                                           const onnxruntime::server::PredictRequest& request,
+                                           /* out */ onnxruntime::server::PredictResponse& response);
 };
 
 }  // namespace server
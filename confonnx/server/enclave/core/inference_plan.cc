@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <sstream>
+
+#include "inference_plan.h"
+
+namespace onnxruntime {
+namespace server {
+
+namespace protobufutil = google::protobuf::util;
+
+static bool IsStatic(const TensorMetadata& metadata) {
+  if (metadata.element_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED ||
+      metadata.element_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING) {
+    return false;
+  }
+  for (int64_t dim : metadata.shape) {
+    if (dim < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static TensorMetadata GetMetadata(char* name, Ort::AllocatorWithDefaultOptions& allocator, const Ort::TypeInfo& type_info) {
+  TensorMetadata metadata;
+  metadata.name = name;
+  allocator.Free(name);
+  if (type_info.GetONNXType() == ONNX_TYPE_TENSOR) {
+    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
+    metadata.element_type = tensor_info.GetElementType();
+    metadata.shape = tensor_info.GetShape();
+  } else {
+    metadata.element_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+  }
+  return metadata;
+}
+
+InferencePlan::InferencePlan(const Ort::Session& session)
+    : static_outputs_(true),
+      cpu_memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
+  // The Ort::Session getters are not marked const, but don't modify the session.
+  auto& s = const_cast<Ort::Session&>(session);
+  Ort::AllocatorWithDefaultOptions allocator;
+
+  size_t input_count = s.GetInputCount();
+  inputs_.reserve(input_count);
+  for (size_t i = 0; i < input_count; i++) {
+    inputs_.push_back(GetMetadata(s.GetInputName(i, allocator), allocator, s.GetInputTypeInfo(i)));
+    input_indices_.emplace(inputs_.back().name, static_cast<int>(i));
+  }
+
+  size_t output_count = s.GetOutputCount();
+  outputs_.reserve(output_count);
+  for (size_t i = 0; i < output_count; i++) {
+    outputs_.push_back(GetMetadata(s.GetOutputName(i, allocator), allocator, s.GetOutputTypeInfo(i)));
+    output_indices_.emplace(outputs_.back().name, static_cast<int>(i));
+    static_outputs_ = static_outputs_ && IsStatic(outputs_.back());
+  }
+
+  // Only take pointers once outputs_ won't reallocate anymore.
+  output_names_.reserve(output_count);
+  for (const auto& output : outputs_) {
+    output_names_.push_back(output.name.c_str());
+  }
+}
+
+int InferencePlan::FindInput(const std::string& name) const {
+  auto it = input_indices_.find(name);
+  return it == input_indices_.end() ? -1 : it->second;
+}
+
+int InferencePlan::FindOutput(const std::string& name) const {
+  auto it = output_indices_.find(name);
+  return it == output_indices_.end() ? -1 : it->second;
+}
+
+protobufutil::Status InferencePlan::ValidateInput(size_t index, ONNXTensorElementDataType element_type,
+                                                  const int64_t* dims, size_t rank) const {
+  const TensorMetadata& input = inputs_[index];
+  if (input.element_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED) {
+    // Non-tensor input, leave it to ONNX Runtime.
+    return protobufutil::Status::OK;
+  }
+
+  if (element_type != input.element_type) {
+    std::ostringstream oss;
+    oss << "Unexpected element type for input '" << input.name << "': "
+        << "expected " << input.element_type << ", got " << element_type;
+    return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, oss.str());
+  }
+
+  // An empty shape is reported both for scalars and for inputs without
+  // shape information, so only check the rank if there is one.
+  if (input.shape.empty()) {
+    return protobufutil::Status::OK;
+  }
+
+  if (rank != input.shape.size()) {
+    std::ostringstream oss;
+    oss << "Unexpected rank for input '" << input.name << "': "
+        << "expected " << input.shape.size() << ", got " << rank;
+    return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, oss.str());
+  }
+
+  for (size_t i = 0; i < input.shape.size(); i++) {
+    if (input.shape[i] >= 0 && input.shape[i] != dims[i]) {
+      std::ostringstream oss;
+      oss << "Unexpected dimension " << i << " for input '" << input.name << "': "
+          << "expected " << input.shape[i] << ", got " << dims[i];
+      return protobufutil::Status(protobufutil::error::Code::INVALID_ARGUMENT, oss.str());
+    }
+  }
+
+  return protobufutil::Status::OK;
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <google/protobuf/stubs/status.h>
+
+#include "core/session/onnxruntime_cxx_api.h"
+
+namespace onnxruntime {
+namespace server {
+
+struct TensorMetadata {
+  std::string name;
+  // ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED for non-tensor values (sequences, maps).
+  ONNXTensorElementDataType element_type;
+  // Negative values denote symbolic dimensions.
+  std::vector<int64_t> shape;
+};
+
+/**
+ * Per-model state that every inference request needs and that does not change
+ * between requests: input/output metadata, interned names and the CPU memory info.
+ * Built once when the model is loaded, so that requests only bind values and run.
+ */
+class InferencePlan {
+ public:
+  explicit InferencePlan(const Ort::Session& session);
+  InferencePlan(const InferencePlan&) = delete;
+  InferencePlan& operator=(const InferencePlan&) = delete;
+
+  const std::vector<TensorMetadata>& GetInputs() const { return inputs_; }
+  const std::vector<TensorMetadata>& GetOutputs() const { return outputs_; }
+
+  // Names of all outputs in model order, backed by GetOutputs().
+  const std::vector<const char*>& GetOutputNames() const { return output_names_; }
+
+  // Index of the input/output with the given name, or -1 if the model has none.
+  int FindInput(const std::string& name) const;
+  int FindOutput(const std::string& name) const;
+
+  // Checks element type and static dimensions of a request tensor against
+  // the model input, so that mismatches are rejected before unpacking.
+  // element_type is the type the tensor has once unpacked.
+  google::protobuf::util::Status ValidateInput(size_t index, ONNXTensorElementDataType element_type,
+                                               const int64_t* dims, size_t rank) const;
+
+  // True if all outputs are numeric tensors with fully static shapes,
+  // meaning output tensors can be allocated up front and reused.
+  bool HasStaticOutputs() const { return static_outputs_; }
+
+  const OrtMemoryInfo* GetCpuMemoryInfo() const { return cpu_memory_info_; }
+
+ private:
+  std::vector<TensorMetadata> inputs_;
+  std::vector<TensorMetadata> outputs_;
+  std::vector<const char*> output_names_;
+  std::unordered_map<std::string, int> input_indices_;
+  std::unordered_map<std::string, int> output_indices_;
+  bool static_outputs_;
+  Ort::MemoryInfo cpu_memory_info_;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
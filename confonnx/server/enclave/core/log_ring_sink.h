@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include "server/shared/log_ring.h"
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Writes log messages into the host log ring instead of stdout, which
+ * avoids an OCALL and the sink mutex per message. Only the message text
+ * and level are passed, the host logger adds its own prefix.
+ */
+class LogRingSink final : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+ public:
+  explicit LogRingSink(const LogRingWriter& writer) : writer_(writer) {}
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override {
+    writer_.Push(static_cast<uint32_t>(msg.level), msg.payload.data(), msg.payload.size());
+  }
+
+  void flush_() override {}
+
+ private:
+  LogRingWriter writer_;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
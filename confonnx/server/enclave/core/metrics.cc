@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "metrics.h"
+
+namespace onnxruntime {
+namespace server {
+
+void EnclaveMetrics::Snapshot(EnclaveStats& stats) const {
+  for (size_t i = 0; i < kEnclaveStageCount; i++) {
+    stages_[i].Snapshot(stats.stages[i]);
+  }
+  stats.key_refresh_refreshed = key_refresh_refreshed_.load(std::memory_order_relaxed);
+  stats.key_refresh_unchanged = key_refresh_unchanged_.load(std::memory_order_relaxed);
+  stats.key_refresh_failed = key_refresh_failed_.load(std::memory_order_relaxed);
+  stats.runs_terminated = runs_terminated_.load(std::memory_order_relaxed);
+}
+
+EnclaveMetrics& GetEnclaveMetrics() {
+  static EnclaveMetrics metrics;
+  return metrics;
+}
+
+}  // namespace server
+}  // namespace onnxruntime
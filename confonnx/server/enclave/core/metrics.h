@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "server/shared/metrics.h"
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Per-stage timings of score requests and key refresh outcomes, aggregated
+ * inside the enclave and fetched by the host via EnclaveGetStats.
+ * Timing is off by default as reading the clock inside SGX requires an OCALL.
+ */
+class EnclaveMetrics {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void SetTimingEnabled(bool enabled) { timing_enabled_.store(enabled, std::memory_order_relaxed); }
+  bool IsTimingEnabled() const { return timing_enabled_.load(std::memory_order_relaxed); }
+
+  // Current time, or an empty time point if timing is disabled.
+  Clock::time_point Now() const {
+    return IsTimingEnabled() ? Clock::now() : Clock::time_point();
+  }
+
+  // Records the time since start for the given stage and returns the current time,
+  // which is the start of the next stage. Does nothing if start is empty.
+  Clock::time_point Record(EnclaveStage stage, Clock::time_point start) {
+    if (start == Clock::time_point()) {
+      return start;
+    }
+    auto now = Clock::now();
+    stages_[static_cast<size_t>(stage)].Record(now - start);
+    return now;
+  }
+
+  void RecordKeyRefresh(bool refreshed) {
+    (refreshed ? key_refresh_refreshed_ : key_refresh_unchanged_).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void RecordKeyRefreshFailure() {
+    key_refresh_failed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Records a run terminated because its deadline passed.
+  void RecordRunTerminated(size_t count) {
+    runs_terminated_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void Snapshot(EnclaveStats& stats) const;
+
+ private:
+  std::atomic<bool> timing_enabled_{false};
+  LatencyHistogram stages_[kEnclaveStageCount];
+  std::atomic<uint64_t> key_refresh_refreshed_{0};
+  std::atomic<uint64_t> key_refresh_unchanged_{0};
+  std::atomic<uint64_t> key_refresh_failed_{0};
+  std::atomic<uint64_t> runs_terminated_{0};
+};
+
+// Process-wide instance, available before the enclave is initialized.
+EnclaveMetrics& GetEnclaveMetrics();
+
+}  // namespace server
+}  // namespace onnxruntime
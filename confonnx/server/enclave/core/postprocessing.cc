@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "postprocessing.h"
+
+namespace onnxruntime {
+namespace server {
+
+template <typename T>
+static void TopK(const T* data, const std::vector<int64_t>& shape, size_t k,
+                 ONNXTensorElementDataType element_type,
+                 Ort::Value& values, Ort::Value& indices) {
+  if (shape.empty()) {
+    throw Ort::Exception("Top-k requires an output with at least one dimension", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+  // Items are the slices along the first (batch) axis, flattened.
+  const size_t rows = shape.size() == 1 ? 1 : static_cast<size_t>(shape[0]);
+  const size_t n = static_cast<size_t>(std::accumulate(shape.begin() + (shape.size() == 1 ? 0 : 1), shape.end(),
+                                                       int64_t{1}, std::multiplies<int64_t>()));
+  k = std::min(k, n);
+
+  std::vector<int64_t> result_shape;
+  if (shape.size() > 1) {
+    result_shape.push_back(shape[0]);
+  }
+  result_shape.push_back(static_cast<int64_t>(k));
+  Ort::AllocatorWithDefaultOptions allocator;
+  values = Ort::Value::CreateTensor(allocator, result_shape.data(), result_shape.size(), element_type);
+  indices = Ort::Value::CreateTensor(allocator, result_shape.data(), result_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
+  T* values_data = values.GetTensorMutableData<T>();
+  int64_t* indices_data = indices.GetTensorMutableData<int64_t>();
+
+  std::vector<int64_t> order(n);
+  for (size_t row = 0; row < rows; row++) {
+    const T* row_data = data + row * n;
+    std::iota(order.begin(), order.end(), 0);
+    // NaN ranks lowest, as comparisons with NaN would break the strict weak ordering.
+    // Ties are broken by the lower index to keep results deterministic.
+    std::partial_sort(order.begin(), order.begin() + k, order.end(), [row_data](int64_t a, int64_t b) {
+      bool a_nan = std::isnan(row_data[a]);
+      bool b_nan = std::isnan(row_data[b]);
+      if (a_nan || b_nan) {
+        return !a_nan || (b_nan && a < b);
+      }
+      return row_data[a] > row_data[b] || (row_data[a] == row_data[b] && a < b);
+    });
+    for (size_t i = 0; i < k; i++) {
+      values_data[row * k + i] = row_data[order[i]];
+      indices_data[row * k + i] = order[i];
+    }
+  }
+}
+
+template <typename T>
+static void Threshold(const T* data, size_t count, float threshold, size_t limit,
+                      ONNXTensorElementDataType element_type,
+                      Ort::Value& values, Ort::Value& indices) {
+  std::vector<int64_t> selected;
+  for (size_t i = 0; i < count && (limit == 0 || selected.size() < limit); i++) {
+    if (data[i] >= threshold) {
+      selected.push_back(static_cast<int64_t>(i));
+    }
+  }
+
+  const int64_t result_shape[] = {static_cast<int64_t>(selected.size())};
+  Ort::AllocatorWithDefaultOptions allocator;
+  values = Ort::Value::CreateTensor(allocator, result_shape, 1, element_type);
+  indices = Ort::Value::CreateTensor(allocator, result_shape, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
+  T* values_data = values.GetTensorMutableData<T>();
+  int64_t* indices_data = indices.GetTensorMutableData<int64_t>();
+  for (size_t i = 0; i < selected.size(); i++) {
+    values_data[i] = data[selected[i]];
+    indices_data[i] = selected[i];
+  }
+}
+
+template <typename T>
+static void PostProcessTyped(const PostProcessing& spec, Ort::Value& ml_value,
+                             Ort::Value& values, Ort::Value& indices) {
+  auto info = ml_value.GetTensorTypeAndShapeInfo();
+  const T* data = ml_value.GetTensorMutableData<T>();
+  switch (spec.type()) {
+    case PostProcessing::TOP_K:
+      if (spec.k() == 0) {
+        throw Ort::Exception("Top-k requires k > 0", OrtErrorCode::ORT_INVALID_ARGUMENT);
+      }
+      TopK(data, info.GetShape(), spec.k(), info.GetElementType(), values, indices);
+      break;
+    case PostProcessing::ARGMAX:
+      TopK(data, info.GetShape(), 1, info.GetElementType(), values, indices);
+      break;
+    case PostProcessing::THRESHOLD:
+      Threshold(data, info.GetElementCount(), spec.threshold(), spec.k(), info.GetElementType(), values, indices);
+      break;
+    default:
+      throw Ort::Exception("Unknown post-processing type", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+void PostProcess(const PostProcessing& spec, Ort::Value& ml_value,
+                 /* out */ Ort::Value& values, /* out */ Ort::Value& indices) {
+  if (!ml_value.IsTensor()) {
+    throw Ort::Exception("Post-processing requires a tensor output", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+  switch (ml_value.GetTensorTypeAndShapeInfo().GetElementType()) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+      PostProcessTyped<float>(spec, ml_value, values, indices);
+      break;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+      PostProcessTyped<double>(spec, ml_value, values, indices);
+      break;
+    default:
+      throw Ort::Exception("Post-processing requires a float or double output", OrtErrorCode::ORT_INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace server
+}  // namespace onnxruntime
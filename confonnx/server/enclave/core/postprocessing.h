@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+#include "core/session/onnxruntime_cxx_api.h"
+
+#include "predict_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+
+// Applies a post-processing spec to a float or double output tensor.
+// The selected values keep the element type of the output, indices are int64.
+// See PostProcessing in predict.proto for the semantics of each type.
+// Throws Ort::Exception for invalid specs or unsupported outputs.
+void PostProcess(const PostProcessing& spec, Ort::Value& ml_value,
+                 /* out */ Ort::Value& values, /* out */ Ort::Value& indices);
+
+}  // namespace server
+}  // namespace onnxruntime
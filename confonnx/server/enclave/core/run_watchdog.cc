@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "run_watchdog.h"
+
+namespace onnxruntime {
+namespace server {
+
+RunWatchdog::Registration::Registration(RunWatchdog& watchdog, Ort::RunOptions& run_options, Clock::time_point deadline)
+    : watchdog_(watchdog) {
+  std::lock_guard<std::mutex> lock(watchdog_.mutex_);
+  run_ = watchdog_.runs_.insert(watchdog_.runs_.end(), Run{&run_options, deadline, false});
+}
+
+RunWatchdog::Registration::~Registration() {
+  // After this, the watchdog no longer touches the run options.
+  std::lock_guard<std::mutex> lock(watchdog_.mutex_);
+  watchdog_.runs_.erase(run_);
+}
+
+bool RunWatchdog::Registration::Terminated() const {
+  std::lock_guard<std::mutex> lock(watchdog_.mutex_);
+  return run_->terminated;
+}
+
+size_t RunWatchdog::TerminateExpired(Clock::time_point now) {
+  size_t terminated = 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& run : runs_) {
+    if (!run.terminated && run.deadline < now) {
+      // Takes effect at the next node the run executes.
+      run.run_options->SetTerminate();
+      run.terminated = true;
+      terminated++;
+    }
+  }
+  return terminated;
+}
+
+RunWatchdog& GetRunWatchdog() {
+  static RunWatchdog watchdog;
+  return watchdog;
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <mutex>
+
+#include "core/session/onnxruntime_cxx_api.h"
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Tracks the ONNX Runtime runs of requests that have a deadline and terminates
+ * them once it has passed, so that the enclave does not keep computing results
+ * nobody waits for. The host triggers the check via EnclaveCancelExpiredRuns,
+ * the enclave decides which runs have expired.
+ */
+class RunWatchdog {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ private:
+  struct Run {
+    Ort::RunOptions* run_options;
+    Clock::time_point deadline;
+    bool terminated;
+  };
+
+ public:
+  // Keeps a run registered while in scope.
+  class Registration {
+   public:
+    Registration(RunWatchdog& watchdog, Ort::RunOptions& run_options, Clock::time_point deadline);
+    ~Registration();
+    Registration(const Registration&) = delete;
+    Registration& operator=(const Registration&) = delete;
+
+    // Whether the watchdog terminated the run.
+    bool Terminated() const;
+
+   private:
+    RunWatchdog& watchdog_;
+    std::list<Run>::iterator run_;
+  };
+
+  // Terminates all registered runs whose deadline is before now.
+  // Returns the number of runs that were terminated by this call.
+  size_t TerminateExpired(Clock::time_point now);
+
+ private:
+  mutable std::mutex mutex_;  // guards runs_ and the runs in it
+  std::list<Run> runs_;
+};
+
+// Process-wide instance.
+RunWatchdog& GetRunWatchdog();
+
+}  // namespace server
+}  // namespace onnxruntime
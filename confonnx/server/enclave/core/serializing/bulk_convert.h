@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <google/protobuf/repeated_field.h>
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Bulk element conversion between tensor buffers and the typed TensorProto
+ * fields (float_data, int32_data, ...).
+ * Same-type copies are a memcpy. Widening and narrowing between integer
+ * types (e.g. int8/int16/uint16/bool <-> int32) are plain loops over
+ * contiguous arrays without per-element calls, which the compiler vectorizes.
+ *
+ * Defining CONFONNX_PER_ELEMENT_CONVERSION selects the per-element loops these
+ * functions replaced, so that benchmarks can compare both on the real call sites
+ * (see bench/CMakeLists.txt). It is not meant for production builds.
+ */
+#ifndef CONFONNX_PER_ELEMENT_CONVERSION
+
+template <typename Src, typename Dst>
+inline void ConvertArray(const Src* src, size_t count, /* out */ Dst* dst) {
+  if constexpr (std::is_same<Src, Dst>::value) {
+    if (count > 0) {
+      std::memcpy(dst, src, count * sizeof(Src));
+    }
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = static_cast<Dst>(src[i]);
+    }
+  }
+}
+
+// Appends count converted elements to a repeated field with a single allocation.
+template <typename Src, typename Dst>
+inline void AppendToRepeatedField(const Src* src, size_t count,
+                                  /* out */ google::protobuf::RepeatedField<Dst>* field) {
+  field->Reserve(field->size() + static_cast<int>(count));
+  Dst* dst = field->AddNAlreadyReserved(static_cast<int>(count));
+  ConvertArray(src, count, dst);
+}
+
+// Narrows int32 values to uint16 (used for float16/bfloat16 bit patterns in int32_data).
+// Returns false if any value is out of range, the output is then unspecified.
+inline bool NarrowToUInt16Checked(const int32_t* src, size_t count, /* out */ uint16_t* dst) {
+  uint32_t out_of_range = 0;
+  for (size_t i = 0; i < count; ++i) {
+    out_of_range |= static_cast<uint32_t>(src[i]) >> 16;
+    dst[i] = static_cast<uint16_t>(src[i]);
+  }
+  return out_of_range == 0;
+}
+
+#else
+
+template <typename Src, typename Dst>
+inline void ConvertArray(const Src* src, size_t count, /* out */ Dst* dst) {
+  for (const Src* it = src; it != src + count; ++it) {
+    *dst++ = static_cast<Dst>(*it);
+  }
+}
+
+template <typename Src, typename Dst>
+inline void AppendToRepeatedField(const Src* src, size_t count,
+                                  /* out */ google::protobuf::RepeatedField<Dst>* field) {
+  for (size_t i = 0; i < count; ++i) {
+    field->Add(src[i]);
+  }
+}
+
+inline bool NarrowToUInt16Checked(const int32_t* src, size_t count, /* out */ uint16_t* dst) {
+  for (size_t i = 0; i < count; ++i) {
+    if (src[i] < 0 || src[i] > 0xffff) {
+      return false;
+    }
+    dst[i] = static_cast<uint16_t>(src[i]);
+  }
+  return true;
+}
+
+#endif
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include "tensorprotoutils.h"
+#include "bulk_convert.h"
 
 #include <memory>
 #include <algorithm>
@@ -123,9 +124,7 @@ static void UnpackTensorWithRawData(const void* raw_data, size_t raw_data_length
       throw Ort::Exception(MakeString("corrupted protobuf data: tensor shape size(", expected_size,          \
                                       ") does not match the data size(", tensor.field_size(), ") in proto"), \
                            OrtErrorCode::ORT_FAIL);                                                          \
-    auto& data = tensor.field_name();                                                                        \
-    for (auto data_iter = data.cbegin(); data_iter != data.cend(); ++data_iter)                              \
-      *p_data++ = *reinterpret_cast<const T*>(data_iter);                                                    \
+    ConvertArray(tensor.field_name().data(), static_cast<size_t>(expected_size), p_data);                   \
     return;                                                                                                  \
   }
 
@@ -185,9 +184,7 @@ void UnpackTensor(const onnx::TensorProto& tensor, const void* raw_data, size_t
     throw Ort::Exception(
         "UnpackTensor: the pre-allocate size does not match the size in proto", OrtErrorCode::ORT_FAIL);
   }
-  for (int iter : tensor.int32_data()) {
-    *p_data++ = static_cast<bool>(iter);
-  }
+  ConvertArray(tensor.int32_data().data(), static_cast<size_t>(expected_size), p_data);
 
   return;
 }
@@ -212,14 +209,11 @@ void UnpackTensor(const onnx::TensorProto& tensor, const void* raw_data, size_t
         "UnpackTensor: the pre-allocate size does not match the size in proto", OrtErrorCode::ORT_FAIL);
   }
 
-  constexpr int max_value = std::numeric_limits<uint16_t>::max();
-  for (int i = 0; i < static_cast<int>(expected_size); i++) {
-    int v = tensor.int32_data()[i];
-    if (v < 0 || v > max_value) {
-      throw Ort::Exception(
-          "data overflow", OrtErrorCode::ORT_FAIL);
-    }
-    p_data[i] = MLFloat16(static_cast<uint16_t>(v));
+  static_assert(sizeof(MLFloat16) == sizeof(uint16_t), "unexpected MLFloat16 layout");
+  if (!NarrowToUInt16Checked(tensor.int32_data().data(), static_cast<size_t>(expected_size),
+                             reinterpret_cast<uint16_t*>(p_data))) {
+    throw Ort::Exception(
+        "data overflow", OrtErrorCode::ORT_FAIL);
   }
 
   return;
@@ -249,14 +243,11 @@ void UnpackTensor(const onnx::TensorProto& tensor, const void* raw_data, size_t
         "UnpackTensor: the pre-allocate size does not match the size in proto", OrtErrorCode::ORT_FAIL);
   }
 
-  constexpr int max_value = std::numeric_limits<uint16_t>::max();
-  for (int i = 0; i < static_cast<int>(expected_size); i++) {
-    int v = tensor.int32_data()[i];
-    if (v < 0 || v > max_value) {
-      throw Ort::Exception(
-          "data overflow", OrtErrorCode::ORT_FAIL);
-    }
-    p_data[i] = BFloat16(static_cast<uint16_t>(v));
+  static_assert(sizeof(BFloat16) == sizeof(uint16_t), "unexpected BFloat16 layout");
+  if (!NarrowToUInt16Checked(tensor.int32_data().data(), static_cast<size_t>(expected_size),
+                             reinterpret_cast<uint16_t*>(p_data))) {
+    throw Ort::Exception(
+        "data overflow", OrtErrorCode::ORT_FAIL);
   }
 
   return;
@@ -437,4 +428,4 @@ template void GetSizeInBytesFromTensorProto<256>(const onnx::TensorProto& tensor
                                                  size_t* out);
 template void GetSizeInBytesFromTensorProto<0>(const onnx::TensorProto& tensor_proto, size_t* out);
 }  // namespace server
-}  // namespace onnxruntime
\ No newline at end of file
+}  // namespace onnxruntime
\ No newline at end of file
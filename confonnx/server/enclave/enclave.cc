@@ -6,6 +6,7 @@
 #include <streambuf>
 #include <istream>
 #include <chrono>
+#include <atomic>
 
 #ifdef HAVE_LIBSKR
 #include <skr/skr.h>
@@ -29,11 +30,16 @@
 #include "server/enclave/core/predict_protobuf.h"
 #include "server/enclave/core/environment.h"
 #include "server/enclave/core/executor.h"
-#include "server/enclave/threading.h"
+#include "server/enclave/core/log_ring_sink.h"
+#include "server/enclave/core/metrics.h"
+#include "server/enclave/core/run_watchdog.h"
 #include "server/enclave/key_vault_provider.h"
 #include "server/enclave/key_vault_hsm_provider.h"
 #include "server/enclave/exceptions.h"
+#ifdef OE_BUILD_ENCLAVE
+#include "server/enclave/threading.h"
 #include "server_t.h"
+#endif
 
 namespace onnxruntime {
 namespace server {
@@ -44,30 +50,66 @@ confmsg::Server* confmsg_server = nullptr;
 server::ServerEnvironment* env = nullptr;
 std::chrono::seconds key_rollover_interval;
 
+// Host log ring registered via EnclaveSetLogRing, stdout is used without it.
+std::unique_ptr<LogRingWriter> log_ring;
+
 // Value of x-ms-request-id header field, generated and forwarded from the host.
 // Used for correlating log messages to requests.
 thread_local static const char* current_request_id;
 
 thread_local static RequestType current_request_type;
 
+// Deadline of the current request forwarded from the host, max if the client set none.
+thread_local static RunWatchdog::Clock::time_point current_deadline;
+
+// Start of the current stage of a score request, chained across
+// EnclaveHandleRequest, HandleRequest and the executor. Empty if timing
+// is disabled or the request is not a score request.
+// See EnclaveSetTimingEnabled/EnclaveGetStats.
+thread_local static EnclaveMetrics::Clock::time_point stage_start;
+thread_local static EnclaveMetrics::Clock::duration last_inference_time;
+
+// Fails score requests whose client gave up already, before any work is done for them.
+static void CheckDeadline() {
+  if (current_deadline != RunWatchdog::Clock::time_point::max() && RunWatchdog::Clock::now() >= current_deadline) {
+    throw DeadlineExceededError("Deadline exceeded before inference");
+  }
+}
+
+// Converts a failed executor status into the exception for the status code returned to the host.
+static void ThrowInferenceError(const protobufutil::Status& status) {
+  if (status.code() == protobufutil::error::Code::DEADLINE_EXCEEDED) {
+    throw DeadlineExceededError(status.error_message());
+  }
+  throw InferenceError(status.error_message());
+}
+
 void HandleRequest(std::vector<uint8_t>& data) {
   auto logger = env->GetLogger(current_request_id);
+  EnclaveMetrics& metrics = GetEnclaveMetrics();
 
   if (current_request_type == RequestType::Score) {
+    stage_start = metrics.Record(EnclaveStage::Decrypt, stage_start);
+    CheckDeadline();
+
     // Parse protobuf
     PredictRequest predict_request;
     if (!predict_request.ParseFromArray(data.data(), data.size())) {
       throw PayloadParseError("Protobuf parsing error");
     }
+    stage_start = metrics.Record(EnclaveStage::Parse, stage_start);
 
     // Run inference
     protobufutil::Status status;
-    Executor executor(env, current_request_id);
+    Executor executor(env, current_request_id, current_deadline);
     PredictResponse predict_response{};
+    auto inference_start = stage_start;
     status = executor.Predict(predict_request, predict_response);
     if (!status.ok()) {
-      throw InferenceError(status.error_message());
+      ThrowInferenceError(status);
     }
+    stage_start = metrics.Now();
+    last_inference_time = stage_start - inference_start;
 
     // Serialize output
     size_t proto_size = predict_response.ByteSizeLong();
@@ -75,8 +117,56 @@ void HandleRequest(std::vector<uint8_t>& data) {
     if (!predict_response.SerializeToArray(data.data(), proto_size)) {
       throw SerializationError("Protobuf serialization error");
     }
+    stage_start = metrics.Record(EnclaveStage::Serialize, stage_start);
+  } else if (current_request_type == RequestType::ScoreBinary) {
+    stage_start = metrics.Record(EnclaveStage::Decrypt, stage_start);
+    CheckDeadline();
+
+    // Run inference, inputs are referenced in place.
+    // Parsing and serialization are timed by the executor.
+    Executor executor(env, current_request_id, current_deadline);
+    std::vector<uint8_t> response_data;
+    auto inference_start = stage_start;
+    protobufutil::Status status = executor.PredictBinary(data.data(), data.size(), response_data);
+    if (!status.ok()) {
+      ThrowInferenceError(status);
+    }
+    stage_start = metrics.Now();
+    last_inference_time = stage_start - inference_start;
+    data.swap(response_data);
   } else if (current_request_type == RequestType::ProvisionModelKey) {
-    env->InitializeModel(confmsg::StaticKeyProvider::Create(data, confmsg::KeyType::Curve25519));
+    stage_start = {};
+    try {
+      env->InitializeModel(confmsg::StaticKeyProvider::Create(data, confmsg::KeyType::Curve25519));
+    } catch (const Ort::Exception& exc) {
+      throw ModelLoadingError(fmt::format("Model loading failed: {} ---- Error: [{}]", exc.GetOrtErrorCode(), exc.what()));
+    }
+  } else if (current_request_type == RequestType::UpdateModel) {
+    // The payload is the new model encrypted with the model key, which
+    // authenticates the update. The service identifier follows the model
+    // so that clients re-attesting after the switch can detect it.
+    stage_start = {};
+    uint32_t model_version;
+    try {
+      model_version = env->UpdateModel(data.data(), data.size(), [&](const Model&) {
+        std::vector<uint8_t> service_id;
+        confmsg::internal::SHA256(confmsg::CBuffer(data.data(), data.size()), service_id);
+        confmsg_server->SetServiceIdentifier(service_id);
+        logger.info("Service identifier: {}", confmsg::Buffer2Hex(service_id));
+      });
+    } catch (const Ort::Exception& exc) {
+      throw ModelLoadingError(fmt::format("Model loading failed: {} ---- Error: [{}]", exc.GetOrtErrorCode(), exc.what()));
+    }
+    logger.info("Model updated to version {}", model_version);
+
+    UpdateModelResponse update_response;
+    update_response.set_model_version(model_version);
+    // Swapping also releases the model-sized request buffer.
+    std::vector<uint8_t> response_data(update_response.ByteSizeLong());
+    if (!update_response.SerializeToArray(response_data.data(), response_data.size())) {
+      throw SerializationError("Protobuf serialization error");
+    }
+    data.swap(response_data);
   } else {
     throw UnknownRequestTypeError(std::to_string(static_cast<uint8_t>(current_request_type)));
   }
@@ -94,9 +184,11 @@ int _EnclaveInitialize(
     return SESSION_ALREADY_INITIALIZED_ERROR;
   }
 
+#ifdef OE_BUILD_ENCLAVE
   oe_load_module_host_socket_interface();
   oe_load_module_host_resolver();
   initialize_oe_pthreads();
+#endif
 #ifdef _DEBUG
   bool verbose_curl = true;
 #else
@@ -138,9 +230,14 @@ int _EnclaveInitialize(
   OrtLoggingLevel log_level = ORT_LOGGING_LEVEL_FATAL;
 #endif
 
+  spdlog::sink_ptr sink;
+  if (log_ring) {
+    sink = std::make_shared<LogRingSink>(*log_ring);
+  } else {
+    sink = std::make_shared<spdlog::sinks::stdout_sink_mt>();
+  }
   env = new server::ServerEnvironment(log_level,
-                                      spdlog::sinks_init_list{
-                                          std::make_shared<spdlog::sinks::stdout_sink_mt>()},
+                                      spdlog::sinks_init_list{sink},
                                       std::move(model_key_provider));
 
   auto logger = env->GetAppLogger();
@@ -213,6 +310,7 @@ extern "C" int EnclaveInitialize(
 extern "C" int EnclaveHandleRequest(
     const char* request_id,
     uint8_t request_type,
+    uint32_t timeout_ms,
     const uint8_t* input_buf, size_t input_size,
     uint8_t* output_buf, size_t* output_size, size_t output_max_size) {
   auto logger = env->GetLogger(request_id);
@@ -228,46 +326,69 @@ extern "C" int EnclaveHandleRequest(
   try {
     current_request_id = request_id;
     current_request_type = static_cast<RequestType>(request_type);
+    // The host forwards the time left, so the enclave and host clocks need not agree.
+    current_deadline = timeout_ms == 0 ? RunWatchdog::Clock::time_point::max()
+                                       : RunWatchdog::Clock::now() + std::chrono::milliseconds(timeout_ms);
+    EnclaveMetrics& metrics = GetEnclaveMetrics();
+    // Key requests are answered by confmsg without calling HandleRequest,
+    // HandleRequest clears stage_start for request types that are not timed.
+    stage_start = metrics.Now();
     confmsg_server->RespondToMessage(input_buf, input_size, output_buf, output_size, output_max_size);
+    if (current_request_type == RequestType::Score || current_request_type == RequestType::ScoreBinary) {
+      metrics.Record(EnclaveStage::Encrypt, stage_start);
+    }
   } catch (confmsg::CryptoError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return CRYPTO_ERROR;
   } catch (confmsg::KeyRefreshError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return KEY_REFRESH_ERROR;
   } catch (confmsg::PayloadParseError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return PAYLOAD_PARSE_ERROR;
   } catch (confmsg::OutputBufferTooSmallError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return OUTPUT_BUFFER_TOO_SMALL_ERROR;
   } catch (confmsg::SerializationError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return OUTPUT_SERIALIZATION_ERROR;
   } catch (confmsg::AttestationError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return ATTESTATION_ERROR;
   } catch (server::PayloadParseError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return PAYLOAD_PARSE_ERROR;
   } catch (server::ModelAlreadyInitializedError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return MODEL_ALREADY_INITIALIZED_ERROR;
+  } catch (server::ModelUpdateError& exc) {
+    logger.error(exc.what());
+    return MODEL_UPDATE_ERROR;
+  } catch (server::ModelLoadingError& exc) {
+    logger.error(exc.what());
+    return MODEL_LOADING_ERROR;
   } catch (server::SerializationError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return OUTPUT_SERIALIZATION_ERROR;
   } catch (server::InferenceError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     // TODO forward error message, see notes above
     return INFERENCE_ERROR;
+  } catch (server::DeadlineExceededError& exc) {
+    logger.warn(exc.what());
+    return DEADLINE_EXCEEDED_ERROR;
   } catch (server::UnknownRequestTypeError& exc) {
-    logger->error(exc.what());
+    logger.error(exc.what());
     return UNKNOWN_REQUEST_TYPE_ERROR;
+  } catch (const Ort::Exception& exc) {
+    // Model loading errors are converted above, anything else comes from inference.
+    logger.error("Inference failed: {} ---- Error: [{}]", exc.GetOrtErrorCode(), exc.what());
+    return INFERENCE_ERROR;
   } catch (std::exception& exc) {
-    logger->error("{}: Unexpected exception {}: {}", __func__, typeid(exc).name(), exc.what());
+    logger.error("{}: Unexpected exception {}: {}", __func__, typeid(exc).name(), exc.what());
     return UNKNOWN_ERROR;
   } catch (...) {
-    logger->error("{}: Unexpected non-std exception", __func__);
+    logger.error("{}: Unexpected non-std exception", __func__);
     return UNKNOWN_ERROR;
   }
   return SUCCESS;
@@ -280,12 +401,14 @@ extern "C" int EnclaveMaybeRefreshKey() {
 
   try {
     bool refreshed = confmsg_server->RefreshKey(sync_only);
+    GetEnclaveMetrics().RecordKeyRefresh(refreshed);
     if (refreshed) {
       logger->info("Key refreshed");
     } else {
       logger->info("Key up to date, not refreshed");
     }
   } catch (confmsg::KeyRefreshError& e) {
+    GetEnclaveMetrics().RecordKeyRefreshFailure();
     logger->error("Key refresh failed, will retry shortly -- Error: {}", e.what());
     return KEY_REFRESH_ERROR;
   } catch (std::exception& e) {
@@ -299,11 +422,57 @@ extern "C" int EnclaveMaybeRefreshKey() {
   return SUCCESS;
 }
 
+extern "C" void EnclaveCancelExpiredRuns() {
+  size_t terminated = GetRunWatchdog().TerminateExpired(RunWatchdog::Clock::now());
+  if (terminated > 0) {
+    GetEnclaveMetrics().RecordRunTerminated(terminated);
+  }
+}
+
+extern "C" void EnclaveSetTimingEnabled(bool enabled) {
+  GetEnclaveMetrics().SetTimingEnabled(enabled);
+}
+
+extern "C" uint64_t EnclaveGetLastInferenceTime() {
+  if (!GetEnclaveMetrics().IsTimingEnabled()) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(last_inference_time).count();
+}
+
+extern "C" int EnclaveGetStats(void* stats, size_t stats_size) {
+  if (stats_size != sizeof(EnclaveStats)) {
+    return UNKNOWN_ERROR;
+  }
+  GetEnclaveMetrics().Snapshot(*static_cast<EnclaveStats*>(stats));
+  return SUCCESS;
+}
+
+extern "C" int EnclaveSetLogRing(void* ring, size_t ring_size) {
+  if (env) {
+    return SESSION_ALREADY_INITIALIZED_ERROR;
+  }
+  uint64_t capacity;
+  if (!LogRingCapacity(ring_size, capacity)) {
+    return UNKNOWN_ERROR;
+  }
+#ifdef OE_BUILD_ENCLAVE
+  // Writing to enclave memory on behalf of the host must not be possible.
+  if (!oe_is_outside_enclave(ring, ring_size)) {
+    return UNKNOWN_ERROR;
+  }
+#endif
+  log_ring = std::make_unique<LogRingWriter>(ring, capacity);
+  return SUCCESS;
+}
+
 extern "C" int EnclaveDestroy() {
   delete confmsg_server;
   delete env;
   confmsg_server = nullptr;
   env = nullptr;
+  // The host frees the ring after this call.
+  log_ring.reset();
   CurlCleanup();
 #ifdef HAVE_LIBSKR
   skr_terminate();
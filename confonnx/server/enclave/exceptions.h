@@ -31,6 +31,16 @@ class ModelAlreadyInitializedError : public Error {
   explicit ModelAlreadyInitializedError() : Error("") {}
 };
 
+class ModelUpdateError : public Error {
+ public:
+  explicit ModelUpdateError(const std::string& msg) : Error(msg) {}
+};
+
+class ModelLoadingError : public Error {
+ public:
+  explicit ModelLoadingError(const std::string& msg) : Error(msg) {}
+};
+
 class PayloadParseError : public Error {
  public:
   explicit PayloadParseError(const std::string& msg) : Error(msg) {}
@@ -46,5 +56,10 @@ class InferenceError : public Error {
   explicit InferenceError(const std::string& msg) : Error(msg) {}
 };
 
+class DeadlineExceededError : public Error {
+ public:
+  explicit DeadlineExceededError(const std::string& msg) : Error(msg) {}
+};
+
 }  // namespace server
 }  // namespace onnxruntime
\ No newline at end of file
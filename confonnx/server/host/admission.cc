@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include "server/host/admission.h"
+
+namespace onnxruntime {
+namespace server {
+
+// Factor by which the limit shrinks when latency exceeds the tolerance.
+constexpr double kDecreaseFactor = 0.9;
+// Weight of a window's average when the baseline latency moves up. This only happens
+// at the minimum limit, where latency is not caused by overload, e.g. after a model update.
+constexpr double kBaselineRiseWeight = 0.05;
+
+void AdmissionController::Configure(const AdmissionOptions& options) {
+  options_ = options;
+  // The adaptive limit starts low, so that the baseline latency is measured without overload
+  limit_ = options.adaptive ? options.min_concurrency : options.max_concurrency;
+}
+
+AdmissionResult AdmissionController::Admit(/* out */ Ticket& ticket, std::chrono::steady_clock::time_point queued_since) {
+  if (!IsEnabled()) {
+    return AdmissionResult::Admitted;
+  }
+
+  // A request that waited this long for an I/O thread is likely given up on by
+  // its client already, and rejecting it lets the backlog drain.
+  if (options_.max_queue_time.count() > 0 && std::chrono::steady_clock::now() - queued_since > options_.max_queue_time) {
+    return AdmissionResult::QueueTimeout;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (in_flight_ >= limit_) {
+    window_saturated_ = true;
+    return AdmissionResult::LimitReached;
+  }
+  in_flight_++;
+  if (in_flight_ >= limit_) {
+    window_saturated_ = true;
+  }
+  ticket = Ticket(this);
+  return AdmissionResult::Admitted;
+}
+
+void AdmissionController::Release(std::chrono::nanoseconds latency) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  in_flight_--;
+  if (options_.adaptive) {
+    Adapt(latency);
+  }
+}
+
+void AdmissionController::Adapt(std::chrono::nanoseconds latency) {
+  window_sum_ns_ += static_cast<double>(latency.count());
+  if (++window_count_ < kWindowSize) {
+    return;
+  }
+
+  double average_ns = window_sum_ns_ / window_count_;
+  if (baseline_ns_ == 0 || average_ns < baseline_ns_) {
+    baseline_ns_ = average_ns;
+  } else if (limit_ <= options_.min_concurrency) {
+    baseline_ns_ += (average_ns - baseline_ns_) * kBaselineRiseWeight;
+  }
+
+  if (average_ns > baseline_ns_ * options_.latency_tolerance) {
+    limit_ = std::max(options_.min_concurrency, static_cast<int>(limit_ * kDecreaseFactor));
+  } else if (window_saturated_) {
+    // Only probe for more capacity if the current limit was actually used
+    limit_ = std::min(options_.max_concurrency, limit_ + 1);
+  }
+
+  window_count_ = 0;
+  window_sum_ns_ = 0;
+  window_saturated_ = false;
+}
+
+AdmissionStats AdmissionController::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return AdmissionStats{limit_, in_flight_};
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace onnxruntime {
+namespace server {
+
+struct AdmissionOptions {
+  // Requests in the enclave at the same time, 0 disables admission control.
+  int max_concurrency = 0;
+  // Requests that were queued on the server for longer than this after they
+  // were read are rejected, even if a slot is free. Zero disables the check.
+  std::chrono::milliseconds max_queue_time{1000};
+  // Adapts the limit between min_concurrency and max_concurrency to the observed
+  // ECALL latency: additive increase while latency is near its baseline,
+  // multiplicative decrease when it grows beyond latency_tolerance times the baseline.
+  bool adaptive = false;
+  int min_concurrency = 1;
+  double latency_tolerance = 2.0;
+  // Sent to rejected HTTP clients in the Retry-After header.
+  std::chrono::seconds retry_after{1};
+};
+
+enum class AdmissionResult {
+  Admitted,
+  LimitReached,
+  QueueTimeout
+};
+
+struct AdmissionStats {
+  int limit;
+  int in_flight;
+};
+
+/**
+ * Limits the number of requests that are handed to the enclave at the same time.
+ * Requests beyond the limit are rejected immediately instead of waiting, because
+ * they are handled on the I/O threads and a waiting request would block its thread.
+ * Requests already queued too long in the io_context after they were read are
+ * rejected as well, so that overload results in fast errors instead of requests
+ * piling up until clients time out.
+ */
+class AdmissionController {
+ public:
+  // Releases the slot of an admitted request on destruction.
+  class Ticket {
+   public:
+    Ticket() = default;
+    Ticket(Ticket&& other) noexcept : controller_(other.controller_), latency_(other.latency_) {
+      other.controller_ = nullptr;
+    }
+    Ticket(const Ticket&) = delete;
+    Ticket& operator=(const Ticket&) = delete;
+    Ticket& operator=(Ticket&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        controller_ = other.controller_;
+        latency_ = other.latency_;
+        other.controller_ = nullptr;
+      }
+      return *this;
+    }
+    ~Ticket() { Reset(); }
+
+    // Latency of the admitted work, used by the adaptive limit.
+    void SetLatency(std::chrono::nanoseconds latency) { latency_ = latency; }
+
+   private:
+    friend class AdmissionController;
+    explicit Ticket(AdmissionController* controller) : controller_(controller) {}
+
+    void Reset() {
+      if (controller_) {
+        controller_->Release(latency_);
+        controller_ = nullptr;
+      }
+    }
+
+    AdmissionController* controller_ = nullptr;
+    std::chrono::nanoseconds latency_{0};
+  };
+
+  AdmissionController() = default;
+  AdmissionController(const AdmissionController&) = delete;
+  AdmissionController& operator=(const AdmissionController&) = delete;
+
+  // Not thread-safe, call before requests are served.
+  void Configure(const AdmissionOptions& options);
+
+  bool IsEnabled() const { return options_.max_concurrency > 0; }
+  const AdmissionOptions& GetOptions() const { return options_; }
+
+  // Takes a free slot without waiting, queued_since is when the request was read.
+  // On success, ticket holds the slot.
+  AdmissionResult Admit(/* out */ Ticket& ticket, std::chrono::steady_clock::time_point queued_since);
+
+  AdmissionStats Stats();
+
+ private:
+  void Release(std::chrono::nanoseconds latency);
+
+  // Updates the adaptive limit with the latency of a finished request, with mutex_ held.
+  void Adapt(std::chrono::nanoseconds latency);
+
+  AdmissionOptions options_;
+
+  std::mutex mutex_;  // guards the members below
+  int limit_ = 0;
+  int in_flight_ = 0;
+
+  // State of the adaptive limit
+  static constexpr int kWindowSize = 32;
+  int window_count_ = 0;
+  double window_sum_ns_ = 0;
+  bool window_saturated_ = false;  // the limit was reached during the window
+  double baseline_ns_ = 0;         // latency without overload, 0 until measured
+};
+
+}  // namespace server
+}  // namespace onnxruntime
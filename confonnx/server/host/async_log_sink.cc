@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <spdlog/details/log_msg.h>
+#include <spdlog/fmt/fmt.h>
+
+#include "server/host/async_log_sink.h"
+
+namespace onnxruntime {
+namespace server {
+
+AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t queue_size, OverflowPolicy overflow_policy)
+    : sinks_(std::move(sinks)),
+      queue_size_(queue_size),
+      overflow_policy_(overflow_policy),
+      thread_(&AsyncLogSink::Run, this) {
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  Stop();
+}
+
+void AsyncLogSink::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) {
+      return;
+    }
+    stop_ = true;
+  }
+  not_empty_.notify_one();
+  thread_.join();
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg) {
+  Message message{msg.level, msg.time, msg.thread_id,
+                  std::string(msg.logger_name.data(), msg.logger_name.size()),
+                  std::string(msg.payload.data(), msg.payload.size())};
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= queue_size_ && !stop_) {
+      if (overflow_policy_ == OverflowPolicy::Drop) {
+        dropped_++;
+        return;
+      }
+      not_full_.wait(lock, [this]() { return stop_ || queue_.size() < queue_size_; });
+    }
+    if (stop_) {
+      // The background thread may still be writing its last batch, the wrapped sinks are thread-safe.
+      Write(message);
+      return;
+    }
+    queue_.push_back(std::move(message));
+  }
+  not_empty_.notify_one();
+}
+
+void AsyncLogSink::flush() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flush_requested_ = true;
+  }
+  not_empty_.notify_one();
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern) {
+  for (auto& sink : sinks_) {
+    sink->set_pattern(pattern);
+  }
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+  for (auto& sink : sinks_) {
+    sink->set_formatter(sink_formatter->clone());
+  }
+}
+
+void AsyncLogSink::Run() {
+  std::deque<Message> batch;
+  for (;;) {
+    uint64_t dropped;
+    bool flush;
+    bool stop;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this]() { return stop_ || flush_requested_ || !queue_.empty(); });
+      // Take the whole queue so that producers only contend for the swap.
+      batch.swap(queue_);
+      dropped = dropped_;
+      dropped_ = 0;
+      flush = flush_requested_;
+      flush_requested_ = false;
+      stop = stop_;
+    }
+    not_full_.notify_all();
+
+    for (const auto& message : batch) {
+      Write(message);
+    }
+    batch.clear();
+    if (dropped > 0) {
+      Write(Message{spdlog::level::warn, spdlog::log_clock::now(), 0, "AsyncLogSink",
+                    fmt::format("{} log messages dropped, queue full", dropped)});
+    }
+    if (flush || stop) {
+      for (auto& sink : sinks_) {
+        sink->flush();
+      }
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void AsyncLogSink::Write(const Message& message) {
+  spdlog::details::log_msg msg(message.logger_name, message.level, message.payload);
+  msg.time = message.time;
+  msg.thread_id = message.thread_id;
+  for (auto& sink : sinks_) {
+    if (sink->should_log(msg.level)) {
+      sink->log(msg);
+    }
+  }
+}
+
+}  // namespace server
+}  // namespace onnxruntime
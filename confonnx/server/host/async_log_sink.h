@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/sink.h>
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Hands log messages to a background thread that writes them to the wrapped
+ * sinks, so that request threads never wait on stdout or syslog.
+ * The queue is bounded: when it is full, messages either block the caller or
+ * are dropped and counted, the count is logged once there is room again.
+ * Queued messages are written and the sinks flushed by Stop() or on destruction.
+ */
+class AsyncLogSink final : public spdlog::sinks::sink {
+ public:
+  enum class OverflowPolicy {
+    Block,
+    Drop
+  };
+
+  AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t queue_size, OverflowPolicy overflow_policy);
+  ~AsyncLogSink() override;
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  void operator=(const AsyncLogSink&) = delete;
+
+  void log(const spdlog::details::log_msg& msg) override;
+  // Does not wait, the sinks are flushed after the queued messages are written.
+  void flush() override;
+  // Writes the queued messages, flushes the sinks and joins the background thread.
+  // Messages logged afterwards are written directly by the calling thread.
+  void Stop();
+  void set_pattern(const std::string& pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+ private:
+  // Owning copy of a log_msg, whose strings are only valid during log().
+  struct Message {
+    spdlog::level::level_enum level;
+    spdlog::log_clock::time_point time;
+    size_t thread_id;
+    std::string logger_name;
+    std::string payload;
+  };
+
+  void Run();
+  void Write(const Message& message);
+
+  const std::vector<spdlog::sink_ptr> sinks_;
+  const size_t queue_size_;
+  const OverflowPolicy overflow_policy_;
+
+  std::mutex mutex_;  // guards the members below
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<Message> queue_;
+  uint64_t dropped_ = 0;
+  bool flush_requested_ = false;
+  bool stop_ = false;
+
+  std::thread thread_;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
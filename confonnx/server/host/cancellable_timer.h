@@ -13,13 +13,14 @@ namespace server {
 
 class CancellableTimer {
  public:
+  // Returns immediately if the timer is cancelled, also if that happened before the call.
   template <class R, class P>
   void wait_for(const std::chrono::duration<R, P>& duration) {
+    std::unique_lock<std::mutex> lock(m);
     if (cancelled_) {
-      throw std::logic_error("timer already cancelled");
+      return;
     }
     start_time = std::chrono::system_clock::now();
-    std::unique_lock<std::mutex> lock(m);
     cv.wait_for(lock, duration, [&] {
       if (cancelled_) {
         return true;
@@ -38,6 +39,7 @@ class CancellableTimer {
   }
 
   bool cancelled() {
+    std::unique_lock<std::mutex> lock(m);
     return cancelled_;
   }
 
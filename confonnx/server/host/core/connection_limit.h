@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace onnxruntime {
+namespace server {
+
+// Limits the connections that are open at the same time across all listeners,
+// so that idle or slow clients cannot use up file descriptors and session memory.
+class ConnectionLimit : public std::enable_shared_from_this<ConnectionLimit> {
+ public:
+  // Counts one open connection until destroyed.
+  class Slot {
+   public:
+    Slot() = default;
+    Slot(Slot&& other) noexcept : limit_(std::move(other.limit_)) {}
+    Slot& operator=(Slot&& other) noexcept {
+      if (this != &other) {
+        Release();
+        limit_ = std::move(other.limit_);
+      }
+      return *this;
+    }
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+    ~Slot() { Release(); }
+
+   private:
+    friend class ConnectionLimit;
+    explicit Slot(std::shared_ptr<ConnectionLimit> limit) : limit_(std::move(limit)) {}
+
+    void Release() {
+      if (limit_) {
+        limit_->open_.fetch_sub(1, std::memory_order_relaxed);
+        limit_.reset();
+      }
+    }
+
+    std::shared_ptr<ConnectionLimit> limit_;
+  };
+
+  // 0 means no limit.
+  explicit ConnectionLimit(size_t max_connections) : max_connections_(max_connections) {}
+
+  // Returns false if the limit is reached, otherwise slot counts the new connection.
+  bool TryAcquire(/* out */ Slot& slot) {
+    size_t open = open_.fetch_add(1, std::memory_order_relaxed);
+    if (max_connections_ > 0 && open >= max_connections_) {
+      open_.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+    slot = Slot(shared_from_this());
+    return true;
+  }
+
+  size_t GetOpenConnections() const { return open_.load(std::memory_order_relaxed); }
+
+ private:
+  const size_t max_connections_;
+  std::atomic<size_t> open_{0};
+};
+
+}  // namespace server
+}  // namespace onnxruntime
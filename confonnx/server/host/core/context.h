@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
 
 #include <boost/beast/http.hpp>
+#include "pooled_body.h"
 #include "request_id.h"
 
 namespace onnxruntime {
@@ -18,14 +20,21 @@ namespace http = boost::beast::http;  // from <boost/beast/http.hpp>
 // But in the future we should write a wrapper around them
 class HttpContext {
  public:
-  http::request<http::string_body, http::basic_fields<std::allocator<char>>> request{};
-  http::response<http::string_body> response{};
+  http::request<PooledBody, http::basic_fields<std::allocator<char>>> request{};
+  http::response<PooledBody> response{};
 
   const std::string request_id;
   std::string client_request_id;
   http::status error_code;
   std::string error_message;
 
+  // Set by HttpSession for request metrics. read_start is when the request
+  // header has been read, read_end when the body has been read and
+  // handler_start when the request was handed to the route.
+  std::chrono::steady_clock::time_point read_start;
+  std::chrono::steady_clock::time_point read_end;
+  std::chrono::steady_clock::time_point handler_start;
+
   HttpContext() : request_id(util::InternalRequestId()),
                   client_request_id(""),
                   error_code(http::status::internal_server_error),
@@ -1,11 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <csignal>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <vector>
+#include <pthread.h>
+#include <sched.h>
 #include <boost/asio.hpp>
 #include <boost/beast/http.hpp>
 
@@ -25,7 +28,58 @@ namespace server {
 App::App() {
   http_details.address = boost::asio::ip::make_address_v4("0.0.0.0");
   http_details.port = 8001;
+  http_details.listen_tcp = true;
+  http_details.unix_socket_mode = 0660;
+  http_details.rpc_port = 0;
   http_details.threads = std::thread::hardware_concurrency();
+  http_details.max_connections = 0;
+  http_details.reuse_port = false;
+  http_details.pin_threads = false;
+}
+
+// Pins the calling thread to the index-th CPU the process may run on, wrapping around.
+static void PinThread(int index) {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+    return;
+  }
+  int target = index % CPU_COUNT(&allowed);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &allowed) && target-- == 0) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpu, &cpuset);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+      return;
+    }
+  }
+}
+
+template <typename Protocol>
+static typename BasicListener<Protocol>::ConnectionFn HttpSessions(std::shared_ptr<const Routes> routes, const HttpSessionOptions& options) {
+  return [routes = std::move(routes), options](typename Protocol::socket&& socket, ConnectionLimit::Slot&& connection) {
+    std::make_shared<BasicHttpSession<Protocol>>(routes, options, std::move(socket), std::move(connection))->Run();
+  };
+}
+
+static Listener::ConnectionFn RpcSessions(std::shared_ptr<const RpcHandlerFn> handler, const RpcOptions& options) {
+  return [handler = std::move(handler), options](tcp::socket&& socket, ConnectionLimit::Slot&& connection) {
+    std::make_shared<RpcSession>(handler, options, std::move(socket), std::move(connection))->Run();
+  };
+}
+
+template <typename Protocol>
+static void StartListener(const std::shared_ptr<BasicListener<Protocol>>& listener) {
+  auto initialized = listener->Init();
+  if (!initialized) {
+    exit(EXIT_FAILURE);
+  }
+
+  auto started = listener->Run();
+  if (!started) {
+    exit(EXIT_FAILURE);
+  }
 }
 
 App& App::Bind(net::ip::address address, unsigned short port) {
@@ -34,54 +88,149 @@ App& App::Bind(net::ip::address address, unsigned short port) {
   return *this;
 }
 
+App& App::BindUnix(const std::string& path, int mode) {
+  http_details.unix_socket = path;
+  http_details.unix_socket_mode = mode;
+  return *this;
+}
+
+App& App::ListenTcp(bool listen_tcp) {
+  http_details.listen_tcp = listen_tcp;
+  return *this;
+}
+
 App& App::NumThreads(int threads) {
   http_details.threads = threads;
   return *this;
 }
 
+App& App::ReusePort(bool reuse_port) {
+  http_details.reuse_port = reuse_port;
+  return *this;
+}
+
+App& App::PinThreads(bool pin_threads) {
+  http_details.pin_threads = pin_threads;
+  return *this;
+}
+
+App& App::HttpOptions(const HttpSessionOptions& options) {
+  http_options_ = options;
+  return *this;
+}
+
+App& App::MaxConnections(size_t max_connections) {
+  http_details.max_connections = max_connections;
+  return *this;
+}
+
 App& App::RegisterStartup(const StartFn& on_start) {
   on_start_ = on_start;
   return *this;
 }
 
+App& App::RegisterGet(const std::string& route, const HandlerFn& fn) {
+  routes_->RegisterController(http::verb::get, route, fn);
+  return *this;
+}
+
 App& App::RegisterPost(const std::string& route, const HandlerFn& fn) {
-  routes_.RegisterController(http::verb::post, route, fn);
+  routes_->RegisterController(http::verb::post, route, fn);
   return *this;
 }
 
 App& App::RegisterError(const ErrorFn& fn) {
-  routes_.RegisterErrorCallback(fn);
+  routes_->RegisterErrorCallback(fn);
   return *this;
 }
 
-App& App::Run() {
-  net::io_context ioc{http_details.threads};
-  // Create and launch a listening port
-  auto listener = std::make_shared<Listener>(routes_, ioc, tcp::endpoint{http_details.address, http_details.port});
+App& App::RegisterCompletion(const CompletionFn& fn) {
+  routes_->RegisterCompletionCallback(fn);
+  return *this;
+}
 
-  auto initialized = listener->Init();
-  if (!initialized) {
-    exit(EXIT_FAILURE);
+App& App::RegisterRpc(unsigned short port, const RpcHandlerFn& fn, const RpcOptions& options) {
+  http_details.rpc_port = port;
+  rpc_handler_ = std::make_shared<const RpcHandlerFn>(fn);
+  rpc_options_ = options;
+  return *this;
+}
+
+App& App::Run() {
+  // Either one io_context shared by all threads, or with reuse_port one io_context
+  // and listener per thread so that a connection is served by a single thread.
+  int num_contexts = http_details.reuse_port ? http_details.threads : 1;
+  int concurrency_hint = http_details.reuse_port ? 1 : http_details.threads;
+  std::vector<std::unique_ptr<net::io_context>> contexts;
+  contexts.reserve(num_contexts);
+  auto connections = std::make_shared<ConnectionLimit>(http_details.max_connections);
+  for (auto i = 0; i < num_contexts; ++i) {
+    contexts.push_back(std::make_unique<net::io_context>(concurrency_hint));
+
+    // Create and launch a listening port
+    if (http_details.listen_tcp) {
+      StartListener(std::make_shared<Listener>(HttpSessions<tcp>(routes_, http_options_), connections, *contexts.back(),
+                                               tcp::endpoint{http_details.address, http_details.port},
+                                               http_details.reuse_port));
+    }
+    if (rpc_handler_) {
+      StartListener(std::make_shared<Listener>(RpcSessions(rpc_handler_, rpc_options_), connections, *contexts.back(),
+                                               tcp::endpoint{http_details.address, http_details.rpc_port},
+                                               http_details.reuse_port));
+    }
   }
 
-  auto started = listener->Run();
-  if (!started) {
-    exit(EXIT_FAILURE);
+  // A Unix domain socket path can only be bound once, the first io_context accepts
+  // its connections and hands them to all io_contexts in turn.
+  if (!http_details.unix_socket.empty()) {
+    auto listener = std::make_shared<LocalListener>(HttpSessions<local>(routes_, http_options_), connections, *contexts.front(),
+                                                    local::endpoint{http_details.unix_socket},
+                                                    false, http_details.unix_socket_mode);
+    std::vector<net::io_context*> session_contexts;
+    for (auto& ioc : contexts) {
+      session_contexts.push_back(ioc.get());
+    }
+    listener->DistributeSessions(std::move(session_contexts));
+    StartListener(listener);
   }
 
+  // Stop all io_contexts on SIGINT or SIGTERM, so that Run() returns and the
+  // caller can shut down in order.
+  net::signal_set signals(*contexts.front(), SIGINT, SIGTERM);
+  signals.async_wait(
+      [&contexts](const boost::system::error_code& ec, int) {
+        if (ec) {
+          return;
+        }
+        for (auto& ioc : contexts) {
+          ioc->stop();
+        }
+      });
+
   // Run user on_start function
   on_start_(http_details);
 
   // Run the I/O service on the requested number of threads
+  bool pin_threads = http_details.pin_threads;
   std::vector<std::thread> v;
   v.reserve(http_details.threads - 1);
   for (auto i = http_details.threads - 1; i > 0; --i) {
+    net::io_context& ioc = *contexts[i % num_contexts];
     v.emplace_back(
-        [&ioc] {
+        [&ioc, i, pin_threads] {
+          if (pin_threads) {
+            PinThread(i);
+          }
           ioc.run();
         });
   }
-  ioc.run();
+  if (pin_threads) {
+    PinThread(0);
+  }
+  contexts[0]->run();
+  for (auto& t : v) {
+    t.join();
+  }
   return *this;
 }
 }  // namespace server
@@ -15,6 +15,7 @@
 #include "routes.h"
 #include "session.h"
 #include "listener.h"
+#include "rpc_session.h"
 
 namespace onnxruntime {
 namespace server {
@@ -26,7 +27,14 @@ using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
 struct Details {
   net::ip::address address;
   unsigned short port;
+  bool listen_tcp;
+  std::string unix_socket;  // empty if not listening on a Unix domain socket
+  int unix_socket_mode;
+  unsigned short rpc_port;  // 0 if the binary RPC transport is disabled
   int threads;
+  size_t max_connections;  // 0 if unlimited
+  bool reuse_port;
+  bool pin_threads;
 };
 
 using StartFn = std::function<void(Details&)>;
@@ -38,14 +46,34 @@ class App {
   App();
 
   App& Bind(net::ip::address address, unsigned short port);
+  // Additionally listen on a Unix domain socket, with the given permission bits of the socket file.
+  App& BindUnix(const std::string& path, int mode);
+  // Whether to listen on the TCP endpoint, allows serving on a Unix domain socket only.
+  App& ListenTcp(bool listen_tcp);
   App& NumThreads(int threads);
+  // Run one io_context and SO_REUSEPORT acceptor per thread instead of sharing one between all threads.
+  App& ReusePort(bool reuse_port);
+  // Pin each I/O thread to one CPU of the process affinity mask.
+  App& PinThreads(bool pin_threads);
+  App& HttpOptions(const HttpSessionOptions& options);
+  // Connections open at the same time over all listeners, including RPC, 0 is unlimited.
+  App& MaxConnections(size_t max_connections);
   App& RegisterStartup(const StartFn& fn);
+  App& RegisterGet(const std::string& route, const HandlerFn& fn);
   App& RegisterPost(const std::string& route, const HandlerFn& fn);
   App& RegisterError(const ErrorFn& fn);
+  App& RegisterCompletion(const CompletionFn& fn);
+  // Serve the binary RPC transport (see rpc_session.h) on a separate TCP port of the bound address.
+  App& RegisterRpc(unsigned short port, const RpcHandlerFn& fn, const RpcOptions& options);
+  // Serves until SIGINT or SIGTERM is received.
   App& Run();
 
  private:
-  Routes routes_{};
+  // Shared read-only with the listener and all sessions once running.
+  std::shared_ptr<Routes> routes_ = std::make_shared<Routes>();
+  std::shared_ptr<const RpcHandlerFn> rpc_handler_;
+  HttpSessionOptions http_options_{};
+  RpcOptions rpc_options_{};
   StartFn on_start_ = {};
   Details http_details{};
 };
@@ -1,8 +1,11 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <sys/stat.h>
+#include <unistd.h>
+#include <type_traits>
+
 #include "listener.h"
-#include "session.h"
 #include "util.h"
 
 namespace onnxruntime {
@@ -11,12 +14,48 @@ namespace server {
 namespace net = boost::asio;       // from <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
 
-Listener::Listener(const Routes& routes, net::io_context& ioc, const tcp::endpoint& endpoint)
-    : routes_(routes), acceptor_(ioc), socket_(ioc), endpoint_(endpoint) {
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+// Removes the socket file a previous run of the server left behind.
+// Fails if the path exists but is not a socket, so that no other file gets deleted.
+static bool RemoveStaleSocket(const std::string& path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) {
+    return true;
+  }
+  if (!S_ISSOCK(st.st_mode)) {
+    ErrorHandling(beast::error_code(EEXIST, beast::system_category()), "remove stale socket");
+    return false;
+  }
+  if (unlink(path.c_str()) != 0) {
+    ErrorHandling(beast::error_code(errno, beast::system_category()), "remove stale socket");
+    return false;
+  }
+  return true;
 }
 
-bool Listener::Init() {
+template <typename Protocol>
+BasicListener<Protocol>::BasicListener(ConnectionFn on_connection, std::shared_ptr<ConnectionLimit> connections,
+                                       net::io_context& ioc, const endpoint_type& endpoint,
+                                       bool reuse_port, int socket_mode)
+    : on_connection_(std::move(on_connection)), connections_(std::move(connections)), ioc_(ioc), acceptor_(ioc), endpoint_(endpoint), reuse_port_(reuse_port), socket_mode_(socket_mode) {
+}
+
+template <typename Protocol>
+void BasicListener<Protocol>::DistributeSessions(std::vector<net::io_context*> contexts) {
+  session_contexts_ = std::move(contexts);
+}
+
+template <typename Protocol>
+bool BasicListener<Protocol>::Init() {
   beast::error_code ec;
+  constexpr bool is_local = std::is_same<Protocol, local>::value;
+
+  if constexpr (is_local) {
+    if (!RemoveStaleSocket(endpoint_.path())) {
+      return false;
+    }
+  }
 
   // Open the acceptor
   acceptor_.open(endpoint_.protocol(), ec);
@@ -25,11 +64,22 @@ bool Listener::Init() {
     return false;
   }
 
-  // Allow address reuse
-  acceptor_.set_option(net::socket_base::reuse_address(true), ec);
-  if (ec) {
-    ErrorHandling(ec, "set_option");
-    return false;
+  if constexpr (!is_local) {
+    // Allow address reuse
+    acceptor_.set_option(net::socket_base::reuse_address(true), ec);
+    if (ec) {
+      ErrorHandling(ec, "set_option");
+      return false;
+    }
+
+    // Allow other listeners to bind the same port
+    if (reuse_port_) {
+      acceptor_.set_option(reuse_port(true), ec);
+      if (ec) {
+        ErrorHandling(ec, "set_option");
+        return false;
+      }
+    }
   }
 
   // Bind to the routes address
@@ -39,6 +89,14 @@ bool Listener::Init() {
     return false;
   }
 
+  // Restrict who may connect to the socket file
+  if constexpr (is_local) {
+    if (chmod(endpoint_.path().c_str(), static_cast<mode_t>(socket_mode_)) != 0) {
+      ErrorHandling(beast::error_code(errno, beast::system_category()), "chmod");
+      return false;
+    }
+  }
+
   // Start listening for connections
   acceptor_.listen(
       net::socket_base::max_listen_connections, ec);
@@ -50,7 +108,8 @@ bool Listener::Init() {
   return true;
 }
 
-bool Listener::Run() {
+template <typename Protocol>
+bool BasicListener<Protocol>::Run() {
   if (!acceptor_.is_open()) {
     return false;
   }
@@ -59,24 +118,39 @@ bool Listener::Run() {
   return true;
 }
 
-void Listener::DoAccept() {
+template <typename Protocol>
+void BasicListener<Protocol>::DoAccept() {
+  // Only one accept is pending at a time, so next_session_context_ needs no synchronization.
+  net::io_context& session_ioc = session_contexts_.empty()
+                                     ? ioc_
+                                     : *session_contexts_[next_session_context_++ % session_contexts_.size()];
   acceptor_.async_accept(
-      socket_,
+      session_ioc,
       std::bind(
-          &Listener::OnAccept,
-          shared_from_this(),
-          std::placeholders::_1));
+          &BasicListener::OnAccept,
+          this->shared_from_this(),
+          std::placeholders::_1,
+          std::placeholders::_2));
 }
 
-void Listener::OnAccept(beast::error_code ec) {
+template <typename Protocol>
+void BasicListener<Protocol>::OnAccept(beast::error_code ec, socket_type socket) {
+  ConnectionLimit::Slot connection;
   if (ec) {
     ErrorHandling(ec, "accept");
+  } else if (!connections_->TryAcquire(connection)) {
+    // Not logged, this happens a lot under abusive traffic
+    socket.close(ec);
   } else {
-    std::make_shared<HttpSession>(routes_, std::move(socket_))->Run();
+    on_connection_(std::move(socket), std::move(connection));
   }
 
   // Accept another connection
   DoAccept();
 }
+
+template class BasicListener<tcp>;
+template class BasicListener<local>;
+
 }  // namespace server
-}  // namespace onnxruntime
\ No newline at end of file
+}  // namespace onnxruntime
@@ -3,11 +3,15 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 
-#include "routes.h"
+#include "connection_limit.h"
 #include "util.h"
 
 namespace onnxruntime {
@@ -15,16 +19,44 @@ namespace server {
 
 namespace net = boost::asio;       // from <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
+using local = boost::asio::local::stream_protocol;
 
-// Listens on a socket and creates an HTTP session
-class Listener : public std::enable_shared_from_this<Listener> {
-  Routes routes_;
-  tcp::acceptor acceptor_;
-  tcp::socket socket_;
-  const tcp::endpoint endpoint_;
+// Listens on a socket and hands accepted connections to a session, e.g. HttpSession
+// Instantiated for TCP and Unix domain sockets, see Listener and LocalListener.
+template <typename Protocol>
+class BasicListener : public std::enable_shared_from_this<BasicListener<Protocol>> {
+ public:
+  using acceptor_type = typename Protocol::acceptor;
+  using socket_type = typename Protocol::socket;
+  using endpoint_type = typename Protocol::endpoint;
+
+  // Takes over an accepted connection, usually by creating and running a session for it.
+  // The connection counts against the connection limit as long as the slot exists.
+  using ConnectionFn = std::function<void(socket_type&&, ConnectionLimit::Slot&&)>;
+
+ private:
+  const ConnectionFn on_connection_;
+  const std::shared_ptr<ConnectionLimit> connections_;
+  net::io_context& ioc_;
+  acceptor_type acceptor_;
+  std::vector<net::io_context*> session_contexts_;
+  size_t next_session_context_ = 0;
+  const endpoint_type endpoint_;
+  const bool reuse_port_;
+  const int socket_mode_;
 
  public:
-  Listener(const Routes& routes, net::io_context& ioc, const tcp::endpoint& endpoint);
+  // With reuse_port, several TCP listeners can bind the same endpoint (SO_REUSEPORT)
+  // and the kernel distributes incoming connections between them.
+  // For Unix domain sockets, socket_mode are the permission bits of the socket file.
+  // Connections beyond the limit, which may be shared with other listeners, are closed right away.
+  BasicListener(ConnectionFn on_connection, std::shared_ptr<ConnectionLimit> connections,
+                net::io_context& ioc, const endpoint_type& endpoint,
+                bool reuse_port = false, int socket_mode = 0660);
+
+  // Serve accepted connections on these io_contexts in turn instead of on the listener's.
+  // Must be called before Run().
+  void DistributeSessions(std::vector<net::io_context*> contexts);
 
   // Initialize the HTTP server
   bool Init();
@@ -35,9 +67,15 @@ class Listener : public std::enable_shared_from_this<Listener> {
   // Asynchronously accepts the socket
   void DoAccept();
 
-  // Creates the HTTP session and runs it
-  void OnAccept(beast::error_code ec);
+  // Hands the connection to on_connection unless the connection limit is reached
+  void OnAccept(beast::error_code ec, socket_type socket);
 };
 
+using Listener = BasicListener<tcp>;
+using LocalListener = BasicListener<local>;
+
+extern template class BasicListener<tcp>;
+extern template class BasicListener<local>;
+
 }  // namespace server
 }  // namespace onnxruntime
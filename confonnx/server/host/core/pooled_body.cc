@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "pooled_body.h"
+
+namespace onnxruntime {
+namespace server {
+
+BufferPool& BufferPool::Instance() {
+  static BufferPool pool;
+  return pool;
+}
+
+size_t BufferPool::SizeClass(size_t capacity) {
+  size_t bits = kMinCapacityBits;
+  while ((size_t(1) << bits) < capacity) {
+    bits++;
+  }
+  return bits - kMinCapacityBits;
+}
+
+BufferPool::Storage BufferPool::Acquire(size_t min_capacity) {
+  if (min_capacity > kMaxPooledCapacity) {
+    return Storage{std::unique_ptr<uint8_t[]>(new uint8_t[min_capacity]), min_capacity};
+  }
+  size_t size_class = SizeClass(min_capacity);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& free = free_[size_class];
+    if (!free.empty()) {
+      Storage storage = std::move(free.back());
+      free.pop_back();
+      pooled_bytes_ -= storage.capacity;
+      return storage;
+    }
+  }
+  size_t capacity = size_t(1) << (size_class + kMinCapacityBits);
+  return Storage{std::unique_ptr<uint8_t[]>(new uint8_t[capacity]), capacity};
+}
+
+void BufferPool::Release(Storage storage) {
+  // Only exact size class capacities are pooled, see Acquire.
+  if (storage.capacity > kMaxPooledCapacity ||
+      storage.capacity != size_t(1) << (SizeClass(storage.capacity) + kMinCapacityBits)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pooled_bytes_ + storage.capacity > kMaxPooledBytes) {
+    return;
+  }
+  pooled_bytes_ += storage.capacity;
+  free_[SizeClass(storage.capacity)].push_back(std::move(storage));
+}
+
+void PooledBuffer::reserve(size_t capacity) {
+  if (capacity <= storage_.capacity) {
+    return;
+  }
+  BufferPool::Storage storage = BufferPool::Instance().Acquire(capacity);
+  if (size_ > 0) {
+    std::memcpy(storage.data.get(), storage_.data.get(), size_);
+  }
+  std::swap(storage, storage_);
+  if (storage.capacity > 0) {
+    BufferPool::Instance().Release(std::move(storage));
+  }
+}
+
+void PooledBuffer::shrink_to_fit() {
+  if (size_ == 0) {
+    clear();
+    return;
+  }
+  if (size_ > storage_.capacity / kShrinkRatio) {
+    return;
+  }
+  BufferPool::Storage storage = BufferPool::Instance().Acquire(size_);
+  std::memcpy(storage.data.get(), storage_.data.get(), size_);
+  std::swap(storage, storage_);
+  BufferPool::Instance().Release(std::move(storage));
+}
+
+void PooledBuffer::clear() {
+  size_ = 0;
+  if (storage_.capacity > 0) {
+    BufferPool::Instance().Release(std::move(storage_));
+    storage_.capacity = 0;
+  }
+}
+
+}  // namespace server
+}  // namespace onnxruntime
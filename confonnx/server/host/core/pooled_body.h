@@ -0,0 +1,199 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+
+namespace onnxruntime {
+namespace server {
+
+namespace net = boost::asio;          // from <boost/asio.hpp>
+namespace beast = boost::beast;       // from <boost/beast.hpp>
+namespace http = boost::beast::http;  // from <boost/beast/http.hpp>
+
+/**
+ * Recycles body buffers by power-of-two size class, so that bodies of
+ * similar size do not go to the allocator (and zero fill) on every request.
+ * Buffers larger than kMaxPooledCapacity and buffers beyond the byte budget
+ * are freed instead.
+ */
+class BufferPool {
+ public:
+  struct Storage {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity = 0;
+  };
+
+  static BufferPool& Instance();
+
+  // Returns uninitialized storage of at least min_capacity bytes.
+  Storage Acquire(size_t min_capacity);
+  void Release(Storage storage);
+
+ private:
+  static constexpr size_t kMinCapacityBits = 12;  // 4 KiB
+  static constexpr size_t kMaxCapacityBits = 26;  // 64 MiB
+  static constexpr size_t kMaxPooledCapacity = size_t(1) << kMaxCapacityBits;
+  static constexpr size_t kMaxPooledBytes = size_t(256) << 20;
+
+  static size_t SizeClass(size_t capacity);
+
+  std::mutex mutex_;  // guards the members below
+  std::vector<Storage> free_[kMaxCapacityBits - kMinCapacityBits + 1];
+  size_t pooled_bytes_ = 0;
+};
+
+/**
+ * Byte buffer backed by BufferPool, used as value of PooledBody.
+ * Move-only, the storage goes back to the pool on destruction.
+ */
+class PooledBuffer {
+ public:
+  PooledBuffer() = default;
+  ~PooledBuffer() { clear(); }
+
+  PooledBuffer(PooledBuffer&& other) noexcept
+      : storage_(std::move(other.storage_)), size_(other.size_) {
+    other.storage_.capacity = 0;
+    other.size_ = 0;
+  }
+
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+      clear();
+      storage_ = std::move(other.storage_);
+      size_ = other.size_;
+      other.storage_.capacity = 0;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  PooledBuffer(const PooledBuffer&) = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  uint8_t* data() { return storage_.data.get(); }
+  const uint8_t* data() const { return storage_.data.get(); }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return storage_.capacity; }
+
+  // Ensures room for capacity bytes, keeping the contents.
+  void reserve(size_t capacity);
+
+  // Changes the size, keeping the contents. New bytes are uninitialized.
+  void resize(size_t size) {
+    if (size > storage_.capacity) {
+      reserve(std::max(size, storage_.capacity * 2));
+    }
+    size_ = size;
+  }
+
+  void assign(const void* data, size_t size) {
+    resize(size);
+    if (size > 0) {
+      std::memcpy(storage_.data.get(), data, size);
+    }
+  }
+
+  void assign(const std::string& str) { assign(str.data(), str.size()); }
+
+  // Copy of the contents, for diagnostics.
+  std::string str() const { return std::string(reinterpret_cast<const char*>(data()), size_); }
+
+  // Returns the storage to the pool.
+  void clear();
+
+  // Moves the contents into a smaller buffer if they use at most 1/kShrinkRatio of the
+  // capacity, so that the large buffer goes back to the pool. Only small contents are copied.
+  void shrink_to_fit();
+
+ private:
+  static constexpr size_t kShrinkRatio = 16;
+
+  BufferPool::Storage storage_;
+  size_t size_ = 0;
+};
+
+/**
+ * Beast body whose buffer comes from BufferPool. Requests with Content-Length
+ * are read into a buffer of that size without reallocation, and handlers pass
+ * the buffers to and from the enclave without intermediate copies.
+ */
+struct PooledBody {
+  using value_type = PooledBuffer;
+
+  static std::uint64_t size(const value_type& body) {
+    return body.size();
+  }
+
+  // Parses a body into the buffer.
+  class reader {
+   public:
+    template <bool isRequest, class Fields>
+    explicit reader(http::header<isRequest, Fields>&, value_type& body) : body_(body) {}
+
+    void init(const boost::optional<std::uint64_t>& content_length, beast::error_code& ec) {
+      body_.resize(0);
+      if (content_length) {
+        // The parser checked the length against the body limit already, and the
+        // session's body timeout bounds how long a client can hold the buffer.
+        body_.reserve(static_cast<size_t>(*content_length));
+      }
+      ec = {};
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t put(const ConstBufferSequence& buffers, beast::error_code& ec) {
+      size_t n = net::buffer_size(buffers);
+      size_t offset = body_.size();
+      body_.resize(offset + n);
+      ec = {};
+      return net::buffer_copy(net::buffer(body_.data() + offset, n), buffers);
+    }
+
+    void finish(beast::error_code& ec) {
+      ec = {};
+    }
+
+   private:
+    value_type& body_;
+  };
+
+  // Serializes the buffer in one piece.
+  class writer {
+   public:
+    using const_buffers_type = net::const_buffer;
+
+    template <bool isRequest, class Fields>
+    explicit writer(const http::header<isRequest, Fields>&, const value_type& body) : body_(body) {}
+
+    void init(beast::error_code& ec) {
+      ec = {};
+    }
+
+    boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+      ec = {};
+      return {{const_buffers_type(body_.data(), body_.size()), false}};
+    }
+
+   private:
+    const value_type& body_;
+  };
+};
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -6,6 +6,7 @@
 // See: https://github.com/boostorg/random/issues/49
 #define BOOST_PENDING_INTEGER_LOG2_HPP
 #include <boost/integer/integer_log2.hpp>
+#include <boost/random/mersenne_twister.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -14,7 +15,10 @@ namespace onnxruntime {
 namespace server {
 namespace util {
 std::string InternalRequestId() {
-  return boost::uuids::to_string(boost::uuids::random_generator()());
+  // Seeded from the OS entropy source once per thread instead of once per request.
+  // The mt19937 state is large enough for random version 4 UUIDs.
+  thread_local boost::uuids::basic_random_generator<boost::mt19937> generator;
+  return boost::uuids::to_string(generator());
 }
 const std::string MS_REQUEST_ID_HEADER = "x-ms-request-id";
 const std::string MS_CLIENT_REQUEST_ID_HEADER = "x-ms-client-request-id";
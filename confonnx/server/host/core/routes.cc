@@ -2,7 +2,6 @@
 // Licensed under the MIT License.
 
 #include <iostream>
-#include "re2/re2.h"
 
 #include "context.h"
 #include "routes.h"
@@ -12,6 +11,11 @@ namespace server {
 
 namespace http = boost::beast::http;  // from <boost/beast/http.hpp>
 
+// Patterns without regex syntax are matched by a hash lookup.
+static bool IsPlainPath(const std::string& url_pattern) {
+  return url_pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+}
+
 bool Routes::RegisterController(http::verb method, const std::string& url_pattern, const HandlerFn& controller) {
   if (controller == nullptr) {
     return false;
@@ -19,16 +23,35 @@ bool Routes::RegisterController(http::verb method, const std::string& url_patter
 
   switch (method) {
     case http::verb::get:
-      this->get_fn_table.emplace_back(url_pattern, controller);
-      return true;
+      return Register(this->get_fn_table, url_pattern, controller);
     case http::verb::post:
-      this->post_fn_table.emplace_back(url_pattern, controller);
-      return true;
+      return Register(this->post_fn_table, url_pattern, controller);
     default:
       return false;
   }
 }
 
+bool Routes::Register(Table& table, const std::string& url_pattern, const HandlerFn& controller) {
+  std::unique_ptr<re2::RE2> regex;
+  if (!IsPlainPath(url_pattern)) {
+    regex = std::make_unique<re2::RE2>(url_pattern, re2::RE2::Quiet);
+    if (!regex->ok()) {
+      return false;
+    }
+  }
+
+  size_t index = table.routes.size();
+  table.routes.push_back(Route{url_pattern, std::move(regex), controller});
+  const Route& route = table.routes.back();
+  if (route.regex) {
+    table.regex_routes.push_back(index);
+  } else {
+    // An earlier registration of the same path wins.
+    table.exact_routes.emplace(route.pattern, index);
+  }
+  return true;
+}
+
 bool Routes::RegisterErrorCallback(const ErrorFn& controller) {
   if (controller == nullptr) {
     return false;
@@ -38,36 +61,57 @@ bool Routes::RegisterErrorCallback(const ErrorFn& controller) {
   return true;
 }
 
+bool Routes::RegisterCompletionCallback(const CompletionFn& callback) {
+  if (callback == nullptr) {
+    return false;
+  }
+
+  on_complete = callback;
+  return true;
+}
+
+const HandlerFn* Routes::Match(const Table& table, std::string_view url) {
+  auto exact = table.exact_routes.find(url);
+  size_t exact_index = exact == table.exact_routes.end() ? table.routes.size() : exact->second;
+
+  // Only regex routes registered before the exact match can take precedence.
+  re2::StringPiece input(url.data(), url.size());
+  for (size_t index : table.regex_routes) {
+    if (index > exact_index) {
+      break;
+    }
+    if (re2::RE2::FullMatch(input, *table.routes[index].regex)) {
+      return &table.routes[index].handler;
+    }
+  }
+
+  if (exact_index < table.routes.size()) {
+    return &table.routes[exact_index].handler;
+  }
+  return nullptr;
+}
+
 http::status Routes::ParseUrl(http::verb method,
-                              const std::string& url,
-                              /* out */ HandlerFn& func) const {
-  std::vector<std::pair<std::string, HandlerFn>> func_table;
+                              std::string_view url,
+                              /* out */ const HandlerFn*& func) const {
+  const Table* func_table;
   switch (method) {
     case http::verb::get:
-      func_table = this->get_fn_table;
+      func_table = &this->get_fn_table;
       break;
     case http::verb::post:
-      func_table = this->post_fn_table;
+      func_table = &this->post_fn_table;
       break;
     default:
       return http::status::method_not_allowed;
   }
 
-  if (func_table.empty()) {
+  if (func_table->routes.empty()) {
     return http::status::method_not_allowed;
   }
 
-  bool found_match = false;
-  for (const auto& pattern : func_table) {
-    if (re2::RE2::FullMatch(url, pattern.first)) {
-      func = pattern.second;
-
-      found_match = true;
-      break;
-    }
-  }
-
-  if (!found_match) {
+  func = Match(*func_table, url);
+  if (func == nullptr) {
     return http::status::not_found;
   }
 
@@ -75,4 +119,4 @@ http::status Routes::ParseUrl(http::verb method,
 }
 
 }  //namespace server
-}  // namespace onnxruntime
\ No newline at end of file
+}  // namespace onnxruntime
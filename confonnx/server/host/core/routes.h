@@ -3,7 +3,16 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include <boost/beast/http.hpp>
+#include "re2/re2.h"
 
 #include "context.h"
 
@@ -14,23 +23,49 @@ namespace http = boost::beast::http;  // from <boost/beast/http.hpp>
 
 using HandlerFn = std::function<void(HttpContext&)>;
 using ErrorFn = std::function<void(HttpContext&)>;
+using CompletionFn = std::function<void(const HttpContext&)>;
 
-// This class maintains two lists of regex -> function lists. One for POST requests and one for GET requests
-// If the incoming URL could match more than one regex, the first one will win.
+// This class maintains two route tables, one for POST requests and one for GET requests.
+// Patterns are compiled once at registration: plain paths go into a hash table,
+// everything else is compiled to a regex. Lookups do not allocate.
+// If the incoming URL could match more than one pattern, the first registered one will win.
+// Registered routes are shared read-only by all sessions.
 class Routes {
  public:
   Routes() = default;
+  Routes(const Routes&) = delete;
+  Routes& operator=(const Routes&) = delete;
+
   ErrorFn on_error;
+  // Optional, called with the final response of every request before it is sent.
+  CompletionFn on_complete;
   bool RegisterController(http::verb method, const std::string& url_pattern, const HandlerFn& controller);
   bool RegisterErrorCallback(const ErrorFn& controller);
+  bool RegisterCompletionCallback(const CompletionFn& callback);
 
   http::status ParseUrl(http::verb method,
-                        const std::string& url,
-                        /* out */ HandlerFn& func) const;
+                        std::string_view url,
+                        /* out */ const HandlerFn*& func) const;
 
  private:
-  std::vector<std::pair<std::string, HandlerFn>> post_fn_table;
-  std::vector<std::pair<std::string, HandlerFn>> get_fn_table;
+  struct Route {
+    std::string pattern;
+    std::unique_ptr<re2::RE2> regex;  // null for plain paths
+    HandlerFn handler;
+  };
+
+  struct Table {
+    // Elements of a deque do not move when appending, exact_routes keys point into them.
+    std::deque<Route> routes;
+    std::unordered_map<std::string_view, size_t> exact_routes;
+    std::vector<size_t> regex_routes;  // indices into routes, in registration order
+  };
+
+  static bool Register(Table& table, const std::string& url_pattern, const HandlerFn& controller);
+  static const HandlerFn* Match(const Table& table, std::string_view url);
+
+  Table post_fn_table;
+  Table get_fn_table;
 };
 
 }  //namespace server
@@ -0,0 +1,297 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include "rpc_session.h"
+
+namespace onnxruntime {
+namespace server {
+
+namespace net = boost::asio;       // from <boost/asio.hpp>
+namespace beast = boost::beast;    // from <boost/beast.hpp>
+using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
+
+// Minimum number of bytes to read at once, so that small pipelined frames share a read
+constexpr size_t kRpcReadSize = 64 * 1024;
+
+template <typename T>
+static T LoadLittle(const uint8_t* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return boost::endian::little_to_native(value);
+}
+
+template <typename T>
+static void StoreLittle(uint8_t* data, T value) {
+  value = boost::endian::native_to_little(value);
+  std::memcpy(data, &value, sizeof(value));
+}
+
+RpcSession::RpcSession(std::shared_ptr<const RpcHandlerFn> handler, const RpcOptions& options, tcp::socket socket,
+                       ConnectionLimit::Slot connection)
+    : handler_(std::move(handler)),
+      options_(options),
+      socket_(std::move(socket)),
+      connection_(std::move(connection)),
+      strand_(socket_.get_executor()),
+      read_timer_(socket_.get_executor().context(), std::chrono::steady_clock::time_point::max()),
+      write_timer_(socket_.get_executor().context(), std::chrono::steady_clock::time_point::max()) {
+}
+
+void RpcSession::Run() {
+  // On the strand, like all other accesses to the timers
+  net::dispatch(strand_, [self = shared_from_this()] {
+    self->DoRead();
+    self->UpdateReadTimer();
+  });
+}
+
+void RpcSession::DoRead() {
+  if (reading_ || read_closed_ || closed_ || in_flight_ >= options_.max_in_flight) {
+    return;
+  }
+
+  // Read at least the rest of the current frame if its header is buffered already
+  size_t read_size = kRpcReadSize;
+  if (buffer_.size() >= kRpcHeaderSize) {
+    auto payload_size = LoadLittle<uint32_t>(static_cast<const uint8_t*>(buffer_.data().data()));
+    read_size = std::max(read_size, kRpcHeaderSize + payload_size - buffer_.size());
+  }
+
+  reading_ = true;
+  socket_.async_read_some(buffer_.prepare(read_size),
+                          net::bind_executor(
+                              strand_,
+                              std::bind(
+                                  &RpcSession::OnRead,
+                                  shared_from_this(),
+                                  std::placeholders::_1,
+                                  std::placeholders::_2)));
+}
+
+void RpcSession::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
+  reading_ = false;
+
+  if (ec) {
+    // End of stream means the client sent all its requests, the responses are still written
+    if (ec != net::error::eof && ec != net::error::operation_aborted) {
+      ErrorHandling(ec, "read");
+    }
+    read_closed_ = true;
+    UpdateReadTimer();
+    return MaybeClose();
+  }
+
+  buffer_.commit(bytes_transferred);
+
+  if (!DispatchFrames()) {
+    return DoClose();
+  }
+
+  DoRead();
+  UpdateReadTimer();
+}
+
+bool RpcSession::DispatchFrames() {
+  while (!closed_ && in_flight_ < options_.max_in_flight && buffer_.size() >= kRpcHeaderSize) {
+    const auto* data = static_cast<const uint8_t*>(buffer_.data().data());
+    auto payload_size = LoadLittle<uint32_t>(data);
+    if (payload_size > options_.max_payload_size) {
+      ErrorHandling(net::error::message_size, "read");
+      return false;
+    }
+    if (data[4] > options_.max_request_type) {
+      ErrorHandling(net::error::invalid_argument, "read");
+      return false;
+    }
+    if (buffer_.size() < kRpcHeaderSize + payload_size) {
+      break;
+    }
+
+    RpcRequest request;
+    request.request_type = data[4];
+    request.timeout_ms = data[5] | (data[6] << 8) | (data[7] << 16);
+    request.tag = LoadLittle<uint64_t>(data + 8);
+    request.received = std::chrono::steady_clock::now();
+    request.payload.assign(data + kRpcHeaderSize, payload_size);
+    buffer_.consume(kRpcHeaderSize + payload_size);
+
+    // The next frame gets its own read timeout, see UpdateReadTimer
+    if (read_timer_state_ == ReadTimer::Frame) {
+      read_timer_state_ = ReadTimer::None;
+      DisarmTimer(read_timer_);
+    }
+
+    Dispatch(std::move(request));
+  }
+  return true;
+}
+
+void RpcSession::Dispatch(RpcRequest request) {
+  in_flight_++;
+
+  // Not on the strand, so that requests of one connection are handled in parallel
+  net::post(socket_.get_executor(),
+            [self = shared_from_this(), request = std::move(request)]() mutable {
+              RpcResponse response;
+              response.tag = request.tag;
+              try {
+                (*self->handler_)(request, response);
+              } catch (const std::exception& ex) {
+                response.status = -1;
+                response.payload.assign(std::string(ex.what()));
+              }
+              request.payload.clear();
+
+              net::post(self->strand_, [self, response = std::move(response)]() mutable {
+                self->OnHandled(std::move(response));
+              });
+            });
+}
+
+void RpcSession::OnHandled(RpcResponse response) {
+  if (closed_) {
+    return;
+  }
+
+  queue_.emplace_back();
+  PendingResponse& pending = queue_.back();
+  StoreLittle<uint32_t>(pending.header.data(), static_cast<uint32_t>(response.payload.size()));
+  StoreLittle<int32_t>(pending.header.data() + 4, response.status);
+  StoreLittle<uint64_t>(pending.header.data() + 8, response.tag);
+  pending.response = std::move(response);
+
+  // The request stays in flight until its response is written, so that a client
+  // that doesn't read responses cannot make them pile up in memory.
+  DoWrite();
+}
+
+void RpcSession::DoWrite() {
+  if (closed_ || !writing_.empty() || queue_.empty()) {
+    return;
+  }
+
+  ArmTimer(write_timer_, options_.write_timeout);
+  writing_.swap(queue_);
+  write_buffers_.clear();
+  for (const auto& pending : writing_) {
+    write_buffers_.emplace_back(pending.header.data(), pending.header.size());
+    if (!pending.response.payload.empty()) {
+      write_buffers_.emplace_back(pending.response.payload.data(), pending.response.payload.size());
+    }
+  }
+
+  net::async_write(socket_, write_buffers_,
+                   net::bind_executor(
+                       strand_,
+                       std::bind(
+                           &RpcSession::OnWrite,
+                           shared_from_this(),
+                           std::placeholders::_1,
+                           std::placeholders::_2)));
+}
+
+void RpcSession::OnWrite(beast::error_code ec, std::size_t bytes_transferred) {
+  boost::ignore_unused(bytes_transferred);
+  DisarmTimer(write_timer_);
+
+  if (ec) {
+    ErrorHandling(ec, "write");
+    return DoClose();
+  }
+
+  in_flight_ -= writing_.size();
+  writing_.clear();
+  DoWrite();
+
+  // Frames may be waiting for a free slot
+  if (!DispatchFrames()) {
+    return DoClose();
+  }
+  DoRead();
+  UpdateReadTimer();
+  MaybeClose();
+}
+
+void RpcSession::MaybeClose() {
+  if (read_closed_ && in_flight_ == 0) {
+    DoClose();
+  }
+}
+
+void RpcSession::DoClose() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  DisarmTimer(read_timer_);
+  DisarmTimer(write_timer_);
+
+  // Also cancels pending operations, requests still being handled are dropped
+  beast::error_code ec;
+  socket_.shutdown(tcp::socket::shutdown_both, ec);
+  socket_.close(ec);
+}
+
+void RpcSession::UpdateReadTimer() {
+  ReadTimer state = ReadTimer::None;
+  if (closed_ || read_closed_ || in_flight_ >= options_.max_in_flight) {
+    state = ReadTimer::None;
+  } else if (buffer_.size() > 0) {
+    state = ReadTimer::Frame;
+  } else if (in_flight_ == 0) {
+    state = ReadTimer::Idle;
+  }
+  if (state == read_timer_state_) {
+    // Keep counting from when the state was entered
+    return;
+  }
+  read_timer_state_ = state;
+  switch (state) {
+    case ReadTimer::Idle:
+      return ArmTimer(read_timer_, options_.idle_timeout);
+    case ReadTimer::Frame:
+      return ArmTimer(read_timer_, options_.read_timeout);
+    case ReadTimer::None:
+      return DisarmTimer(read_timer_);
+  }
+}
+
+void RpcSession::ArmTimer(net::steady_timer& timer, std::chrono::steady_clock::duration timeout) {
+  if (timeout == std::chrono::steady_clock::duration::zero()) {
+    return DisarmTimer(timer);
+  }
+  // Cancels the previous wait
+  timer.expires_after(timeout);
+  timer.async_wait(
+      net::bind_executor(
+          strand_,
+          [self = shared_from_this(), &timer](beast::error_code ec) {
+            self->OnTimer(timer, ec);
+          }));
+}
+
+void RpcSession::DisarmTimer(net::steady_timer& timer) {
+  // A wait that completed already but was not handled yet sees the new expiry
+  timer.expires_at(std::chrono::steady_clock::time_point::max());
+}
+
+void RpcSession::OnTimer(net::steady_timer& timer, beast::error_code ec) {
+  if (ec == net::error::operation_aborted || closed_ || timer.expiry() > std::chrono::steady_clock::now()) {
+    return;
+  }
+
+  // The client is idle, too slow to send a frame or too slow to receive the responses
+  DoClose();
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+
+#include "connection_limit.h"
+#include "pooled_body.h"
+#include "util.h"
+
+namespace onnxruntime {
+namespace server {
+
+namespace net = boost::asio;       // from <boost/asio.hpp>
+namespace beast = boost::beast;    // from <boost/beast.hpp>
+using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
+
+// Binary RPC transport, a lighter alternative to HTTP for internal callers.
+//
+// A connection carries a stream of frames in both directions. Every frame
+// starts with a 16 byte header, all integers are little endian:
+//
+//   request:  uint32 payload size | uint8 request type | uint24 timeout | uint64 tag | payload
+//   response: uint32 payload size | int32 status                        | uint64 tag | payload
+//
+// The client chooses the tag, the response to a request carries the same tag.
+// The timeout is the time in milliseconds the client waits for the response,
+// counted from when the server received the request, 0 for no deadline.
+// Clients may send many requests without waiting for responses, the responses
+// are sent in the order they complete. The status is SUCCESS (0) with the
+// response payload, an EnclaveCallStatus, -1 for errors outside the enclave,
+// or -2 if the server is overloaded and the request should be retried later.
+// In all error cases the payload is a UTF-8 error message.
+// Frames with an unknown request type or a payload larger than the limit
+// are protocol errors and close the connection.
+constexpr size_t kRpcHeaderSize = 16;
+
+struct RpcRequest {
+  uint64_t tag = 0;
+  uint8_t request_type = 0;
+  uint32_t timeout_ms = 0;
+  std::chrono::steady_clock::time_point received;
+  PooledBuffer payload;
+};
+
+struct RpcResponse {
+  uint64_t tag = 0;
+  int32_t status = 0;
+  PooledBuffer payload;
+};
+
+// Handles one request, may run concurrently with other requests of the same connection.
+using RpcHandlerFn = std::function<void(const RpcRequest& request, /* out */ RpcResponse& response)>;
+
+struct RpcOptions {
+  // Requests larger than this close the connection.
+  size_t max_payload_size = 25 * 1024 * 1024;
+  // Requests of one connection that are handled or whose responses are not
+  // yet written, reading from the connection pauses while the limit is reached.
+  size_t max_in_flight = 64;
+  // Frames with a larger request type close the connection.
+  uint8_t max_request_type = 255;
+  // The connection is closed if a timeout expires, zero disables it.
+  // Time without any data from the client while no request is in flight.
+  std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);
+  // Time from the first byte of a frame until it is complete.
+  std::chrono::steady_clock::duration read_timeout = std::chrono::seconds(60);
+  // Time to write the queued responses.
+  std::chrono::steady_clock::duration write_timeout = std::chrono::seconds(60);
+};
+
+// A single RPC connection. Frames are read on the session's strand, the
+// requests are handled on any thread of the io_context, and the responses
+// are written back on the strand, several at once if they queued up.
+class RpcSession : public std::enable_shared_from_this<RpcSession> {
+ public:
+  RpcSession(std::shared_ptr<const RpcHandlerFn> handler, const RpcOptions& options, tcp::socket socket,
+             ConnectionLimit::Slot connection);
+
+  // Start the asynchronous operation
+  void Run();
+
+ private:
+  struct PendingResponse {
+    std::array<uint8_t, kRpcHeaderSize> header;
+    RpcResponse response;
+  };
+
+  // What the read timer currently limits
+  enum class ReadTimer {
+    None,
+    Idle,
+    Frame
+  };
+
+  const std::shared_ptr<const RpcHandlerFn> handler_;
+  const RpcOptions options_;
+  tcp::socket socket_;
+  const ConnectionLimit::Slot connection_;
+  net::strand<net::io_context::executor_type> strand_;
+  net::steady_timer read_timer_;
+  net::steady_timer write_timer_;  // expires when the current write takes too long
+  beast::flat_buffer buffer_;
+
+  // The members below are only accessed on the strand.
+  size_t in_flight_ = 0;  // dispatched requests whose response is not written yet
+  bool reading_ = false;
+  bool read_closed_ = false;
+  bool closed_ = false;
+  ReadTimer read_timer_state_ = ReadTimer::None;
+  std::deque<PendingResponse> queue_;    // responses not yet written
+  std::deque<PendingResponse> writing_;  // responses being written
+  std::vector<net::const_buffer> write_buffers_;
+
+  // Reads more data from the socket unless too many requests are in flight
+  void DoRead();
+
+  void OnRead(beast::error_code ec, std::size_t bytes_transferred);
+
+  // Dispatches all complete frames in buffer_, returns false on protocol errors
+  bool DispatchFrames();
+
+  // Handles the request off the strand and queues the response
+  void Dispatch(RpcRequest request);
+
+  void OnHandled(RpcResponse response);
+
+  // Writes all queued responses in one operation
+  void DoWrite();
+
+  void OnWrite(beast::error_code ec, std::size_t bytes_transferred);
+
+  // Closes the connection once all responses are written
+  void MaybeClose();
+
+  void DoClose();
+
+  // Arms the read timer for the current state: the read timeout from the first
+  // byte of a frame until it is complete, the idle timeout while nothing is
+  // buffered or in flight. Not while reading pauses for the in-flight limit.
+  void UpdateReadTimer();
+
+  // Closes the connection if the timer is not re-armed or disarmed within timeout
+  void ArmTimer(net::steady_timer& timer, std::chrono::steady_clock::duration timeout);
+  void DisarmTimer(net::steady_timer& timer);
+  void OnTimer(net::steady_timer& timer, beast::error_code ec);
+};
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -10,117 +10,324 @@ namespace net = boost::asio;       // from <boost/asio.hpp>
 namespace beast = boost::beast;    // from <boost/beast.hpp>
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
 
-HttpSession::HttpSession(const Routes& routes, tcp::socket socket)
-    : routes_(routes), socket_(std::move(socket)), strand_(socket_.get_executor()) {
+template <typename Protocol>
+BasicHttpSession<Protocol>::BasicHttpSession(std::shared_ptr<const Routes> routes, const HttpSessionOptions& options, socket_type socket,
+                                             ConnectionLimit::Slot connection)
+    : routes_(std::move(routes)),
+      options_(options),
+      socket_(std::move(socket)),
+      connection_(std::move(connection)),
+      strand_(socket_.get_executor()),
+      read_timer_(socket_.get_executor().context(), std::chrono::steady_clock::time_point::max()),
+      write_timer_(socket_.get_executor().context(), std::chrono::steady_clock::time_point::max()) {
 }
 
-void HttpSession::DoRead() {
+template <typename Protocol>
+void BasicHttpSession<Protocol>::DoRead() {
+  if (reading_ || read_closed_ || closed_ || responses_.size() >= options_.max_in_flight) {
+    return;
+  }
+  reading_ = true;
+
   req_.emplace();
+  req_->body_limit(options_.body_limit);
+
+  // Pipelined requests may be buffered already
+  if (buffer_.size() > 0) {
+    return DoReadHeader();
+  }
+
+  // Wait for the first byte separately, so that the header timeout does not
+  // include the idle time of keep-alive connections. The idle timeout only
+  // applies once all responses are written, see OnWrite.
+  waiting_idle_ = true;
+  if (responses_.empty()) {
+    ArmTimer(read_timer_, options_.idle_timeout);
+  }
+  socket_.async_wait(socket_type::wait_read,
+                     net::bind_executor(
+                         strand_,
+                         std::bind(
+                             &BasicHttpSession::OnReadable,
+                             this->shared_from_this(),
+                             std::placeholders::_1)));
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnReadable(beast::error_code ec) {
+  waiting_idle_ = false;
+
+  if (ec) {
+    if (!closed_ && ec != net::error::operation_aborted) {
+      ErrorHandling(ec, "wait");
+    }
+    reading_ = false;
+    read_closed_ = true;
+    DisarmTimer(read_timer_);
+    return MaybeClose();
+  }
+
+  DoReadHeader();
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::DoReadHeader() {
+  ArmTimer(read_timer_, options_.header_timeout);
+
+  // The header is read separately so that the time spent reading the body
+  // can be measured without including the idle time of keep-alive connections.
+  http::async_read_header(socket_, buffer_, *req_,
+                          net::bind_executor(
+                              strand_,
+                              std::bind(
+                                  &BasicHttpSession::OnReadHeader,
+                                  this->shared_from_this(),
+                                  std::placeholders::_1,
+                                  std::placeholders::_2)));
+}
 
-  // TODO: make the max request size configable.
-  req_->body_limit(25 * 1024 * 1024);  // Max request size: 25 MiB
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnReadHeader(beast::error_code ec, std::size_t bytes_transferred) {
+  boost::ignore_unused(bytes_transferred);
+
+  if (ec) {
+    // End of stream means they closed the connection, the pending responses are still written.
+    // Reads aborted by a timeout fail in various ways, they are not worth logging.
+    if (!closed_ && ec != http::error::end_of_stream && ec != net::error::operation_aborted) {
+      ErrorHandling(ec, "read");
+    }
+    reading_ = false;
+    read_closed_ = true;
+    DisarmTimer(read_timer_);
+    return MaybeClose();
+  }
+
+  read_start_ = std::chrono::steady_clock::now();
+  ArmTimer(read_timer_, options_.body_timeout);
 
   http::async_read(socket_, buffer_, *req_,
                    net::bind_executor(
                        strand_,
                        std::bind(
-                           &HttpSession::OnRead,
-                           shared_from_this(),
+                           &BasicHttpSession::OnRead,
+                           this->shared_from_this(),
                            std::placeholders::_1,
                            std::placeholders::_2)));
 }
 
-void HttpSession::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
   boost::ignore_unused(bytes_transferred);
+  reading_ = false;
+  DisarmTimer(read_timer_);
 
-  // This means they closed the connection
-  if (ec == http::error::end_of_stream) {
-    return DoClose();
+  if (ec) {
+    // Reads aborted by a timeout fail in various ways, they are not worth logging
+    if (!closed_ && ec != http::error::end_of_stream && ec != net::error::operation_aborted) {
+      ErrorHandling(ec, "read");
+    }
+    read_closed_ = true;
+    return MaybeClose();
   }
 
-  if (ec) {
-    ErrorHandling(ec, "read");
+  auto read_end = std::chrono::steady_clock::now();
+
+  // Requests after one without keep-alive are not answered
+  if (!req_->get().keep_alive()) {
+    read_closed_ = true;
+  }
+
+  Dispatch(req_->release(), read_end);
+
+  // Read the next pipelined request while this one is handled
+  DoRead();
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::Dispatch(http::request<PooledBody>&& req, std::chrono::steady_clock::time_point read_end) {
+  uint64_t sequence = first_sequence_ + responses_.size();
+  responses_.emplace_back();
+
+  // Not on the strand, so that pipelined requests are handled in parallel
+  net::post(socket_.get_executor(),
+            [self = this->shared_from_this(), req = std::move(req), sequence, read_start = read_start_, read_end]() mutable {
+              Response response = self->HandleRequest(std::move(req), read_start, read_end);
+              net::post(self->strand_, [self, sequence, response = std::move(response)]() mutable {
+                self->OnHandled(sequence, std::move(response));
+              });
+            });
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnHandled(uint64_t sequence, Response&& response) {
+  if (closed_) {
     return;
   }
 
-  // Send the response
-  HandleRequest(req_->release());
+  responses_[sequence - first_sequence_] = std::make_unique<Response>(std::move(response));
+  DoWrite();
 }
 
-void HttpSession::OnWrite(beast::error_code ec, std::size_t bytes_transferred, bool close) {
+template <typename Protocol>
+void BasicHttpSession<Protocol>::DoWrite() {
+  if (writing_ || closed_ || responses_.empty() || !responses_.front()) {
+    return;
+  }
+  writing_ = true;
+
+  // A client that doesn't read its responses would otherwise keep the
+  // connection and the buffered responses forever.
+  ArmTimer(write_timer_, options_.write_timeout);
+
+  // The response stays at the front of responses_ until it is written
+  Response& response = *responses_.front();
+  http::async_write(socket_, response,
+                    net::bind_executor(strand_,
+                                       [self = this->shared_from_this(), close = response.need_eof()](beast::error_code ec, std::size_t bytes) {
+                                         self->OnWrite(ec, bytes, close);
+                                       }));
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnWrite(beast::error_code ec, std::size_t bytes_transferred, bool close) {
   boost::ignore_unused(bytes_transferred);
+  writing_ = false;
+  DisarmTimer(write_timer_);
 
   if (ec) {
-    ErrorHandling(ec, "write");
+    if (!closed_ && ec != net::error::operation_aborted) {
+      ErrorHandling(ec, "write");
+    }
+    closed_ = true;
+    DisarmTimer(read_timer_);
+    socket_.close(ec);
     return;
   }
 
+  // We're done with the response so delete it
+  responses_.pop_front();
+  first_sequence_++;
+
+  // The client may now wait for the next request without sending anything
+  if (waiting_idle_ && responses_.empty()) {
+    ArmTimer(read_timer_, options_.idle_timeout);
+  }
+
   if (close) {
     // This means we should close the connection, usually because
     // the response indicated the "Connection: close" semantic.
+    read_closed_ = true;
     return DoClose();
   }
 
-  // We're done with the response so delete it
-  res_ = nullptr;
+  DoWrite();
 
-  // Read another request
+  // Read another request if the in-flight limit stopped reading
   DoRead();
+  MaybeClose();
+}
+
+template <typename Protocol>
+void BasicHttpSession<Protocol>::MaybeClose() {
+  if (read_closed_ && responses_.empty()) {
+    DoClose();
+  }
 }
 
-void HttpSession::DoClose() {
+template <typename Protocol>
+void BasicHttpSession<Protocol>::DoClose() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  DisarmTimer(read_timer_);
+  DisarmTimer(write_timer_);
+
   // Send a TCP shutdown
   beast::error_code ec;
-  socket_.shutdown(tcp::socket::shutdown_send, ec);
+  socket_.shutdown(socket_type::shutdown_send, ec);
 
   // At this point the connection is closed gracefully
 }
 
-template <class Msg>
-void HttpSession::Send(Msg&& msg) {
-  using item_type = std::remove_reference_t<decltype(msg)>;
+template <typename Protocol>
+void BasicHttpSession<Protocol>::ArmTimer(net::steady_timer& timer, std::chrono::steady_clock::duration timeout) {
+  if (timeout == std::chrono::steady_clock::duration::zero()) {
+    return DisarmTimer(timer);
+  }
+  // Cancels the previous wait
+  timer.expires_after(timeout);
+  timer.async_wait(
+      net::bind_executor(
+          strand_,
+          [self = this->shared_from_this(), &timer](beast::error_code ec) {
+            self->OnTimer(timer, ec);
+          }));
+}
 
-  auto ptr = std::make_shared<item_type>(std::move(msg));
-  auto self_ = shared_from_this();
-  self_->res_ = ptr;
+template <typename Protocol>
+void BasicHttpSession<Protocol>::DisarmTimer(net::steady_timer& timer) {
+  // A wait that completed already but was not handled yet sees the new expiry
+  timer.expires_at(std::chrono::steady_clock::time_point::max());
+}
 
-  http::async_write(self_->socket_, *ptr,
-                    net::bind_executor(strand_,
-                                       [self_, close = ptr->need_eof()](beast::error_code ec, std::size_t bytes) {
-                                         self_->OnWrite(ec, bytes, close);
-                                       }));
+template <typename Protocol>
+void BasicHttpSession<Protocol>::OnTimer(net::steady_timer& timer, beast::error_code ec) {
+  if (ec == net::error::operation_aborted || closed_ || timer.expiry() > std::chrono::steady_clock::now()) {
+    return;
+  }
+
+  // The client is idle, too slow to send or too slow to receive, abort the pending
+  // read and write and drop the connection.
+  // Responses to requests still being handled are discarded.
+  closed_ = true;
+  read_closed_ = true;
+  socket_.shutdown(socket_type::shutdown_both, ec);
+  socket_.close(ec);
 }
 
-template <typename Body, typename Allocator>
-void HttpSession::HandleRequest(http::request<Body, http::basic_fields<Allocator> >&& req) {
+template <typename Protocol>
+typename BasicHttpSession<Protocol>::Response BasicHttpSession<Protocol>::HandleRequest(
+    http::request<PooledBody>&& req,
+    std::chrono::steady_clock::time_point read_start,
+    std::chrono::steady_clock::time_point read_end) {
   HttpContext context{};
   context.request = std::move(req);
+  context.read_start = read_start;
+  context.read_end = read_end;
+  context.handler_start = std::chrono::steady_clock::now();
 
   // Special handle the liveness probe endpoint for orchestration systems like Kubernetes.
   if (context.request.method() == http::verb::get && context.request.target().to_string() == "/") {
-    context.response.body() = "Healthy";
+    context.response.body().assign("Healthy");
   } else {
     auto status = ExecuteUserFunction(context);
 
     if (status != http::status::ok) {
-      routes_.on_error(context);
+      routes_->on_error(context);
     }
   }
 
   context.response.keep_alive(context.request.keep_alive());
   context.response.prepare_payload();
-  return Send(std::move(context.response));
+
+  if (routes_->on_complete) {
+    routes_->on_complete(context);
+  }
+
+  return std::move(context.response);
 }
 
-http::status HttpSession::ExecuteUserFunction(HttpContext& context) {
-  std::string path = context.request.target().to_string();
-  HandlerFn func;
+template <typename Protocol>
+http::status BasicHttpSession<Protocol>::ExecuteUserFunction(HttpContext& context) {
+  auto target = context.request.target();
+  const HandlerFn* func = nullptr;
 
   if (context.request.find(util::MS_CLIENT_REQUEST_ID_HEADER) != context.request.end()) {
     context.client_request_id = context.request[util::MS_CLIENT_REQUEST_ID_HEADER].to_string();
   }
 
-  auto status = routes_.ParseUrl(context.request.method(), path, func);
+  auto status = routes_->ParseUrl(context.request.method(), std::string_view(target.data(), target.size()), func);
 
   if (status != http::status::ok) {
     context.error_code = status;
@@ -133,7 +340,7 @@ http::status HttpSession::ExecuteUserFunction(HttpContext& context) {
   }
 
   try {
-    func(context);
+    (*func)(context);
   } catch (const std::exception& ex) {
     context.error_message = std::string(ex.what());
     return http::status::internal_server_error;
@@ -142,5 +349,8 @@ http::status HttpSession::ExecuteUserFunction(HttpContext& context) {
   return http::status::ok;
 }
 
+template class BasicHttpSession<tcp>;
+template class BasicHttpSession<local>;
+
 }  // namespace server
 }  // namespace onnxruntime
\ No newline at end of file
@@ -3,13 +3,18 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <boost/beast/version.hpp>
 #include <boost/asio/bind_executor.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 
+#include "connection_limit.h"
 #include "context.h"
 #include "routes.h"
 #include "util.h"
@@ -20,13 +25,37 @@ namespace server {
 namespace net = boost::asio;       // from <boost/asio.hpp>
 namespace beast = boost::beast;    // from <boost/beast.hpp>
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
+using local = boost::asio::local::stream_protocol;
 namespace http = beast::http;
 
+struct HttpSessionOptions {
+  // Pipelined requests of one connection that are handled at the same time,
+  // reading from the connection pauses while the limit is reached.
+  size_t max_in_flight = 8;
+  // Requests with a larger body are rejected and the connection is closed.
+  uint64_t body_limit = 25 * 1024 * 1024;
+  // The connection is closed if a timeout expires, zero disables it.
+  // Time without any data from the client while no request is in flight.
+  std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);
+  // Time from the first byte of a request until its header is complete.
+  std::chrono::steady_clock::duration header_timeout = std::chrono::seconds(10);
+  // Time to read the body after the header.
+  std::chrono::steady_clock::duration body_timeout = std::chrono::seconds(60);
+  // Time to write one response.
+  std::chrono::steady_clock::duration write_timeout = std::chrono::seconds(60);
+};
+
 // An implementation of a single HTTP session
 // Used by a listener to hand off the work and async write back to a socket
-class HttpSession : public std::enable_shared_from_this<HttpSession> {
+// Pipelined requests are handled concurrently, the responses are written in request order.
+// Instantiated for TCP and Unix domain sockets, see HttpSession and LocalHttpSession.
+template <typename Protocol>
+class BasicHttpSession : public std::enable_shared_from_this<BasicHttpSession<Protocol>> {
  public:
-  HttpSession(const Routes& routes, tcp::socket socket);
+  using socket_type = typename Protocol::socket;
+
+  BasicHttpSession(std::shared_ptr<const Routes> routes, const HttpSessionOptions& options, socket_type socket,
+                   ConnectionLimit::Slot connection);
 
   // Start the asynchronous operation
   // The entrypoint for the class
@@ -35,44 +64,85 @@ class HttpSession : public std::enable_shared_from_this<HttpSession> {
   }
 
  private:
-  const Routes routes_;
-  tcp::socket socket_;
+  using Response = http::response<PooledBody>;
+
+  const std::shared_ptr<const Routes> routes_;
+  const HttpSessionOptions options_;
+  socket_type socket_;
+  const ConnectionLimit::Slot connection_;
   net::strand<net::io_context::executor_type> strand_;
+  net::steady_timer read_timer_;   // expires when the current read takes too long
+  net::steady_timer write_timer_;  // expires when the current write takes too long
   beast::flat_buffer buffer_;
-  boost::optional<http::request_parser<http::string_body>> req_;
-  std::shared_ptr<void> res_{nullptr};
-
-  // Writes the message asynchronously back to the socket
-  // Stores the pointer to the message and the class itself so that
-  // They do not get destructed before the async process is finished
-  // If you pass shared_from_this() are guaranteed that the life time
-  // of your object will be extended to as long as the function needs it
-  // Most examples in boost::asio are based on this logic
-  template <class Msg>
-  void Send(Msg&& msg);
+  boost::optional<http::request_parser<PooledBody>> req_;
+  std::chrono::steady_clock::time_point read_start_;
+
+  // The members below are only accessed on the strand.
+  bool reading_ = false;
+  bool waiting_idle_ = false;  // waiting for the first byte of the next request
+  bool read_closed_ = false;   // no further requests are read
+  bool writing_ = false;
+  bool closed_ = false;
+  // Responses of the dispatched requests in request order, null while the request is handled.
+  // The front response is the one being written or written next.
+  std::deque<std::unique_ptr<Response>> responses_;
+  uint64_t first_sequence_ = 0;  // sequence number of responses_.front()
 
   // Called after the session is finished reading the message
-  // Should set the response before calling Send
-  template <typename Body, typename Allocator>
-  void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req);
+  // Handles the request on any thread of the io_context and returns the response
+  Response HandleRequest(http::request<PooledBody>&& req,
+                         std::chrono::steady_clock::time_point read_start,
+                         std::chrono::steady_clock::time_point read_end);
 
   // Handle the request and hand it off to the user's function
   // Execute user function, handle errors
   // HttpContext parameter can be updated here or in HandleRequest
   http::status ExecuteUserFunction(HttpContext& context);
 
-  // Asynchronously reads the request from the socket
+  // Asynchronously waits for the next request unless too many requests are in flight
   void DoRead();
 
-  // Perform error checking before handing off to HandleRequest
+  // Reads the request header once the client started sending it
+  void OnReadable(beast::error_code ec);
+
+  // Asynchronously reads the request header from the socket
+  void DoReadHeader();
+
+  // Asynchronously reads the request body after the header has been read
+  void OnReadHeader(beast::error_code ec, std::size_t bytes_transferred);
+
+  // Perform error checking before dispatching the request
   void OnRead(beast::error_code ec, std::size_t bytes_transferred);
 
-  // After writing, make the session read another request
+  // Hands the request to HandleRequest off the strand and continues reading
+  void Dispatch(http::request<PooledBody>&& req, std::chrono::steady_clock::time_point read_end);
+
+  // Stores the response of a request and writes the responses that are ready
+  void OnHandled(uint64_t sequence, Response&& response);
+
+  // Writes the front response if it is ready
+  void DoWrite();
+
+  // After writing, write the next response and read further requests
   void OnWrite(beast::error_code ec, std::size_t bytes_transferred, bool close);
 
+  // Closes the connection once all responses are written
+  void MaybeClose();
+
   // Close the connection
   void DoClose();
+
+  // Closes the connection if the timer is not re-armed or disarmed within timeout
+  void ArmTimer(net::steady_timer& timer, std::chrono::steady_clock::duration timeout);
+  void DisarmTimer(net::steady_timer& timer);
+  void OnTimer(net::steady_timer& timer, beast::error_code ec);
 };
 
+using HttpSession = BasicHttpSession<tcp>;
+using LocalHttpSession = BasicHttpSession<local>;
+
+extern template class BasicHttpSession<tcp>;
+extern template class BasicHttpSession<local>;
+
 }  // namespace server
 }  // namespace onnxruntime
@@ -1,8 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <cstring>
 #include <cerrno>
+#include <limits>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -11,6 +13,7 @@
 #include "server/shared/constants.h"
 #include "server/host/enclave_error.h"
 #include "server/host/enclave.h"
+#include "server/host/in_process_enclave.h"
 
 namespace {
 void CheckError(const std::ifstream& stream) {
@@ -39,8 +42,90 @@ std::vector<char> ReadFile(const std::string& path) {
 namespace onnxruntime {
 namespace server {
 
+// The enclave code in a signed SGX enclave, each call is an ECALL.
+class SgxEnclave : public EnclaveCalls {
+ public:
+  SgxEnclave(const std::string& enclave_path, uint32_t enclave_flags) {
+    EnclaveSDKError::Check(oe_create_server_enclave(
+        enclave_path.c_str(), OE_ENCLAVE_TYPE_SGX, enclave_flags, nullptr, 0, &enclave));
+  }
+
+  ~SgxEnclave() override {
+    oe_terminate_enclave(enclave);
+  }
+
+  SgxEnclave(const SgxEnclave&) = delete;
+  void operator=(const SgxEnclave&) = delete;
+
+  int Initialize(const uint8_t* model_buf, size_t model_len,
+                 uint32_t key_rollover_interval_seconds,
+                 bool use_model_key_provisioning,
+                 bool use_akv,
+                 const char* akv_app_id, const char* akv_app_pwd, const char* akv_vault_url,
+                 const char* akv_service_key_name,
+                 const char* akv_model_key_name,
+                 const char* akv_attestation_url) override {
+    int status;
+    EnclaveSDKError::Check(EnclaveInitialize(enclave, &status, model_buf, model_len,
+                                             key_rollover_interval_seconds, use_model_key_provisioning,
+                                             use_akv, akv_app_id, akv_app_pwd, akv_vault_url,
+                                             akv_service_key_name, akv_model_key_name, akv_attestation_url));
+    return status;
+  }
+
+  int HandleRequest(const char* request_id, uint8_t request_type, uint32_t timeout_ms,
+                    const uint8_t* input_buf, size_t input_size,
+                    uint8_t* output_buf, size_t* output_size, size_t output_max_size) override {
+    int status;
+    EnclaveSDKError::Check(EnclaveHandleRequest(enclave, &status, request_id, request_type, timeout_ms,
+                                                input_buf, input_size, output_buf, output_size, output_max_size));
+    return status;
+  }
+
+  int MaybeRefreshKey() override {
+    int status;
+    EnclaveSDKError::Check(EnclaveMaybeRefreshKey(enclave, &status));
+    return status;
+  }
+
+  void CancelExpiredRuns() override {
+    EnclaveSDKError::Check(EnclaveCancelExpiredRuns(enclave));
+  }
+
+  void SetTimingEnabled(bool enabled) override {
+    EnclaveSDKError::Check(EnclaveSetTimingEnabled(enclave, enabled));
+  }
+
+  uint64_t GetLastInferenceTime() override {
+    uint64_t ns;
+    EnclaveSDKError::Check(EnclaveGetLastInferenceTime(enclave, &ns));
+    return ns;
+  }
+
+  int GetStats(void* stats, size_t stats_size) override {
+    int status;
+    EnclaveSDKError::Check(EnclaveGetStats(enclave, &status, stats, stats_size));
+    return status;
+  }
+
+  int SetLogRing(void* ring, size_t ring_size) override {
+    int status;
+    EnclaveSDKError::Check(EnclaveSetLogRing(enclave, &status, ring, ring_size));
+    return status;
+  }
+
+  int Destroy() override {
+    int status;
+    EnclaveSDKError::Check(EnclaveDestroy(enclave, &status));
+    return status;
+  }
+
+ private:
+  oe_enclave_t* enclave = nullptr;
+};
+
 // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
-Enclave::Enclave(const std::string& enclave_path, bool debug, bool simulate,
+Enclave::Enclave(const std::string& enclave_path, bool debug, bool simulate, bool in_process,
                  const std::shared_ptr<ServerEnvironment>& env,
                  KeyVaultConfig&& service_kvc,
                  KeyVaultConfig&& model_kvc,
@@ -56,6 +141,13 @@ Enclave::Enclave(const std::string& enclave_path, bool debug, bool simulate,
       use_model_key_provisioning(use_model_key_provisioning) {
   auto logger = env->GetAppLogger();
 
+  if (in_process) {
+    logger->warn("Loading enclave in-process, no isolation or attestation, do not use in production");
+    calls = std::make_unique<InProcessEnclave>(enclave_path);
+    logger->info("Enclave loaded");
+    return;
+  }
+
   uint32_t enclave_flags = 0;
 
   if (debug) {
@@ -68,8 +160,7 @@ Enclave::Enclave(const std::string& enclave_path, bool debug, bool simulate,
   }
 
   logger->info("Creating enclave");
-  EnclaveSDKError::Check(oe_create_server_enclave(
-      enclave_path.c_str(), OE_ENCLAVE_TYPE_SGX, enclave_flags, nullptr, 0, &enclave));
+  calls = std::make_unique<SgxEnclave>(enclave_path, enclave_flags);
   logger->info("Enclave created");
 }
 
@@ -79,19 +170,21 @@ void Enclave::Initialize(const std::string& model_path, const std::shared_ptr<Se
   logger->debug("Loading model file");
   std::vector<char> model = ReadFile(model_path);
 
+  // Enclave log messages go through a ring in host memory instead of an OCALL each.
+  enclave_log = std::make_unique<EnclaveLog>(logger);
+  EnclaveCallError::Check(calls->SetLogRing(enclave_log->Data(), enclave_log->Size()));
+  enclave_log->Start();
+
   logger->debug("Initializing enclave");
-  int status;
   uint32_t key_rollover_interval_seconds = key_rollover_interval.count();
-  EnclaveSDKError::Check(EnclaveInitialize(enclave, &status,
-                                           (uint8_t*)model.data(), model.size(),
-                                           key_rollover_interval_seconds,
-                                           use_model_key_provisioning,
-                                           !service_kvc.url.empty(),
-                                           service_kvc.app_id.c_str(), service_kvc.app_pwd.c_str(), service_kvc.url.c_str(),
-                                           service_kvc.key_name.c_str(),
-                                           model_kvc.key_name.c_str(),
-                                           service_kvc.attestation_url.c_str()));
-  EnclaveCallError::Check(status);
+  EnclaveCallError::Check(calls->Initialize((uint8_t*)model.data(), model.size(),
+                                             key_rollover_interval_seconds,
+                                             use_model_key_provisioning,
+                                             !service_kvc.url.empty(),
+                                             service_kvc.app_id.c_str(), service_kvc.app_pwd.c_str(), service_kvc.url.c_str(),
+                                             service_kvc.key_name.c_str(),
+                                             model_kvc.key_name.c_str(),
+                                             service_kvc.attestation_url.c_str()));
   logger->info("Enclave initialized");
 
   logger->info("Key rollover interval: {}s", key_rollover_interval_seconds);
@@ -103,12 +196,68 @@ void Enclave::Initialize(const std::string& model_path, const std::shared_ptr<Se
 void Enclave::HandleRequest(const std::string& request_id,
                             RequestType request_type,
                             const uint8_t* input_buf, size_t input_size,
-                            uint8_t* output_buf, size_t* output_size, const std::shared_ptr<ServerEnvironment>& env) const {
+                            uint8_t* output_buf, size_t* output_size, const std::shared_ptr<ServerEnvironment>& env,
+                            std::chrono::milliseconds timeout) const {
   (void)env;
-  int status;
-  EnclaveSDKError::Check(EnclaveHandleRequest(enclave, &status, request_id.c_str(), static_cast<uint8_t>(request_type),
-                                              input_buf, input_size, output_buf, output_size, MAX_OUTPUT_SIZE));
-  EnclaveCallError::Check(status);
+  // Longer timeouts are as good as none.
+  uint32_t timeout_ms = static_cast<uint32_t>(std::min<std::chrono::milliseconds::rep>(
+      timeout.count(), std::numeric_limits<uint32_t>::max()));
+  std::unique_ptr<TrackedDeadline> tracked_deadline;
+  if (deadline_thread && timeout_ms > 0) {
+    tracked_deadline = std::make_unique<TrackedDeadline>(*this, std::chrono::steady_clock::now() + timeout);
+  }
+  EnclaveCallError::Check(calls->HandleRequest(request_id.c_str(), static_cast<uint8_t>(request_type), timeout_ms,
+                                                input_buf, input_size, output_buf, output_size, MAX_OUTPUT_SIZE));
+}
+
+Enclave::TrackedDeadline::TrackedDeadline(const Enclave& enclave, std::chrono::steady_clock::time_point deadline)
+    : enclave_(enclave) {
+  std::lock_guard<std::mutex> lock(enclave_.deadlines_mutex);
+  deadline_ = enclave_.deadlines.insert(deadline);
+}
+
+Enclave::TrackedDeadline::~TrackedDeadline() {
+  std::lock_guard<std::mutex> lock(enclave_.deadlines_mutex);
+  enclave_.deadlines.erase(deadline_);
+}
+
+void Enclave::StartDeadlineWatchdog(std::chrono::milliseconds interval, const std::shared_ptr<ServerEnvironment>& env) {
+  // Only calls into the enclave while a request is past its deadline, which
+  // the enclave checks again against its own clock. This repeats every
+  // interval until the request returned.
+  auto logger = env->GetAppLogger();
+  auto fn = [=]() {
+    while (!deadline_timer.cancelled()) {
+      deadline_timer.wait_for(interval);
+      bool expired;
+      {
+        std::lock_guard<std::mutex> lock(deadlines_mutex);
+        expired = !deadlines.empty() && *deadlines.begin() <= std::chrono::steady_clock::now();
+      }
+      if (!expired) {
+        continue;
+      }
+      try {
+        calls->CancelExpiredRuns();
+      } catch (EnclaveSDKError& e) {
+        // Usually OE_OUT_OF_THREADS, when the request threads use all TCS.
+        logger->error("Cancelling expired runs failed, NumTCS in enclave.conf must be at least the number of HTTP threads plus 2 -- {}", e.what());
+      }
+    }
+  };
+  deadline_thread = std::make_unique<std::thread>(fn);
+}
+
+void Enclave::SetTimingEnabled(bool enabled) const {
+  calls->SetTimingEnabled(enabled);
+}
+
+std::chrono::nanoseconds Enclave::GetLastInferenceTime() const {
+  return std::chrono::nanoseconds(calls->GetLastInferenceTime());
+}
+
+void Enclave::GetStats(EnclaveStats& stats) const {
+  EnclaveCallError::Check(calls->GetStats(&stats, sizeof(stats)));
 }
 
 void Enclave::StartPeriodicKeyRefreshBackgroundThread(std::shared_ptr<spdlog::logger> logger) {
@@ -116,9 +265,7 @@ void Enclave::StartPeriodicKeyRefreshBackgroundThread(std::shared_ptr<spdlog::lo
     key_refresh_timer.wait_for(key_sync_interval);
     while (!key_refresh_timer.cancelled()) {
       try {
-        int status;
-        EnclaveSDKError::Check(EnclaveMaybeRefreshKey(enclave, &status));
-        EnclaveCallError::Check(status);
+        EnclaveCallError::Check(calls->MaybeRefreshKey());
         key_refresh_timer.wait_for(key_sync_interval);
       } catch (EnclaveCallError& e) {
         if (e.status == KEY_REFRESH_ERROR) {
@@ -146,9 +293,9 @@ void Enclave::StartPeriodicKeyRefreshBackgroundThread(std::shared_ptr<spdlog::lo
 Enclave::~Enclave() {
   key_refresh_timer.cancel();
   if (key_refresh_thread) key_refresh_thread->join();
-  int status;
-  EnclaveSDKError::Check(EnclaveDestroy(enclave, &status));
-  EnclaveSDKError::Check(oe_terminate_enclave(enclave));
+  deadline_timer.cancel();
+  if (deadline_thread) deadline_thread->join();
+  calls->Destroy();
 }
 
 }  // namespace server
@@ -5,13 +5,17 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <thread>
 #include <chrono>
-#include <openenclave/host.h>
 
 #include "server/host/environment.h"
 #include "server/host/cancellable_timer.h"
+#include "server/host/enclave_log.h"
+#include "server/host/enclave_calls.h"
 #include "server/shared/key_vault_config.h"
+#include "server/shared/metrics.h"
 #include "server/shared/request_type.h"
 
 namespace onnxruntime {
@@ -21,7 +25,9 @@ class KeyVaultConfig;
 
 class Enclave {
  public:
-  Enclave(const std::string& enclave_path, bool debug, bool simulate,
+  // If in_process is true, enclave_path refers to the in-process build of the enclave
+  // code (see InProcessEnclave) instead of a signed enclave, and debug/simulate are ignored.
+  Enclave(const std::string& enclave_path, bool debug, bool simulate, bool in_process,
           const std::shared_ptr<ServerEnvironment>& env,
           KeyVaultConfig&& service_kvc,
           KeyVaultConfig&& model_kvc,
@@ -36,18 +42,58 @@ class Enclave {
 
   void Initialize(const std::string& model_path, const std::shared_ptr<ServerEnvironment>& env);
 
+  // timeout is the time left until the client's deadline, zero if there is none.
+  // Score requests still running when it passes are terminated inside the enclave
+  // and fail with DEADLINE_EXCEEDED_ERROR, if the deadline watchdog is running.
   void HandleRequest(const std::string& request_id,
                      RequestType request_type,
                      const uint8_t* input_buf, size_t input_size,
                      uint8_t* output_buf, size_t* output_size,
-                     const std::shared_ptr<ServerEnvironment>& env) const;
+                     const std::shared_ptr<ServerEnvironment>& env,
+                     std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()) const;
+
+  // Checks the deadlines of in-flight requests every interval and asks the enclave
+  // to terminate the runs of expired ones. Call before requests are served.
+  void StartDeadlineWatchdog(std::chrono::milliseconds interval, const std::shared_ptr<ServerEnvironment>& env);
+
+  // Measuring inside the enclave is off by default as reading the clock requires OCALLs.
+  void SetTimingEnabled(bool enabled) const;
+
+  // Time spent in inference (conversion and run) by the last score request
+  // of the calling thread. Zero if timing is not enabled.
+  std::chrono::nanoseconds GetLastInferenceTime() const;
+
+  // Stage histograms and key refresh counters aggregated inside the enclave.
+  // Stage histograms stay empty unless timing is enabled.
+  void GetStats(EnclaveStats& stats) const;
 
  private:
   void StartPeriodicKeyRefreshBackgroundThread(std::shared_ptr<spdlog::logger> logger);
 
-  oe_enclave_t* enclave;
+  using DeadlineSet = std::multiset<std::chrono::steady_clock::time_point>;
+  // Tracks the deadline of a request for the deadline watchdog while in scope.
+  class TrackedDeadline {
+   public:
+    TrackedDeadline(const Enclave& enclave, std::chrono::steady_clock::time_point deadline);
+    ~TrackedDeadline();
+    TrackedDeadline(const TrackedDeadline&) = delete;
+    void operator=(const TrackedDeadline&) = delete;
+
+   private:
+    const Enclave& enclave_;
+    DeadlineSet::iterator deadline_;
+  };
+
+  // Destroyed after the enclave, which writes into it until then.
+  std::unique_ptr<EnclaveLog> enclave_log;
+  // The SGX enclave or its in-process build.
+  std::unique_ptr<EnclaveCalls> calls;
   std::unique_ptr<std::thread> key_refresh_thread;
   CancellableTimer key_refresh_timer;
+  std::unique_ptr<std::thread> deadline_thread;
+  CancellableTimer deadline_timer;
+  mutable std::mutex deadlines_mutex;  // guards deadlines
+  mutable DeadlineSet deadlines;       // of in-flight requests
   std::chrono::seconds key_rollover_interval;
   std::chrono::seconds key_sync_interval;
   std::chrono::seconds key_error_retry_interval;
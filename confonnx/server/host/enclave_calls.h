@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * The entrypoints of the enclave code, see server.edl. Implemented by the SGX enclave,
+ * where each call is an ECALL, and by the in-process build (InProcessEnclave), so that
+ * Enclave does not have to distinguish between the two.
+ *
+ * Methods returning int return the EnclaveCallStatus of the entrypoint.
+ * Failures to call into the enclave are thrown as EnclaveSDKError.
+ */
+class EnclaveCalls {
+ public:
+  virtual ~EnclaveCalls() = default;
+
+  virtual int Initialize(const uint8_t* model_buf, size_t model_len,
+                         uint32_t key_rollover_interval_seconds,
+                         bool use_model_key_provisioning,
+                         bool use_akv,
+                         const char* akv_app_id, const char* akv_app_pwd, const char* akv_vault_url,
+                         const char* akv_service_key_name,
+                         const char* akv_model_key_name,
+                         const char* akv_attestation_url) = 0;
+
+  virtual int HandleRequest(const char* request_id, uint8_t request_type, uint32_t timeout_ms,
+                            const uint8_t* input_buf, size_t input_size,
+                            uint8_t* output_buf, size_t* output_size, size_t output_max_size) = 0;
+
+  virtual int MaybeRefreshKey() = 0;
+
+  virtual void CancelExpiredRuns() = 0;
+
+  virtual void SetTimingEnabled(bool enabled) = 0;
+
+  virtual uint64_t GetLastInferenceTime() = 0;
+
+  virtual int GetStats(void* stats, size_t stats_size) = 0;
+
+  virtual int SetLogRing(void* ring, size_t ring_size) = 0;
+
+  virtual int Destroy() = 0;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
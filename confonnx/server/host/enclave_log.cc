@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <chrono>
+#include <string>
+
+#include "server/host/enclave_log.h"
+
+namespace onnxruntime {
+namespace server {
+
+// Records wait at most this long before reaching the host sinks.
+static constexpr std::chrono::milliseconds kDrainInterval{10};
+
+EnclaveLog::EnclaveLog(const std::shared_ptr<spdlog::logger>& logger, uint64_t capacity)
+    : size_(LogRingSize(capacity)),
+      memory_(new uint64_t[size_ / sizeof(uint64_t)]),
+      reader_(memory_.get(), capacity),
+      logger_(logger->clone("Enclave")) {
+}
+
+EnclaveLog::~EnclaveLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stop_cv_.notify_all();
+  if (thread_) thread_->join();
+  Drain();
+}
+
+void EnclaveLog::Start() {
+  thread_ = std::make_unique<std::thread>([this]() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      lock.unlock();
+      Drain();
+      lock.lock();
+      stop_cv_.wait_for(lock, kDrainInterval, [this]() { return stop_; });
+    }
+  });
+}
+
+void EnclaveLog::Drain() {
+  uint32_t level;
+  std::string text;
+  while (reader_.Pop(level, text)) {
+    if (level > spdlog::level::critical) {
+      continue;
+    }
+    logger_->log(static_cast<spdlog::level::level_enum>(level), "{}", text);
+  }
+  uint64_t dropped = reader_.Dropped();
+  if (dropped != reported_dropped_) {
+    logger_->warn("{} enclave log messages dropped, log ring full", dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+  }
+}
+
+}  // namespace server
+}  // namespace onnxruntime
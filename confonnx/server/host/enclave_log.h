@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "server/shared/log_ring.h"
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Host memory for the enclave log ring (see EnclaveSetLogRing) and the
+ * thread that forwards its records to the host log sinks.
+ */
+class EnclaveLog {
+ public:
+  explicit EnclaveLog(const std::shared_ptr<spdlog::logger>& logger, uint64_t capacity = 4096);
+  // Forwards the remaining records, the enclave must not write anymore.
+  ~EnclaveLog();
+
+  EnclaveLog(const EnclaveLog&) = delete;
+  void operator=(const EnclaveLog&) = delete;
+
+  void* Data() { return memory_.get(); }
+  size_t Size() const { return size_; }
+
+  void Start();
+
+ private:
+  void Drain();
+
+  const size_t size_;
+  std::unique_ptr<uint64_t[]> memory_;
+  LogRingReader reader_;
+  std::shared_ptr<spdlog::logger> logger_;
+  uint64_t reported_dropped_ = 0;
+  std::unique_ptr<std::thread> thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_cv_;
+  bool stop_ = false;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -10,7 +10,6 @@ namespace server {
 
 ServerEnvironment::ServerEnvironment(spdlog::level::level_enum severity, spdlog::sinks_init_list sink,
                                      const std::string& auth_key) : logger_id_("ServerApp"),
-                                                                    sink_(sink),
                                                                     default_logger_(std::make_shared<spdlog::logger>(logger_id_, sink)),
                                                                     auth_key_(auth_key) {
   spdlog::set_automatic_registration(false);
@@ -18,10 +17,8 @@ ServerEnvironment::ServerEnvironment(spdlog::level::level_enum severity, spdlog:
   spdlog::initialize_logger(default_logger_);
 }
 
-std::shared_ptr<spdlog::logger> ServerEnvironment::GetLogger(const std::string& request_id) const {
-  auto logger = std::make_shared<spdlog::logger>(request_id, sink_.begin(), sink_.end());
-  spdlog::initialize_logger(logger);
-  return logger;
+RequestLogger ServerEnvironment::GetLogger(const std::string& request_id) const {
+  return RequestLogger(default_logger_.get(), request_id.c_str());
 }
 
 std::shared_ptr<spdlog::logger> ServerEnvironment::GetAppLogger() const {
@@ -36,5 +33,13 @@ const std::string& ServerEnvironment::GetAuthKey() const {
   return auth_key_;
 }
 
+Metrics& ServerEnvironment::GetMetrics() {
+  return metrics_;
+}
+
+AdmissionController& ServerEnvironment::GetAdmission() {
+  return admission_;
+}
+
 }  // namespace server
 }  // namespace onnxruntime
@@ -7,6 +7,10 @@
 
 #include <spdlog/spdlog.h>
 
+#include "server/host/admission.h"
+#include "server/host/metrics.h"
+#include "server/shared/request_logger.h"
+
 namespace onnxruntime {
 namespace server {
 
@@ -17,16 +21,20 @@ class ServerEnvironment {
   ~ServerEnvironment() = default;
   ServerEnvironment(const ServerEnvironment&) = delete;
 
-  std::shared_ptr<spdlog::logger> GetLogger(const std::string& request_id) const;
+  // request_id must outlive the returned logger.
+  RequestLogger GetLogger(const std::string& request_id) const;
   std::shared_ptr<spdlog::logger> GetAppLogger() const;
   bool IsAuthEnabled() const;
   const std::string& GetAuthKey() const;
+  Metrics& GetMetrics();
+  AdmissionController& GetAdmission();
 
  private:
   const std::string logger_id_;
-  const std::vector<spdlog::sink_ptr> sink_;
   const std::shared_ptr<spdlog::logger> default_logger_;
   const std::string auth_key_;
+  Metrics metrics_;
+  AdmissionController admission_;
 };
 
 }  // namespace server
@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <dlfcn.h>
+#include <stdexcept>
+
+#include "server/host/in_process_enclave.h"
+
+namespace {
+template <typename F>
+void LoadSymbol(void* handle, const char* name, F* fn) {
+  void* sym = dlsym(handle, name);
+  if (!sym) {
+    throw std::runtime_error(std::string("In-process enclave does not export ") + name);
+  }
+  *fn = reinterpret_cast<F>(sym);
+}
+}  // namespace
+
+namespace onnxruntime {
+namespace server {
+
+// NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+InProcessEnclave::InProcessEnclave(const std::string& library_path) {
+  // RTLD_LOCAL keeps the library's own protobuf, spdlog etc. out of the global namespace.
+  handle = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    throw std::runtime_error(std::string("Loading in-process enclave failed: ") + dlerror());
+  }
+  try {
+    LoadSymbol(handle, "EnclaveInitialize", &EnclaveInitialize);
+    LoadSymbol(handle, "EnclaveHandleRequest", &EnclaveHandleRequest);
+    LoadSymbol(handle, "EnclaveMaybeRefreshKey", &EnclaveMaybeRefreshKey);
+    LoadSymbol(handle, "EnclaveCancelExpiredRuns", &EnclaveCancelExpiredRuns);
+    LoadSymbol(handle, "EnclaveSetTimingEnabled", &EnclaveSetTimingEnabled);
+    LoadSymbol(handle, "EnclaveGetLastInferenceTime", &EnclaveGetLastInferenceTime);
+    LoadSymbol(handle, "EnclaveGetStats", &EnclaveGetStats);
+    LoadSymbol(handle, "EnclaveSetLogRing", &EnclaveSetLogRing);
+    LoadSymbol(handle, "EnclaveDestroy", &EnclaveDestroy);
+  } catch (...) {
+    dlclose(handle);
+    throw;
+  }
+}
+
+InProcessEnclave::~InProcessEnclave() {
+  dlclose(handle);
+}
+
+int InProcessEnclave::Initialize(const uint8_t* model_buf, size_t model_len,
+                                 uint32_t key_rollover_interval_seconds,
+                                 bool use_model_key_provisioning,
+                                 bool use_akv,
+                                 const char* akv_app_id, const char* akv_app_pwd, const char* akv_vault_url,
+                                 const char* akv_service_key_name,
+                                 const char* akv_model_key_name,
+                                 const char* akv_attestation_url) {
+  return EnclaveInitialize(model_buf, model_len, key_rollover_interval_seconds, use_model_key_provisioning,
+                           use_akv, akv_app_id, akv_app_pwd, akv_vault_url,
+                           akv_service_key_name, akv_model_key_name, akv_attestation_url);
+}
+
+int InProcessEnclave::HandleRequest(const char* request_id, uint8_t request_type, uint32_t timeout_ms,
+                                    const uint8_t* input_buf, size_t input_size,
+                                    uint8_t* output_buf, size_t* output_size, size_t output_max_size) {
+  return EnclaveHandleRequest(request_id, request_type, timeout_ms, input_buf, input_size,
+                              output_buf, output_size, output_max_size);
+}
+
+int InProcessEnclave::MaybeRefreshKey() {
+  return EnclaveMaybeRefreshKey();
+}
+
+void InProcessEnclave::CancelExpiredRuns() {
+  EnclaveCancelExpiredRuns();
+}
+
+void InProcessEnclave::SetTimingEnabled(bool enabled) {
+  EnclaveSetTimingEnabled(enabled);
+}
+
+uint64_t InProcessEnclave::GetLastInferenceTime() {
+  return EnclaveGetLastInferenceTime();
+}
+
+int InProcessEnclave::GetStats(void* stats, size_t stats_size) {
+  return EnclaveGetStats(stats, stats_size);
+}
+
+int InProcessEnclave::SetLogRing(void* ring, size_t ring_size) {
+  return EnclaveSetLogRing(ring, ring_size);
+}
+
+int InProcessEnclave::Destroy() {
+  return EnclaveDestroy();
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "server/host/enclave_calls.h"
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * The enclave code built as regular shared library (BUILD_IN_PROCESS_ENCLAVE)
+ * and loaded into the host process. The library exports the entrypoints with the
+ * same signatures as the ECALLs in server.edl, minus the enclave handle and with
+ * the status as return value.
+ *
+ * There is no isolation and no attestation, this is meant for profiling, sanitizers
+ * and benchmarks on machines without SGX and must not be used in production.
+ */
+class InProcessEnclave : public EnclaveCalls {
+ public:
+  explicit InProcessEnclave(const std::string& library_path);
+  ~InProcessEnclave() override;
+
+  InProcessEnclave(const InProcessEnclave&) = delete;
+  void operator=(const InProcessEnclave&) = delete;
+
+  int Initialize(const uint8_t* model_buf, size_t model_len,
+                 uint32_t key_rollover_interval_seconds,
+                 bool use_model_key_provisioning,
+                 bool use_akv,
+                 const char* akv_app_id, const char* akv_app_pwd, const char* akv_vault_url,
+                 const char* akv_service_key_name,
+                 const char* akv_model_key_name,
+                 const char* akv_attestation_url) override;
+
+  int HandleRequest(const char* request_id, uint8_t request_type, uint32_t timeout_ms,
+                    const uint8_t* input_buf, size_t input_size,
+                    uint8_t* output_buf, size_t* output_size, size_t output_max_size) override;
+
+  int MaybeRefreshKey() override;
+
+  void CancelExpiredRuns() override;
+
+  void SetTimingEnabled(bool enabled) override;
+
+  uint64_t GetLastInferenceTime() override;
+
+  int GetStats(void* stats, size_t stats_size) override;
+
+  int SetLogRing(void* ring, size_t ring_size) override;
+
+  int Destroy() override;
+
+ private:
+  void* handle;
+
+  int (*EnclaveInitialize)(const uint8_t* model_buf, size_t model_len,
+                           uint32_t key_rollover_interval_seconds,
+                           bool use_model_key_provisioning,
+                           bool use_akv,
+                           const char* akv_app_id, const char* akv_app_pwd, const char* akv_vault_url,
+                           const char* akv_service_key_name,
+                           const char* akv_model_key_name,
+                           const char* akv_attestation_url);
+
+  int (*EnclaveHandleRequest)(const char* request_id, uint8_t request_type, uint32_t timeout_ms,
+                              const uint8_t* input_buf, size_t input_size,
+                              uint8_t* output_buf, size_t* output_size, size_t output_max_size);
+
+  int (*EnclaveMaybeRefreshKey)();
+
+  void (*EnclaveCancelExpiredRuns)();
+
+  void (*EnclaveSetTimingEnabled)(bool enabled);
+
+  uint64_t (*EnclaveGetLastInferenceTime)();
+
+  int (*EnclaveGetStats)(void* stats, size_t stats_size);
+
+  int (*EnclaveSetLogRing)(void* ring, size_t ring_size);
+
+  int (*EnclaveDestroy)();
+};
+
+}  // namespace server
+}  // namespace onnxruntime
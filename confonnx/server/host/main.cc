@@ -12,6 +12,7 @@
 #include <spdlog/fmt/ostr.h>
 
 #include "server/host/core/http_server.h"
+#include "server/host/async_log_sink.h"
 #include "server/host/environment.h"
 #include "server/host/request_handler.h"
 #include "server/host/server_configuration.h"
@@ -32,10 +33,19 @@ int main(int argc, char* argv[]) {
     exit(EXIT_FAILURE);
   }
 
+  spdlog::sink_ptr stdout_sink = std::make_shared<spdlog::sinks::stdout_sink_mt>();
+  spdlog::sink_ptr syslog_sink = std::make_shared<spdlog::sinks::syslog_sink_mt>();
+  std::shared_ptr<server::AsyncLogSink> async_sink;
+  if (config.log_queue_size > 0) {
+    // Request threads only enqueue, a background thread writes to stdout and syslog.
+    auto overflow_policy = config.log_overflow == "block" ? server::AsyncLogSink::OverflowPolicy::Block
+                                                          : server::AsyncLogSink::OverflowPolicy::Drop;
+    async_sink = std::make_shared<server::AsyncLogSink>(std::vector<spdlog::sink_ptr>{stdout_sink, syslog_sink},
+                                                        config.log_queue_size, overflow_policy);
+  }
   const auto env = std::make_shared<server::ServerEnvironment>(config.logging_level,
-                                                               spdlog::sinks_init_list{
-                                                                   std::make_shared<spdlog::sinks::stdout_sink_mt>(),
-                                                                   std::make_shared<spdlog::sinks::syslog_sink_mt>()},
+                                                               async_sink ? spdlog::sinks_init_list{spdlog::sink_ptr(async_sink)}
+                                                                          : spdlog::sinks_init_list{stdout_sink, syslog_sink},
                                                                config.auth_key);
   auto logger = env->GetAppLogger();
   logger->debug("Logging manager initialized.");
@@ -49,14 +59,29 @@ int main(int argc, char* argv[]) {
   std::chrono::seconds key_sync_interval{config.key_sync_interval_seconds};
   std::chrono::seconds key_error_retry_interval{config.key_error_retry_interval_seconds};
 
+  int status = EXIT_SUCCESS;
   try {
     server::KeyVaultConfig service_kvc(config.akv_app_id, config.akv_app_pwd, config.akv_vault_url, config.akv_service_key_name, config.akv_attestation_url);
     server::KeyVaultConfig model_kvc(config.akv_app_id, config.akv_app_pwd, config.akv_vault_url, config.akv_model_key_name);
 
-    server::Enclave enclave(config.enclave_path, config.debug, config.simulation, env,
+    server::Enclave enclave(config.enclave_path, config.debug, config.simulation, config.in_process, env,
                             std::move(service_kvc), std::move(model_kvc), config.use_model_key_provisioning,
                             key_rollover_interval, key_sync_interval, key_error_retry_interval);
     enclave.Initialize(config.model_path, env);
+    if (config.enclave_stage_metrics) {
+      enclave.SetTimingEnabled(true);
+    }
+    if (config.deadline_check_interval_ms > 0) {
+      enclave.StartDeadlineWatchdog(std::chrono::milliseconds(config.deadline_check_interval_ms), env);
+    }
+
+    server::AdmissionOptions admission_options;
+    admission_options.max_concurrency = config.max_concurrency;
+    admission_options.adaptive = config.adaptive_concurrency;
+    admission_options.min_concurrency = config.min_concurrency;
+    admission_options.max_queue_time = std::chrono::milliseconds(config.max_queue_time_ms);
+    admission_options.retry_after = std::chrono::seconds(config.retry_after_seconds);
+    env->GetAdmission().Configure(admission_options);
 
     auto const boost_address = boost::asio::ip::make_address(config.address);
     server::App app;
@@ -64,14 +89,22 @@ int main(int argc, char* argv[]) {
     app.RegisterStartup(
         [&env](const auto& details) -> void {
           auto logger = env->GetAppLogger();
-          logger->info("Listening at: http://{}:{}", details.address.to_string(), details.port);
+          if (details.listen_tcp) {
+            logger->info("Listening at: http://{}:{}", details.address.to_string(), details.port);
+          }
+          if (!details.unix_socket.empty()) {
+            logger->info("Listening at: unix:{}", details.unix_socket);
+          }
+          if (details.rpc_port != 0) {
+            logger->info("Listening for RPC at: {}:{}", details.address.to_string(), details.rpc_port);
+          }
         });
 
     app.RegisterError(
         [&env](auto& context) -> void {
           auto logger = env->GetLogger(context.request_id);
-          logger->debug("Error code: {}", context.error_code);
-          logger->debug("Error message: {}", context.error_message);
+          logger.debug("Error code: {}", context.error_code);
+          logger.debug("Error message: {}", context.error_message);
 
           context.response.result(context.error_code);
           context.response.insert("Content-Type", "application/json");
@@ -79,7 +112,18 @@ int main(int argc, char* argv[]) {
           if (!context.client_request_id.empty()) {
             context.response.insert("x-ms-client-request-id", (context).client_request_id);
           }
-          context.response.body() = server::CreateJsonError(-1, context.error_message);
+          context.response.body().assign(server::CreateJsonError(-1, context.error_message));
+        });
+
+    app.RegisterCompletion(
+        [&env](const auto& context) -> void {
+          env->GetMetrics().RecordRequest(context);
+        });
+
+    app.RegisterGet(
+        R"(/metrics)",
+        [&env, &enclave](auto& context) -> void {
+          server::HandleMetricsRequest(context, enclave, env);
         });
 
     app.RegisterPost(
@@ -88,23 +132,75 @@ int main(int argc, char* argv[]) {
           server::HandleRequest(context, RequestType::Score, enclave, env);
         });
 
+    app.RegisterPost(
+        R"(/scoreBinary)",
+        [&env, &enclave](auto& context) -> void {
+          server::HandleRequest(context, RequestType::ScoreBinary, enclave, env);
+        });
+
     app.RegisterPost(
         R"(/provisionModelKey)",
         [&env, &enclave](auto& context) -> void {
           server::HandleRequest(context, RequestType::ProvisionModelKey, enclave, env);
         });
 
+    app.RegisterPost(
+        R"(/updateModel)",
+        [&env, &enclave](auto& context) -> void {
+          server::HandleRequest(context, RequestType::UpdateModel, enclave, env);
+        });
+
+    if (!config.unix_socket.empty()) {
+      app.BindUnix(config.unix_socket, config.unix_socket_mode);
+    }
+
+    if (config.rpc_port != 0) {
+      server::RpcOptions rpc_options;
+      rpc_options.max_in_flight = config.rpc_max_in_flight;
+      rpc_options.max_payload_size = static_cast<size_t>(config.max_request_size_mb) * 1024 * 1024;
+      rpc_options.max_request_type = static_cast<uint8_t>(RequestType::ScoreBinary);
+      rpc_options.idle_timeout = std::chrono::seconds(config.rpc_idle_timeout_seconds);
+      rpc_options.read_timeout = std::chrono::seconds(config.rpc_read_timeout_seconds);
+      rpc_options.write_timeout = std::chrono::seconds(config.rpc_write_timeout_seconds);
+      app.RegisterRpc(
+          config.rpc_port,
+          [&env, &enclave](const auto& request, auto& response) -> void {
+            server::HandleRpcRequest(request, response, enclave, env);
+          },
+          rpc_options);
+    }
+
+    server::HttpSessionOptions http_options;
+    http_options.max_in_flight = config.http_max_in_flight;
+    http_options.body_limit = static_cast<uint64_t>(config.max_request_size_mb) * 1024 * 1024;
+    http_options.idle_timeout = std::chrono::seconds(config.http_idle_timeout_seconds);
+    http_options.header_timeout = std::chrono::seconds(config.http_header_timeout_seconds);
+    http_options.body_timeout = std::chrono::seconds(config.http_body_timeout_seconds);
+    http_options.write_timeout = std::chrono::seconds(config.http_write_timeout_seconds);
+
     app.Bind(boost_address, config.http_port)
+        .ListenTcp(!config.unix_socket_only)
         .NumThreads(config.num_http_threads)
+        .ReusePort(config.http_reuse_port)
+        .PinThreads(config.http_pin_threads)
+        .HttpOptions(http_options)
+        .MaxConnections(config.max_connections)
         .Run();
   } catch (std::exception& exc) {
     std::string name = typeid(exc).name();
     logger->critical("ERROR ({}): {}", name, exc.what());
-    exit(EXIT_FAILURE);
+    status = EXIT_FAILURE;
   } catch (...) {
     logger->critical("Unknown error occurred");
-    exit(EXIT_FAILURE);
+    status = EXIT_FAILURE;
   }
 
-  return EXIT_SUCCESS;
+  // Loggers are also referenced by the spdlog registry and the enclave log
+  // drain, so the async sink is not necessarily destroyed with env.
+  // Write out the queued messages before exiting.
+  if (async_sink) {
+    async_sink->Stop();
+  }
+  spdlog::shutdown();
+  return status;
 }
@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <sstream>
+
+#include "server/host/core/context.h"
+#include "server/host/metrics.h"
+
+namespace onnxruntime {
+namespace server {
+
+static void WriteHeader(std::ostream& out, const char* name, const char* type, const char* help) {
+  out << "# HELP " << name << " " << help << "\n"
+      << "# TYPE " << name << " " << type << "\n";
+}
+
+// Writes one histogram series, labels is either empty or a list like stage="run",
+// Prometheus expects cumulative buckets.
+static void WriteHistogram(std::ostream& out, const char* name, const std::string& labels,
+                           const HistogramSnapshot& snapshot) {
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < kLatencyBucketCount; i++) {
+    cumulative += snapshot.buckets[i];
+    out << name << "_bucket{" << labels << "le=\"" << kLatencyBucketBoundsUs[i] / 1e6 << "\"} " << cumulative << "\n";
+  }
+  cumulative += snapshot.buckets[kLatencyBucketCount];
+  out << name << "_bucket{" << labels << "le=\"+Inf\"} " << cumulative << "\n";
+  // The snapshot is not atomic, use the bucket total so that _count matches +Inf.
+  std::string series_labels = labels.empty() ? "" : "{" + labels.substr(0, labels.size() - 1) + "}";
+  out << name << "_sum" << series_labels << " " << snapshot.sum_ns / 1e9 << "\n"
+      << name << "_count" << series_labels << " " << cumulative << "\n";
+}
+
+static void WriteHistogram(std::ostream& out, const char* name, const char* help,
+                           const LatencyHistogram& histogram) {
+  HistogramSnapshot snapshot;
+  histogram.Snapshot(snapshot);
+  WriteHeader(out, name, "histogram", help);
+  WriteHistogram(out, name, "", snapshot);
+}
+
+Metrics::Metrics() {
+  for (auto& count : http_responses_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  for (auto& count : ecall_status_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::RecordRequest(const HttpContext& context) {
+  // Not set for requests that failed before the body was read.
+  if (context.read_end != std::chrono::steady_clock::time_point()) {
+    http_read_.Record(context.read_end - context.read_start);
+    queue_wait_.Record(context.handler_start - context.read_end);
+  }
+  int status = static_cast<int>(context.response.result());
+  if (status >= 0 && status < kMaxHttpStatus) {
+    http_responses_[status].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::RecordEcall(std::chrono::nanoseconds duration, int status) {
+  ecall_.Record(duration);
+  if (status >= 0 && status < kMaxEcallStatus) {
+    ecall_status_[status].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::RecordEcallSDKError() {
+  ecall_sdk_errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::RecordAdmission(std::chrono::nanoseconds queue_time, AdmissionResult result) {
+  admission_queue_time_.Record(queue_time);
+  if (result == AdmissionResult::LimitReached) {
+    admission_rejected_limit_.fetch_add(1, std::memory_order_relaxed);
+  } else if (result == AdmissionResult::QueueTimeout) {
+    admission_rejected_queue_timeout_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::RecordDeadlineExpired() {
+  deadline_expired_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string Metrics::Render(const EnclaveStats& enclave_stats, const AdmissionStats& admission_stats) const {
+  std::ostringstream out;
+  // Enough digits for sums of long-running processes.
+  out.precision(15);
+
+  WriteHistogram(out, "confonnx_http_read_seconds",
+                 "Time to read the HTTP request body after the header.", http_read_);
+  WriteHistogram(out, "confonnx_queue_wait_seconds",
+                 "Time between reading the request and handling it.", queue_wait_);
+  WriteHistogram(out, "confonnx_ecall_duration_seconds",
+                 "Duration of request ECALLs including enclave transitions.", ecall_);
+
+  WriteHistogram(out, "confonnx_admission_queue_seconds",
+                 "Time from reading a score request to its admission decision, only with admission control.",
+                 admission_queue_time_);
+
+  WriteHeader(out, "confonnx_admission_rejected_total", "counter", "Score requests rejected by admission control.");
+  out << "confonnx_admission_rejected_total{reason=\"limit\"} " << admission_rejected_limit_.load(std::memory_order_relaxed) << "\n"
+      << "confonnx_admission_rejected_total{reason=\"queue_timeout\"} " << admission_rejected_queue_timeout_.load(std::memory_order_relaxed) << "\n";
+
+  WriteHeader(out, "confonnx_admission_limit", "gauge", "Current limit of concurrent score requests, 0 if unlimited.");
+  out << "confonnx_admission_limit " << admission_stats.limit << "\n";
+  WriteHeader(out, "confonnx_admission_in_flight", "gauge", "Admitted score requests that did not finish yet.");
+  out << "confonnx_admission_in_flight " << admission_stats.in_flight << "\n";
+
+  WriteHeader(out, "confonnx_deadline_expired_total", "counter", "Score requests not started because their deadline had passed.");
+  out << "confonnx_deadline_expired_total " << deadline_expired_.load(std::memory_order_relaxed) << "\n";
+
+  WriteHeader(out, "confonnx_http_responses_total", "counter", "HTTP responses by status code.");
+  for (int i = 0; i < kMaxHttpStatus; i++) {
+    uint64_t count = http_responses_[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      out << "confonnx_http_responses_total{code=\"" << i << "\"} " << count << "\n";
+    }
+  }
+
+  WriteHeader(out, "confonnx_ecall_status_total", "counter", "Request ECALLs by returned status, see status.h.");
+  for (int i = 0; i < kMaxEcallStatus; i++) {
+    uint64_t count = ecall_status_[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      out << "confonnx_ecall_status_total{code=\"" << i << "\"} " << count << "\n";
+    }
+  }
+  out << "confonnx_ecall_status_total{code=\"sdk_error\"} " << ecall_sdk_errors_.load(std::memory_order_relaxed) << "\n";
+
+  WriteHeader(out, "confonnx_enclave_stage_seconds", "histogram",
+              "Duration of score request stages inside the enclave, only if enabled.");
+  for (size_t i = 0; i < kEnclaveStageCount; i++) {
+    std::string labels = std::string("stage=\"") + EnclaveStageName(static_cast<EnclaveStage>(i)) + "\",";
+    WriteHistogram(out, "confonnx_enclave_stage_seconds", labels, enclave_stats.stages[i]);
+  }
+
+  WriteHeader(out, "confonnx_key_refresh_total", "counter", "Periodic key refresh attempts by outcome.");
+  out << "confonnx_key_refresh_total{outcome=\"refreshed\"} " << enclave_stats.key_refresh_refreshed << "\n"
+      << "confonnx_key_refresh_total{outcome=\"unchanged\"} " << enclave_stats.key_refresh_unchanged << "\n"
+      << "confonnx_key_refresh_total{outcome=\"failed\"} " << enclave_stats.key_refresh_failed << "\n";
+
+  WriteHeader(out, "confonnx_runs_terminated_total", "counter", "Inference runs terminated inside the enclave because their deadline passed.");
+  out << "confonnx_runs_terminated_total " << enclave_stats.runs_terminated << "\n";
+
+  return out.str();
+}
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "server/host/admission.h"
+#include "server/shared/metrics.h"
+
+namespace onnxruntime {
+namespace server {
+
+class HttpContext;
+
+/**
+ * Request metrics of the host process. Rendered together with the statistics
+ * aggregated inside the enclave in the Prometheus text format on GET /metrics.
+ */
+class Metrics {
+ public:
+  Metrics();
+  Metrics(const Metrics&) = delete;
+  void operator=(const Metrics&) = delete;
+
+  // Records the read and queue wait time and the response status of a finished request.
+  void RecordRequest(const HttpContext& context);
+
+  // Records the duration and returned status of an EnclaveHandleRequest call.
+  void RecordEcall(std::chrono::nanoseconds duration, int status);
+
+  // Records an ECALL that failed in the enclave SDK, without a status from the enclave.
+  void RecordEcallSDKError();
+
+  // Records the time from reading a request to its admission decision and whether it was admitted.
+  void RecordAdmission(std::chrono::nanoseconds queue_time, AdmissionResult result);
+
+  // Records a score request that was not started because its deadline had passed.
+  void RecordDeadlineExpired();
+
+  std::string Render(const EnclaveStats& enclave_stats, const AdmissionStats& admission_stats) const;
+
+ private:
+  static constexpr int kMaxHttpStatus = 600;
+  static constexpr int kMaxEcallStatus = 32;
+
+  LatencyHistogram http_read_;
+  LatencyHistogram queue_wait_;
+  LatencyHistogram ecall_;
+  LatencyHistogram admission_queue_time_;
+  std::atomic<uint64_t> admission_rejected_limit_{0};
+  std::atomic<uint64_t> admission_rejected_queue_timeout_{0};
+  std::atomic<uint64_t> deadline_expired_{0};
+  std::atomic<uint64_t> http_responses_[kMaxHttpStatus];
+  std::atomic<uint64_t> ecall_status_[kMaxEcallStatus];
+  std::atomic<uint64_t> ecall_sdk_errors_{0};
+};
+
+}  // namespace server
+}  // namespace onnxruntime
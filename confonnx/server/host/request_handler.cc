@@ -1,6 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+
 #include "server/shared/constants.h"
 #include "server/host/core/http_server.h"
 #include "server/host/environment.h"
@@ -18,65 +26,236 @@ namespace server {
       (context).response.insert("x-ms-client-request-id", (context).client_request_id);  \
     }                                                                                    \
     auto json_error_message = CreateJsonError((app_error_code), (message));              \
-    logger->debug(json_error_message);                                                   \
+    logger.debug(json_error_message);                                                    \
     (context).response.result((http_error_code));                                        \
-    (context).response.body() = json_error_message;                                      \
+    (context).response.body().assign(json_error_message);                                \
     (context).response.set(http::field::content_type, "application/json");               \
   }
 
+static bool IsAuthorized(const HttpContext& context, const std::shared_ptr<ServerEnvironment>& env) {
+  if (!env->IsAuthEnabled()) {
+    return true;
+  }
+  if (context.request.find(http::field::authorization) == context.request.end()) {
+    return false;
+  }
+  return context.request[http::field::authorization] == "Bearer " + env->GetAuthKey();
+}
+
+// Returned by CallEnclave for errors outside the enclave.
+constexpr int kHostError = -1;
+constexpr int kOverloaded = -2;
+
+// Time in milliseconds the client waits for the response, counted from when
+// the request header was received. Requests past it are not worth finishing.
+// 0 means no deadline, like a missing header and the RPC timeout field.
+static const char* const kDeadlineHeader = "x-ms-deadline-ms";
+
+using Clock = std::chrono::steady_clock;
+
+// Reads the deadline from the request header, max if there is none.
+// Returns false if the header is not a non-negative 32 bit integer.
+static bool ParseDeadline(const HttpContext& context, /* out */ Clock::time_point& deadline) {
+  deadline = Clock::time_point::max();
+  auto header = context.request.find(kDeadlineHeader);
+  if (header == context.request.end()) {
+    return true;
+  }
+  // strtoul skips whitespace and accepts a sign, only digits are valid here.
+  std::string value = header->value().to_string();
+  if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0]))) {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  unsigned long timeout_ms = std::strtoul(value.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0' || timeout_ms > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  if (timeout_ms > 0) {
+    deadline = context.read_start + std::chrono::milliseconds(timeout_ms);
+  }
+  return true;
+}
+
+static bool IsScoreRequest(RequestType request_type) {
+  return request_type == RequestType::Score || request_type == RequestType::ScoreBinary;
+}
+
+// Runs a request in the enclave, writing the response into output, and records the ECALL.
+// Score requests first pass admission control, which counts the time since read_end as
+// queue time, and are only started before their deadline, the time left is forwarded to the enclave.
+// Returns SUCCESS, the EnclaveCallStatus of a failed request, kHostError if the enclave
+// could not be called, or kOverloaded if admission control rejected the request.
+// On errors, error_message is set.
+static int CallEnclave(const std::string& request_id,
+                       RequestType request_type,
+                       Clock::time_point read_end,
+                       Clock::time_point deadline,
+                       const PooledBuffer& input,
+                       /* out */ PooledBuffer& output,
+                       /* out */ std::string& error_message,
+                       Enclave& enclave,
+                       const std::shared_ptr<ServerEnvironment>& env) {
+  Metrics& metrics = env->GetMetrics();
+  AdmissionController& admission = env->GetAdmission();
+  AdmissionController::Ticket ticket;
+  bool has_deadline = IsScoreRequest(request_type) && deadline != Clock::time_point::max();
+  if (admission.IsEnabled() && IsScoreRequest(request_type)) {
+    AdmissionResult result = admission.Admit(ticket, read_end);
+    metrics.RecordAdmission(Clock::now() - read_end, result);
+    if (result != AdmissionResult::Admitted && !(has_deadline && Clock::now() >= deadline)) {
+      error_message = "Server overloaded, retry later";
+      return kOverloaded;
+    }
+  }
+
+  std::chrono::milliseconds timeout{0};
+  if (has_deadline) {
+    // Rounded up, zero would mean no deadline.
+    auto left = deadline - Clock::now();
+    timeout = std::chrono::duration_cast<std::chrono::milliseconds>(left);
+    if (timeout < left) {
+      timeout += std::chrono::milliseconds(1);
+    }
+    if (timeout.count() <= 0) {
+      metrics.RecordDeadlineExpired();
+      error_message = "Deadline exceeded before the request was started";
+      return DEADLINE_EXCEEDED_ERROR;
+    }
+  }
+
+  // The enclave reads the pooled input buffer and writes into the pooled output buffer
+  // directly. Responses are usually much smaller than MAX_OUTPUT_SIZE, small ones are
+  // moved out of the large buffer afterwards so that it is not held until they are sent.
+  output.resize(MAX_OUTPUT_SIZE);
+  size_t output_size;
+  auto ecall_start = std::chrono::steady_clock::now();
+  try {
+    enclave.HandleRequest(request_id, request_type, input.data(), input.size(), output.data(), &output_size, env, timeout);
+    auto ecall_duration = std::chrono::steady_clock::now() - ecall_start;
+    metrics.RecordEcall(ecall_duration, SUCCESS);
+    ticket.SetLatency(ecall_duration);
+  } catch (EnclaveSDKError& exc) {
+    metrics.RecordEcallSDKError();
+    output.clear();
+    error_message = exc.what();
+    return kHostError;
+  } catch (EnclaveCallError& exc) {
+    auto ecall_duration = std::chrono::steady_clock::now() - ecall_start;
+    metrics.RecordEcall(ecall_duration, exc.status);
+    ticket.SetLatency(ecall_duration);
+    output.clear();
+    error_message = exc.what();
+    return exc.status;
+  }
+  output.resize(output_size);
+  output.shrink_to_fit();
+  return SUCCESS;
+}
+
 void HandleRequest(/* in, out */ HttpContext& context,
                    RequestType request_type,
                    Enclave& enclave,
                    const std::shared_ptr<ServerEnvironment>& env) {
   auto logger = env->GetLogger(context.request_id);
 
-  if (env->IsAuthEnabled()) {
-    bool auth_ok = false;
-    if (context.request.find(http::field::authorization) != context.request.end()) {
-      auth_ok = context.request[http::field::authorization] == "Bearer " + env->GetAuthKey();
-    }
-    if (!auth_ok) {
-      auto msg = "Invalid authorization key";
-      GenerateErrorResponse(logger, http::status::unauthorized, -1, msg, context);
-      return;
-    }
+  if (!IsAuthorized(context, env)) {
+    auto msg = "Invalid authorization key";
+    GenerateErrorResponse(logger, http::status::unauthorized, -1, msg, context);
+    return;
   }
 
   if (!context.client_request_id.empty()) {
-    logger->info("x-ms-client-request-id: [{}]", context.client_request_id);
+    logger.info("x-ms-client-request-id: [{}]", context.client_request_id);
   }
 
-  // Forward request to enclave.
-  auto body = context.request.body();
-  const uint8_t* input_buf = (uint8_t*)body.c_str();
-  size_t input_size = body.size();
-  // TODO keep thread local static buffers around
-  std::vector<uint8_t> output_vec(MAX_OUTPUT_SIZE);
-  uint8_t* output_buf = output_vec.data();
-  size_t output_size;
-  try {
-    enclave.HandleRequest(context.request_id, request_type, input_buf, input_size, output_buf, &output_size, env);
-  } catch (EnclaveSDKError& exc) {
-    auto message = exc.what();
+  Clock::time_point deadline;
+  if (!ParseDeadline(context, deadline)) {
+    auto msg = std::string("Invalid ") + kDeadlineHeader + " header";
+    GenerateErrorResponse(logger, http::status::bad_request, -1, msg, context);
+    return;
+  }
+
+  // Forward request to enclave
+  std::string message;
+  int status = CallEnclave(context.request_id, request_type, context.read_end, deadline, context.request.body(), context.response.body(),
+                           message, enclave, env);
+  if (status == kHostError) {
     GenerateErrorResponse(logger, http::status::internal_server_error, -1, message, context);
     return;
-  } catch (EnclaveCallError& exc) {
-    auto message = exc.what();
-    auto status = exc.status;
+  }
+  if (status == kOverloaded) {
+    GenerateErrorResponse(logger, http::status::service_unavailable, -1, message, context);
+    context.response.set(http::field::retry_after, std::to_string(env->GetAdmission().GetOptions().retry_after.count()));
+    return;
+  }
+  if (status == DEADLINE_EXCEEDED_ERROR) {
+    GenerateErrorResponse(logger, http::status::gateway_timeout, status, "Deadline exceeded", context);
+    return;
+  }
+  if (status != SUCCESS) {
     GenerateErrorResponse(logger, http::status::bad_request, status, message, context);
     return;
   }
 
   // Build HTTP response
-  std::string response_body((char*)output_buf, output_size);
   context.response.set(http::field::content_type, "application/octet-stream");
   context.response.insert("x-ms-request-id", context.request_id);
   if (!context.client_request_id.empty()) {
     context.response.insert("x-ms-client-request-id", context.client_request_id);
   }
-  context.response.body() = response_body;
   context.response.result(http::status::ok);
 };
 
+void HandleRpcRequest(const RpcRequest& request,
+                      /* out */ RpcResponse& response,
+                      Enclave& enclave,
+                      const std::shared_ptr<ServerEnvironment>& env) {
+  std::string request_id = util::InternalRequestId();
+  auto logger = env->GetLogger(request_id);
+  logger.debug("RPC request tag: {}", request.tag);
+
+  auto deadline = request.timeout_ms == 0 ? Clock::time_point::max()
+                                          : request.received + std::chrono::milliseconds(request.timeout_ms);
+  std::string message;
+  response.status = CallEnclave(request_id, static_cast<RequestType>(request.request_type), request.received, deadline,
+                                request.payload, response.payload, message, enclave, env);
+  if (response.status != SUCCESS) {
+    logger.debug("RPC error status {}: {}", response.status, message);
+    response.payload.assign(message);
+  }
+}
+
+void HandleMetricsRequest(/* in, out */ HttpContext& context,
+                          Enclave& enclave,
+                          const std::shared_ptr<ServerEnvironment>& env) {
+  auto logger = env->GetLogger(context.request_id);
+
+  if (!IsAuthorized(context, env)) {
+    auto msg = "Invalid authorization key";
+    GenerateErrorResponse(logger, http::status::unauthorized, -1, msg, context);
+    return;
+  }
+
+  EnclaveStats enclave_stats;
+  try {
+    enclave.GetStats(enclave_stats);
+  } catch (EnclaveSDKError& exc) {
+    auto message = exc.what();
+    GenerateErrorResponse(logger, http::status::internal_server_error, -1, message, context);
+    return;
+  } catch (EnclaveCallError& exc) {
+    auto message = exc.what();
+    GenerateErrorResponse(logger, http::status::internal_server_error, exc.status, message, context);
+    return;
+  }
+
+  context.response.set(http::field::content_type, "text/plain; version=0.0.4");
+  context.response.insert("x-ms-request-id", context.request_id);
+  context.response.body().assign(env->GetMetrics().Render(enclave_stats, env->GetAdmission().Stats()));
+  context.response.result(http::status::ok);
+}
+
 }  // namespace server
 }  // namespace onnxruntime
@@ -21,5 +21,17 @@ void HandleRequest(/* in, out */ HttpContext& context,
                    Enclave& enclave,
                    const std::shared_ptr<ServerEnvironment>& env);
 
+// Handles a request of the binary RPC transport like HandleRequest, without HTTP.
+// The request type byte is passed on to the enclave, which rejects unknown types.
+void HandleRpcRequest(const RpcRequest& request,
+                      /* out */ RpcResponse& response,
+                      Enclave& enclave,
+                      const std::shared_ptr<ServerEnvironment>& env);
+
+// Responds with host and enclave metrics in the Prometheus text format.
+void HandleMetricsRequest(/* in, out */ HttpContext& context,
+                          Enclave& enclave,
+                          const std::shared_ptr<ServerEnvironment>& env);
+
 }  // namespace server
 }  // namespace onnxruntime
@@ -79,11 +79,38 @@ class ServerConfiguration {
   int key_error_retry_interval_seconds = 60 * 5;     // 5 min
   std::string address = "0.0.0.0";
   int http_port = 8001;
+  std::string unix_socket;
+  int unix_socket_mode = 0660;
+  bool unix_socket_only = false;
+  int rpc_port = 0;
+  int rpc_max_in_flight = 64;
+  int rpc_idle_timeout_seconds = 60;
+  int rpc_read_timeout_seconds = 60;
+  int rpc_write_timeout_seconds = 60;
+  int max_concurrency = 0;
+  int min_concurrency = 1;
+  bool adaptive_concurrency = false;
+  int max_queue_time_ms = 1000;
+  int retry_after_seconds = 1;
+  int deadline_check_interval_ms = 10;
   std::string auth_key;
   int num_http_threads = std::thread::hardware_concurrency();
+  int http_max_in_flight = 8;
+  int max_connections = 0;
+  int max_request_size_mb = 25;
+  int http_idle_timeout_seconds = 60;
+  int http_header_timeout_seconds = 10;
+  int http_body_timeout_seconds = 60;
+  int http_write_timeout_seconds = 60;
+  bool http_reuse_port = false;
+  bool http_pin_threads = false;
   spdlog::level::level_enum logging_level{};
+  int log_queue_size = 8192;
+  std::string log_overflow = "drop";
   bool debug = false;
   bool simulation = false;
+  bool in_process = false;
+  bool enclave_stage_metrics = false;
   bool use_akv = false;
   bool use_model_key_provisioning = false;
   std::string akv_app_id;
@@ -96,15 +123,40 @@ class ServerConfiguration {
   ServerConfiguration() {
     desc.add_options()("help,h", "Shows a help message and exits");
     desc.add_options()("log-level", po::value(&log_level_str)->default_value(log_level_str), "Logging level. Allowed options (case sensitive): verbose, info, warning, error, fatal");
+    desc.add_options()("log-queue-size", po::value(&log_queue_size)->default_value(log_queue_size), "Number of log messages queued for the background log writer, 0 writes synchronously");
+    desc.add_options()("log-overflow", po::value(&log_overflow)->default_value(log_overflow), "What to do when the log queue is full. Allowed options: block, drop");
     desc.add_options()("enclave-path", po::value(&enclave_path)->default_value(enclave_path), "Path to enclave binary");
     desc.add_options()("model-path", po::value(&model_path)->required(), "Path to ONNX model");
     desc.add_options()("address", po::value(&address)->default_value(address), "The base HTTP address");
     desc.add_options()("http-port", po::value(&http_port)->default_value(http_port), "HTTP port to listen to requests");
+    desc.add_options()("unix-socket", po::value(&unix_socket), "Path of a Unix domain socket to additionally listen to requests, e.g. from a local reverse proxy");
+    desc.add_options()("unix-socket-mode", po::value(&unix_socket_mode_str)->default_value(unix_socket_mode_str), "Permission bits (octal) of the Unix domain socket file");
+    desc.add_options()("unix-socket-only", po::bool_switch(&unix_socket_only), "Listen on --unix-socket only and not on --address/--http-port");
+    desc.add_options()("rpc-port", po::value(&rpc_port)->default_value(rpc_port), "TCP port for the binary RPC transport for internal callers, 0 disables it");
+    desc.add_options()("rpc-max-in-flight", po::value(&rpc_max_in_flight)->default_value(rpc_max_in_flight), "Requests per RPC connection that are handled at the same time");
+    desc.add_options()("rpc-idle-timeout", po::value(&rpc_idle_timeout_seconds)->default_value(rpc_idle_timeout_seconds), "Seconds an RPC connection may stay idle without requests in flight before it is closed, 0 disables the timeout");
+    desc.add_options()("rpc-read-timeout", po::value(&rpc_read_timeout_seconds)->default_value(rpc_read_timeout_seconds), "Seconds a client may take to send an RPC frame once it started, 0 disables the timeout");
+    desc.add_options()("rpc-write-timeout", po::value(&rpc_write_timeout_seconds)->default_value(rpc_write_timeout_seconds), "Seconds a client may take to receive RPC responses, 0 disables the timeout");
+    desc.add_options()("max-concurrency", po::value(&max_concurrency)->default_value(max_concurrency), "Score requests handled by the enclave at the same time, further requests get 503, 0 is unlimited");
+    desc.add_options()("adaptive-concurrency", po::bool_switch(&adaptive_concurrency), "Adapt the concurrency limit between --min-concurrency and --max-concurrency to the enclave latency");
+    desc.add_options()("min-concurrency", po::value(&min_concurrency)->default_value(min_concurrency), "Lower bound of the adaptive concurrency limit");
+    desc.add_options()("max-queue-time-ms", po::value(&max_queue_time_ms)->default_value(max_queue_time_ms), "Time a score request may be queued on the server after it was read before it gets 503, only with --max-concurrency, 0 disables the check");
+    desc.add_options()("retry-after", po::value(&retry_after_seconds)->default_value(retry_after_seconds), "Retry-After header value in seconds of 503 responses");
+    desc.add_options()("deadline-check-interval-ms", po::value(&deadline_check_interval_ms)->default_value(deadline_check_interval_ms), "How often in-flight score requests are checked against their x-ms-deadline-ms and terminated, 0 only rejects requests that expired before the enclave call");
     desc.add_options()("auth-key", po::value(&auth_key), "Authorization key (for development without frontend server)");
     desc.add_options()("key-rollover-interval", po::value(&key_rollover_interval_seconds)->default_value(key_rollover_interval_seconds), "Key rollover interval in seconds");
     desc.add_options()("key-sync-interval", po::value(&key_sync_interval_seconds)->default_value(key_sync_interval_seconds), "Key sync interval in seconds");
     desc.add_options()("key-error-retry-interval", po::value(&key_error_retry_interval_seconds)->default_value(key_error_retry_interval_seconds), "Key rollover/sync error retry interval in seconds");
     desc.add_options()("num-http-threads", po::value(&num_http_threads)->default_value(num_http_threads), "Number of http threads");
+    desc.add_options()("http-max-in-flight", po::value(&http_max_in_flight)->default_value(http_max_in_flight), "Pipelined requests per HTTP connection that are handled at the same time");
+    desc.add_options()("max-connections", po::value(&max_connections)->default_value(max_connections), "HTTP and RPC connections open at the same time, further connections are closed right away, 0 is unlimited");
+    desc.add_options()("max-request-size-mb", po::value(&max_request_size_mb)->default_value(max_request_size_mb), "Maximum HTTP request body and RPC payload size in MiB");
+    desc.add_options()("http-idle-timeout", po::value(&http_idle_timeout_seconds)->default_value(http_idle_timeout_seconds), "Seconds a keep-alive connection may stay idle before it is closed, 0 disables the timeout");
+    desc.add_options()("http-header-timeout", po::value(&http_header_timeout_seconds)->default_value(http_header_timeout_seconds), "Seconds a client may take to send a request header once it started, 0 disables the timeout");
+    desc.add_options()("http-body-timeout", po::value(&http_body_timeout_seconds)->default_value(http_body_timeout_seconds), "Seconds a client may take to send a request body, 0 disables the timeout");
+    desc.add_options()("http-write-timeout", po::value(&http_write_timeout_seconds)->default_value(http_write_timeout_seconds), "Seconds a client may take to receive a response, 0 disables the timeout");
+    desc.add_options()("http-reuse-port", po::bool_switch(&http_reuse_port), "Give each http thread its own event loop and SO_REUSEPORT listener, the kernel spreads connections between them");
+    desc.add_options()("http-pin-threads", po::bool_switch(&http_pin_threads), "Pin each http thread to one CPU");
     desc.add_options()("use-model-key-provisioning", po::bool_switch(&use_model_key_provisioning), "Provision model key via API request");
     desc.add_options()("use-akv", po::bool_switch(&use_akv), "Use Azure Key Vault for key management, required for distributed deployment of server");
     desc.add_options()("akv-app-id", po::value(&akv_app_id), "ID of Azure enterprise application used to access AKV");
@@ -115,6 +167,8 @@ class ServerConfiguration {
     desc.add_options()("akv-attestation-url", po::value(&akv_attestation_url), "URL of Azure Attestation Service used with AKV");
     desc.add_options()("debug", po::bool_switch(&debug), "Allow loading of unsigned debug enclaves");
     desc.add_options()("simulation", po::bool_switch(&simulation), "Run in simulation mode on non-SGX hardware");
+    desc.add_options()("in-process", po::bool_switch(&in_process), "Load --enclave-path as in-process build of the enclave code without isolation, for profiling only");
+    desc.add_options()("enclave-stage-metrics", po::bool_switch(&enclave_stage_metrics), "Measure the stages of score requests inside the enclave for /metrics, costs additional OCALLs per request");
   }
 
   // Parses argc and argv and sets the values for the class
@@ -152,6 +206,7 @@ class ServerConfiguration {
   po::options_description desc{"Allowed options"};
   po::variables_map vm{};
   std::string log_level_str = "info";
+  std::string unix_socket_mode_str = "660";
 
   // Print help and return if there is a bad value
   Result ValidateOptions() {
@@ -159,6 +214,71 @@ class ServerConfiguration {
       PrintHelp(std::cerr, "--log-level must be one of verbose, info, warning, error, or fatal");
       return Result::ExitFailure;
     }
+    if (log_queue_size < 0) {
+      PrintHelp(std::cerr, "--log-queue-size must not be negative");
+      return Result::ExitFailure;
+    }
+    if (log_overflow != "block" && log_overflow != "drop") {
+      PrintHelp(std::cerr, "--log-overflow must be one of block or drop");
+      return Result::ExitFailure;
+    }
+    if (!ParseFileMode(unix_socket_mode_str, unix_socket_mode)) {
+      PrintHelp(std::cerr, "--unix-socket-mode must be an octal number between 0 and 777");
+      return Result::ExitFailure;
+    }
+    if (unix_socket_only && unix_socket.empty()) {
+      PrintHelp(std::cerr, "--unix-socket-only requires --unix-socket");
+      return Result::ExitFailure;
+    }
+    if (rpc_port < 0 || rpc_port > 65535 || (rpc_port != 0 && rpc_port == http_port)) {
+      PrintHelp(std::cerr, "--rpc-port must be a free port number or 0");
+      return Result::ExitFailure;
+    }
+    if (rpc_port != 0 && !auth_key.empty()) {
+      PrintHelp(std::cerr, "--rpc-port cannot be used with --auth-key, the RPC transport has no authorization");
+      return Result::ExitFailure;
+    }
+    if (rpc_max_in_flight <= 0) {
+      PrintHelp(std::cerr, "--rpc-max-in-flight must be greater than 0");
+      return Result::ExitFailure;
+    }
+    if (rpc_idle_timeout_seconds < 0 || rpc_read_timeout_seconds < 0 || rpc_write_timeout_seconds < 0) {
+      PrintHelp(std::cerr, "The --rpc-*-timeout options must not be negative");
+      return Result::ExitFailure;
+    }
+    if (max_concurrency < 0) {
+      PrintHelp(std::cerr, "--max-concurrency must not be negative");
+      return Result::ExitFailure;
+    }
+    if (adaptive_concurrency && max_concurrency == 0) {
+      PrintHelp(std::cerr, "--adaptive-concurrency requires --max-concurrency");
+      return Result::ExitFailure;
+    }
+    if (min_concurrency <= 0 || (max_concurrency > 0 && min_concurrency > max_concurrency)) {
+      PrintHelp(std::cerr, "--min-concurrency must be between 1 and --max-concurrency");
+      return Result::ExitFailure;
+    }
+    if (max_queue_time_ms < 0 || retry_after_seconds < 0) {
+      PrintHelp(std::cerr, "--max-queue-time-ms and --retry-after must not be negative");
+      return Result::ExitFailure;
+    }
+    if (deadline_check_interval_ms < 0) {
+      PrintHelp(std::cerr, "--deadline-check-interval-ms must not be negative");
+      return Result::ExitFailure;
+    }
+    if (http_max_in_flight <= 0) {
+      PrintHelp(std::cerr, "--http-max-in-flight must be greater than 0");
+      return Result::ExitFailure;
+    }
+    if (max_request_size_mb <= 0 || max_request_size_mb >= 4096) {
+      PrintHelp(std::cerr, "--max-request-size-mb must be between 1 and 4095");
+      return Result::ExitFailure;
+    }
+    if (max_connections < 0 || http_idle_timeout_seconds < 0 || http_header_timeout_seconds < 0 || http_body_timeout_seconds < 0 ||
+        http_write_timeout_seconds < 0) {
+      PrintHelp(std::cerr, "--max-connections and the --http-*-timeout options must not be negative");
+      return Result::ExitFailure;
+    }
     if (num_http_threads <= 0) {
       PrintHelp(std::cerr, "--num-http-threads must be greater than 0");
       return Result::ExitFailure;
@@ -194,6 +314,15 @@ class ServerConfiguration {
     std::ifstream infile(fileName.c_str());
     return infile.good();
   }
+
+  // Parses permission bits in octal notation, like chmod.
+  static bool ParseFileMode(const std::string& str, int& mode) {
+    if (str.empty() || str.size() > 4 || str.find_first_not_of("01234567") != std::string::npos) {
+      return false;
+    }
+    mode = std::stoi(str, nullptr, 8);
+    return mode <= 0777;
+  }
 };
 
 }  // namespace server
@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace onnxruntime {
+namespace server {
+
+// Ring of log records in host memory that the enclave writes into without
+// leaving the enclave, see EnclaveSetLogRing. Memory layout:
+// LogRingHeader followed by a power of two number of LogRecords.
+// Producers (enclave threads) claim records with a CAS on write_index,
+// the single consumer (host drain thread) keeps its read position private.
+// Records have a fixed size and longer messages are truncated.
+
+constexpr size_t kLogRecordSize = 512;
+
+struct LogRecord {
+  // Equals the ring position once the record is free for that position,
+  // position + 1 once it has been written.
+  std::atomic<uint64_t> sequence;
+  uint32_t level;   // spdlog::level::level_enum
+  uint32_t length;  // used bytes of text
+  char text[kLogRecordSize - 16];
+};
+
+struct LogRingHeader {
+  std::atomic<uint64_t> write_index;
+  std::atomic<uint64_t> dropped;  // records lost because the ring was full
+  uint64_t reserved[6];
+};
+
+static_assert(sizeof(LogRecord) == kLogRecordSize, "unexpected LogRecord padding");
+static_assert(sizeof(LogRingHeader) % alignof(LogRecord) == 0, "records must be aligned");
+
+inline size_t LogRingSize(uint64_t capacity) {
+  return sizeof(LogRingHeader) + capacity * sizeof(LogRecord);
+}
+
+// Derives the record capacity from a ring size, false if the size is invalid.
+inline bool LogRingCapacity(size_t ring_size, uint64_t& capacity) {
+  if (ring_size <= sizeof(LogRingHeader) || (ring_size - sizeof(LogRingHeader)) % sizeof(LogRecord) != 0) {
+    return false;
+  }
+  capacity = (ring_size - sizeof(LogRingHeader)) / sizeof(LogRecord);
+  return (capacity & (capacity - 1)) == 0;
+}
+
+/**
+ * Enclave side of the ring, safe to use from many threads.
+ * The memory is owned and writable by the host, so nothing read from it is
+ * trusted: indices are masked and a misbehaving host can only cause drops.
+ */
+class LogRingWriter {
+ public:
+  LogRingWriter(void* ring, uint64_t capacity)
+      : header_(static_cast<LogRingHeader*>(ring)),
+        records_(reinterpret_cast<LogRecord*>(header_ + 1)),
+        mask_(capacity - 1) {}
+
+  // Returns false if the record was dropped.
+  bool Push(uint32_t level, const char* text, size_t length) {
+    // Bounded, the host could otherwise keep us spinning.
+    constexpr int kMaxAttempts = 64;
+    uint64_t pos = header_->write_index.load(std::memory_order_relaxed);
+    for (int attempt = 0;; attempt++) {
+      if (attempt == kMaxAttempts) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      LogRecord& record = records_[pos & mask_];
+      int64_t diff = static_cast<int64_t>(record.sequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (header_->write_index.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = header_->write_index.load(std::memory_order_relaxed);
+      }
+    }
+    LogRecord& record = records_[pos & mask_];
+    size_t n = std::min(length, sizeof(record.text));
+    std::memcpy(record.text, text, n);
+    record.level = level;
+    record.length = static_cast<uint32_t>(n);
+    record.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  LogRingHeader* header_;
+  LogRecord* records_;
+  uint64_t mask_;
+};
+
+/**
+ * Host side of the ring, one consumer thread only.
+ */
+class LogRingReader {
+ public:
+  // Initializes the ring in the given memory of LogRingSize(capacity) bytes.
+  LogRingReader(void* ring, uint64_t capacity)
+      : header_(new (ring) LogRingHeader()),
+        records_(reinterpret_cast<LogRecord*>(header_ + 1)),
+        capacity_(capacity) {
+    header_->write_index.store(0, std::memory_order_relaxed);
+    header_->dropped.store(0, std::memory_order_relaxed);
+    for (uint64_t i = 0; i < capacity_; i++) {
+      LogRecord* record = new (&records_[i]) LogRecord();
+      record->sequence.store(i, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  // Returns false if no record is ready.
+  bool Pop(uint32_t& level, std::string& text) {
+    LogRecord& record = records_[read_index_ & (capacity_ - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != read_index_ + 1) {
+      return false;
+    }
+    level = record.level;
+    text.assign(record.text, std::min<size_t>(record.length, sizeof(record.text)));
+    record.sequence.store(read_index_ + capacity_, std::memory_order_release);
+    read_index_++;
+    return true;
+  }
+
+  uint64_t Dropped() const {
+    return header_->dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  LogRingHeader* header_;
+  LogRecord* records_;
+  uint64_t capacity_;
+  uint64_t read_index_ = 0;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
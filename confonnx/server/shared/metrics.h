@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace onnxruntime {
+namespace server {
+
+// Upper bucket bounds of all latency histograms in microseconds, 10 us to 10 s.
+// Fixed so that enclave and host agree on the layout of HistogramSnapshot.
+constexpr size_t kLatencyBucketCount = 19;
+constexpr uint64_t kLatencyBucketBoundsUs[kLatencyBucketCount] = {
+    10, 25, 50, 100, 250, 500,
+    1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+// Plain copy of a LatencyHistogram. Bucket counts are not cumulative,
+// the last bucket counts values above the largest bound.
+struct HistogramSnapshot {
+  uint64_t buckets[kLatencyBucketCount + 1];
+  uint64_t sum_ns;
+  uint64_t count;
+};
+
+/**
+ * Latency histogram with fixed Prometheus-style buckets that many threads
+ * can record into concurrently without locking.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(std::chrono::nanoseconds duration) {
+    uint64_t ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    uint64_t us = ns / 1000;
+    size_t i = 0;
+    while (i < kLatencyBucketCount && us > kLatencyBucketBoundsUs[i]) {
+      i++;
+    }
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Not atomic as a whole, concurrent recordings may be partially included.
+  void Snapshot(HistogramSnapshot& snapshot) const {
+    for (size_t i = 0; i <= kLatencyBucketCount; i++) {
+      snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+    snapshot.count = count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[kLatencyBucketCount + 1];
+  std::atomic<uint64_t> sum_ns_{0};
+  std::atomic<uint64_t> count_{0};
+};
+
+// Stages of a score request inside the enclave.
+enum class EnclaveStage : uint32_t {
+  Decrypt,         // confmsg message parsing and decryption
+  Parse,           // PredictRequest or binary request parsing
+  ConvertInputs,   // request tensors to ONNX Runtime values
+  Run,             // Session::Run
+  ConvertOutputs,  // ONNX Runtime values to response tensors, incl. post-processing
+  Serialize,       // PredictResponse serialization
+  Encrypt,         // confmsg encryption
+  Count
+};
+
+constexpr size_t kEnclaveStageCount = static_cast<size_t>(EnclaveStage::Count);
+
+inline const char* EnclaveStageName(EnclaveStage stage) {
+  static const char* const names[kEnclaveStageCount] = {
+      "decrypt", "parse", "convert_inputs", "run", "convert_outputs", "serialize", "encrypt"};
+  return names[static_cast<size_t>(stage)];
+}
+
+// Aggregated enclave statistics, copied to the host by EnclaveGetStats.
+struct EnclaveStats {
+  HistogramSnapshot stages[kEnclaveStageCount];
+  uint64_t key_refresh_refreshed;
+  uint64_t key_refresh_unchanged;
+  uint64_t key_refresh_failed;
+  uint64_t runs_terminated;
+};
+
+// Passed as plain bytes across the enclave boundary.
+static_assert(std::is_trivially_copyable<EnclaveStats>::value, "EnclaveStats must be trivially copyable");
+
+}  // namespace server
+}  // namespace onnxruntime
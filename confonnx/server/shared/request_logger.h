@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+namespace onnxruntime {
+namespace server {
+
+/**
+ * Logs on behalf of a single request through the shared application logger,
+ * with the request id in front of each message. Creating one is free, and
+ * messages below the configured level are neither formatted nor allocated.
+ * The logger and the request id must outlive the RequestLogger.
+ */
+class RequestLogger {
+ public:
+  RequestLogger(spdlog::logger* logger, const char* request_id) : logger_(logger), request_id_(request_id) {}
+
+  bool should_log(spdlog::level::level_enum level) const {
+    return logger_->should_log(level);
+  }
+
+  template <typename Arg1, typename... Args>
+  void log(spdlog::level::level_enum level, const char* fmt, const Arg1& arg1, const Args&... args) const {
+    if (should_log(level)) {
+      logger_->log(level, "[{}] {}", request_id_, fmt::format(fmt, arg1, args...));
+    }
+  }
+
+  template <typename T>
+  void log(spdlog::level::level_enum level, const T& msg) const {
+    if (should_log(level)) {
+      logger_->log(level, "[{}] {}", request_id_, msg);
+    }
+  }
+
+  template <typename... Args>
+  void debug(const Args&... args) const { log(spdlog::level::debug, args...); }
+
+  template <typename... Args>
+  void info(const Args&... args) const { log(spdlog::level::info, args...); }
+
+  template <typename... Args>
+  void warn(const Args&... args) const { log(spdlog::level::warn, args...); }
+
+  template <typename... Args>
+  void error(const Args&... args) const { log(spdlog::level::err, args...); }
+
+  template <typename... Args>
+  void critical(const Args&... args) const { log(spdlog::level::critical, args...); }
+
+ private:
+  spdlog::logger* logger_;
+  const char* request_id_;
+};
+
+}  // namespace server
+}  // namespace onnxruntime
@@ -7,5 +7,9 @@
 
 enum class RequestType : uint8_t {
   ProvisionModelKey = 0,
-  Score = 1
+  Score = 1,
+  UpdateModel = 2,
+  // Like Score, but using the compact binary tensor format
+  // (server/enclave/core/binary_format.h) instead of protobuf.
+  ScoreBinary = 3
 };
@@ -20,7 +20,9 @@ enum EnclaveCallStatus {
   ATTESTATION_ERROR = 10,
   KEY_REFRESH_ERROR = 11,
   UNKNOWN_REQUEST_TYPE_ERROR = 12,
-  MODEL_ALREADY_INITIALIZED_ERROR = 13
+  MODEL_ALREADY_INITIALIZED_ERROR = 13,
+  MODEL_UPDATE_ERROR = 14,
+  DEADLINE_EXCEEDED_ERROR = 15
 };
 
 }  // namespace server
@@ -0,0 +1,276 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "server/enclave/core/binary_format.h"
+#include "server/enclave/core/onnx_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+struct TestTensor {
+  std::string name;
+  std::vector<int64_t> dims;
+  std::vector<float> data;
+};
+
+// A well-formed binary message with the layout of WriteBinaryMessage,
+// which tests then break by changing the header or descriptors in place.
+class TestMessage {
+ public:
+  explicit TestMessage(const std::vector<TestTensor>& tensors) {
+    size_t offset = sizeof(BinaryFormatHeader) + tensors.size() * sizeof(BinaryFormatTensorDescriptor);
+    std::vector<BinaryFormatTensorDescriptor> descriptors(tensors.size());
+    for (size_t i = 0; i < tensors.size(); i++) {
+      BinaryFormatTensorDescriptor& desc = descriptors[i];
+      std::memset(&desc, 0, sizeof(desc));
+      desc.name_offset = static_cast<uint32_t>(offset);
+      desc.name_length = static_cast<uint32_t>(tensors[i].name.size());
+      desc.data_type = onnx::TensorProto_DataType_FLOAT;
+      desc.rank = static_cast<uint32_t>(tensors[i].dims.size());
+      std::copy(tensors[i].dims.begin(), tensors[i].dims.end(), desc.dims);
+      offset = AlignUp(offset + desc.name_length);
+      desc.data_offset = offset;
+      desc.data_length = tensors[i].data.size() * sizeof(float);
+      offset += desc.data_length;
+    }
+
+    // uint64_t elements for the alignment ParseBinaryMessage requires.
+    storage_.assign((offset + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    size_ = offset;
+    Header().magic = kBinaryFormatMagic;
+    Header().version = kBinaryFormatVersion;
+    Header().tensor_count = static_cast<uint16_t>(tensors.size());
+    for (size_t i = 0; i < tensors.size(); i++) {
+      Descriptor(i) = descriptors[i];
+      std::memcpy(Data() + descriptors[i].name_offset, tensors[i].name.data(), tensors[i].name.size());
+      if (!tensors[i].data.empty()) {
+        std::memcpy(Data() + descriptors[i].data_offset, tensors[i].data.data(), descriptors[i].data_length);
+      }
+    }
+  }
+
+  BinaryFormatHeader& Header() {
+    return *reinterpret_cast<BinaryFormatHeader*>(Data());
+  }
+
+  BinaryFormatTensorDescriptor& Descriptor(size_t i) {
+    return reinterpret_cast<BinaryFormatTensorDescriptor*>(Data() + sizeof(BinaryFormatHeader))[i];
+  }
+
+  uint8_t* Data() { return reinterpret_cast<uint8_t*>(storage_.data()); }
+  size_t Size() const { return size_; }
+
+  // Pretends that only the first size bytes were received.
+  void Truncate(size_t size) { size_ = size; }
+
+  // Returns the error message of ParseBinaryMessage, empty on success.
+  std::string ParseError(std::vector<BinaryTensorView>& tensors) {
+    auto status = ParseBinaryMessage(Data(), size_, tensors);
+    return status.ok() ? "" : status.error_message();
+  }
+
+  std::string ParseError() {
+    std::vector<BinaryTensorView> tensors;
+    return ParseError(tensors);
+  }
+
+ private:
+  static size_t AlignUp(size_t offset) {
+    return (offset + kBinaryFormatAlignment - 1) / kBinaryFormatAlignment * kBinaryFormatAlignment;
+  }
+
+  std::vector<uint64_t> storage_;
+  size_t size_;
+};
+
+static const std::vector<TestTensor> kTwoTensors = {
+    {"x", {2, 3}, {1, 2, 3, 4, 5, 6}},
+    {"scale", {1}, {0.5f}},
+};
+
+TEST(BinaryFormat, ParsesTensors) {
+  TestMessage message(kTwoTensors);
+  std::vector<BinaryTensorView> tensors;
+  ASSERT_EQ(message.ParseError(tensors), "");
+  ASSERT_EQ(tensors.size(), 2u);
+
+  EXPECT_EQ(std::string(tensors[0].name, tensors[0].name_length), "x");
+  EXPECT_EQ(tensors[0].element_type, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+  ASSERT_EQ(tensors[0].rank, 2u);
+  EXPECT_EQ(tensors[0].dims[0], 2);
+  EXPECT_EQ(tensors[0].dims[1], 3);
+  ASSERT_EQ(tensors[0].data_length, 6 * sizeof(float));
+  EXPECT_EQ(static_cast<const float*>(tensors[0].data)[5], 6.0f);
+
+  EXPECT_EQ(std::string(tensors[1].name, tensors[1].name_length), "scale");
+  EXPECT_EQ(static_cast<const float*>(tensors[1].data)[0], 0.5f);
+}
+
+TEST(BinaryFormat, EmptyTensors) {
+  // Empty tensors may share their offset, they have no bytes to overlap.
+  TestMessage message({{"a", {0}, {}}, {"b", {2, 0}, {}}});
+  message.Descriptor(1).data_offset = message.Descriptor(0).data_offset;
+  EXPECT_EQ(message.ParseError(), "");
+}
+
+TEST(BinaryFormat, TruncatedHeader) {
+  TestMessage message(kTwoTensors);
+  message.Truncate(sizeof(BinaryFormatHeader) - 1);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: truncated header");
+  message.Truncate(0);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: truncated header");
+}
+
+TEST(BinaryFormat, BadMagicAndVersion) {
+  TestMessage message(kTwoTensors);
+  message.Header().magic++;
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: bad magic");
+  message.Header().magic--;
+  message.Header().version++;
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: unsupported version 2");
+}
+
+TEST(BinaryFormat, TruncatedDescriptors) {
+  TestMessage message(kTwoTensors);
+  message.Truncate(sizeof(BinaryFormatHeader) + 2 * sizeof(BinaryFormatTensorDescriptor) - 1);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: truncated tensor descriptors");
+
+  // More tensors than the message has descriptors for.
+  TestMessage too_many(kTwoTensors);
+  too_many.Header().tensor_count = std::numeric_limits<uint16_t>::max();
+  EXPECT_EQ(too_many.ParseError(), "Invalid binary message: truncated tensor descriptors");
+}
+
+TEST(BinaryFormat, NameOutOfBounds) {
+  const std::string error = "Invalid binary message: tensor name out of bounds";
+  {
+    TestMessage message(kTwoTensors);
+    message.Descriptor(1).name_length = static_cast<uint32_t>(message.Size());
+    EXPECT_EQ(message.ParseError(), error);
+  }
+  {
+    TestMessage message(kTwoTensors);
+    message.Descriptor(1).name_offset = static_cast<uint32_t>(message.Size() + 1);
+    message.Descriptor(1).name_length = 0;
+    EXPECT_EQ(message.ParseError(), error);
+  }
+  {
+    // Names in the header or descriptors would change with them.
+    TestMessage message(kTwoTensors);
+    message.Descriptor(0).name_offset = 0;
+    EXPECT_EQ(message.ParseError(), error);
+    message.Descriptor(0).name_offset = sizeof(BinaryFormatHeader);
+    EXPECT_EQ(message.ParseError(), error);
+  }
+}
+
+TEST(BinaryFormat, DataOutOfBounds) {
+  const std::string error = "Invalid binary message: tensor data out of bounds";
+  {
+    TestMessage message(kTwoTensors);
+    message.Truncate(message.Size() - 1);
+    EXPECT_EQ(message.ParseError(), error);
+  }
+  {
+    TestMessage message(kTwoTensors);
+    message.Descriptor(0).data_offset = std::numeric_limits<uint64_t>::max() / kBinaryFormatAlignment * kBinaryFormatAlignment;
+    EXPECT_EQ(message.ParseError(), error);
+  }
+  {
+    // Offset 0 is aligned, but would bind the header and descriptors as tensor data.
+    TestMessage message({{"x", {4}, {1, 2, 3, 4}}});
+    message.Descriptor(0).data_offset = 0;
+    EXPECT_EQ(message.ParseError(), error);
+    message.Descriptor(0).data_offset = kBinaryFormatAlignment;
+    EXPECT_EQ(message.ParseError(), error);
+  }
+}
+
+TEST(BinaryFormat, InvalidDimensions) {
+  {
+    TestMessage message(kTwoTensors);
+    message.Descriptor(0).dims[0] = -2;
+    EXPECT_EQ(message.ParseError(), "Invalid binary message: negative dimension");
+  }
+  {
+    // The byte count would overflow 64 bits.
+    TestMessage message({{"x", {1}, {1}}});
+    BinaryFormatTensorDescriptor& desc = message.Descriptor(0);
+    desc.rank = 3;
+    desc.dims[0] = int64_t(1) << 31;
+    desc.dims[1] = int64_t(1) << 31;
+    desc.dims[2] = int64_t(1) << 2;
+    EXPECT_EQ(message.ParseError(), "Invalid binary message: tensor too large");
+  }
+  {
+    TestMessage message(kTwoTensors);
+    message.Descriptor(0).rank = kBinaryFormatMaxRank + 1;
+    EXPECT_EQ(message.ParseError(), "Invalid binary message: rank exceeds 8");
+  }
+}
+
+TEST(BinaryFormat, UnsupportedDataType) {
+  TestMessage message(kTwoTensors);
+  message.Descriptor(0).data_type = onnx::TensorProto_DataType_STRING;
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: unsupported data type 8");
+}
+
+TEST(BinaryFormat, MisalignedData) {
+  TestMessage message(kTwoTensors);
+  message.Descriptor(1).data_offset += sizeof(float);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: misaligned tensor data");
+}
+
+TEST(BinaryFormat, LengthMismatch) {
+  TestMessage message(kTwoTensors);
+  message.Descriptor(0).data_length -= sizeof(float);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: tensor data length does not match dimensions");
+  message.Descriptor(0).data_length += 2 * sizeof(float);
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: tensor data length does not match dimensions");
+}
+
+TEST(BinaryFormat, OverlappingData) {
+  TestMessage message({{"a", {32}, std::vector<float>(32)}, {"b", {16}, std::vector<float>(16)}});
+  uint64_t a_offset = message.Descriptor(0).data_offset;
+  message.Descriptor(1).data_offset = a_offset;
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: overlapping tensor data");
+  // b starts inside a.
+  message.Descriptor(1).data_offset = a_offset + kBinaryFormatAlignment;
+  EXPECT_EQ(message.ParseError(), "Invalid binary message: overlapping tensor data");
+}
+
+TEST(BinaryFormat, WriteThenParse) {
+  std::vector<float> x = {1, 2, 3, 4, 5, 6};
+  std::vector<int64_t> shape = {3, 2};
+  auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  std::vector<Ort::Value> values;
+  values.push_back(Ort::Value::CreateTensor<float>(memory_info, x.data(), x.size(), shape.data(), shape.size()));
+  std::vector<const char*> names = {"output"};
+
+  std::vector<uint8_t> written;
+  ASSERT_TRUE(WriteBinaryMessage(names, values, 7, written).ok());
+  // The vector's allocation is aligned enough for ParseBinaryMessage.
+  std::vector<BinaryTensorView> tensors;
+  auto status = ParseBinaryMessage(written.data(), written.size(), tensors);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  EXPECT_EQ(reinterpret_cast<const BinaryFormatHeader*>(written.data())->model_version, 7u);
+  ASSERT_EQ(tensors.size(), 1u);
+  EXPECT_EQ(std::string(tensors[0].name, tensors[0].name_length), "output");
+  ASSERT_EQ(tensors[0].rank, 2u);
+  EXPECT_EQ(tensors[0].dims[0], 3);
+  EXPECT_EQ(tensors[0].dims[1], 2);
+  ASSERT_EQ(tensors[0].data_length, x.size() * sizeof(float));
+  EXPECT_EQ(std::memcmp(tensors[0].data, x.data(), tensors[0].data_length), 0);
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+
+#include "gtest/gtest.h"
+
+#include "server/host/core/connection_limit.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+
+// Accepts connections on a loopback port and serves them from a few I/O threads.
+// on_connection typically creates and runs a session for the socket.
+class LoopbackServer {
+ public:
+  using ConnectionFn = std::function<void(tcp::socket&&, ConnectionLimit::Slot&&)>;
+
+  explicit LoopbackServer(ConnectionFn on_connection)
+      : on_connection_(std::move(on_connection)),
+        connections_(std::make_shared<ConnectionLimit>(0)),
+        acceptor_(ioc_, tcp::endpoint(net::ip::address_v4::loopback(), 0)) {
+    Accept();
+    for (int i = 0; i < 2; i++) {
+      threads_.emplace_back([this] { ioc_.run(); });
+    }
+  }
+
+  ~LoopbackServer() {
+    ioc_.stop();
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  unsigned short Port() const { return acceptor_.local_endpoint().port(); }
+
+  // Waits until the server accepted a connection, then closed all connections and
+  // destroyed their sessions.
+  testing::AssertionResult WaitUntilClosed(std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (accepted_ == 0 || connections_->GetOpenConnections() > 0) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return testing::AssertionFailure() << connections_->GetOpenConnections() << " connections still open after "
+                                           << timeout.count() << " ms";
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return testing::AssertionSuccess();
+  }
+
+ private:
+  void Accept() {
+    acceptor_.async_accept([this](boost::system::error_code ec, tcp::socket socket) {
+      if (ec) {
+        return;
+      }
+      ConnectionLimit::Slot slot;
+      connections_->TryAcquire(slot);
+      on_connection_(std::move(socket), std::move(slot));
+      accepted_++;
+      Accept();
+    });
+  }
+
+  ConnectionFn on_connection_;
+  std::shared_ptr<ConnectionLimit> connections_;
+  std::atomic<size_t> accepted_{0};
+  net::io_context ioc_;
+  tcp::acceptor acceptor_;
+  std::vector<std::thread> threads_;
+};
+
+// Blocking client connection to a LoopbackServer. Reads give up after the receive
+// timeout (SO_RCVTIMEO), so that a server which stops responding or never closes
+// the connection fails the test instead of hanging it. Asio's blocking reads wait
+// for readiness without a timeout, so reads use recv() directly.
+class LoopbackClient {
+ public:
+  explicit LoopbackClient(unsigned short port, std::chrono::milliseconds receive_timeout = std::chrono::seconds(10))
+      : socket_(ioc_), receive_timeout_(receive_timeout) {
+    socket_.connect(tcp::endpoint(net::ip::address_v4::loopback(), port));
+    timeval tv;
+    tv.tv_sec = static_cast<time_t>(receive_timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>(receive_timeout.count() % 1000 * 1000);
+    setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+
+  void Write(const std::string& data) {
+    net::write(socket_, net::buffer(data));
+  }
+
+  void ShutdownSend() {
+    socket_.shutdown(tcp::socket::shutdown_send);
+  }
+
+  // Reads exactly size bytes, returns false if the connection was closed, failed or timed out.
+  bool Read(void* data, size_t size) {
+    auto* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+      ssize_t n = Receive(bytes, size);
+      if (n <= 0) {
+        return false;
+      }
+      bytes += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  // Reads until the server closed the connection, received is the number of bytes read until then.
+  testing::AssertionResult ReadUntilClosed(/* out */ size_t& received) {
+    std::vector<uint8_t> buffer(1 << 16);
+    received = 0;
+    for (;;) {
+      ssize_t n = Receive(buffer.data(), buffer.size());
+      if (n > 0) {
+        received += static_cast<size_t>(n);
+      } else if (n == 0 || errno == ECONNRESET) {
+        // Closing with unread input makes the server send a reset instead of a FIN.
+        return testing::AssertionSuccess();
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return testing::AssertionFailure() << "connection not closed within " << receive_timeout_.count() << " ms";
+      } else {
+        return testing::AssertionFailure() << "recv: " << std::strerror(errno);
+      }
+    }
+  }
+
+  testing::AssertionResult ReadUntilClosed() {
+    size_t received;
+    return ReadUntilClosed(received);
+  }
+
+ private:
+  ssize_t Receive(void* data, size_t size) {
+    ssize_t n;
+    do {
+      n = recv(socket_.native_handle(), data, size, 0);
+    } while (n < 0 && errno == EINTR);
+    return n;
+  }
+
+  net::io_context ioc_;
+  tcp::socket socket_;
+  std::chrono::milliseconds receive_timeout_;
+};
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Tests of the enclave code loaded in-process (BUILD_IN_PROCESS_ENCLAVE), which
+// need no SGX hardware. The path of the in-process enclave library is taken from
+// CONFONNX_IN_PROCESS_ENCLAVE_PATH, which CTest sets.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_sinks.h>
+
+#include <confmsg/client/api.h>
+#include <confmsg/shared/crypto.h>
+
+#include "server/host/enclave.h"
+#include "server/host/enclave_error.h"
+#include "server/host/environment.h"
+#include "server/shared/constants.h"
+#include "server/shared/key_vault_config.h"
+#include "server/shared/request_type.h"
+#include "server/shared/status.h"
+#include "test/helpers/onnx_protobuf.h"
+#include "test/helpers/predict_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+static void SetFloatTensor(ONNX_NAMESPACE::ValueInfoProto& value_info, const std::string& name, int64_t size) {
+  value_info.set_name(name);
+  auto* tensor_type = value_info.mutable_type()->mutable_tensor_type();
+  tensor_type->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  tensor_type->mutable_shape()->add_dim()->set_dim_value(size);
+  tensor_type->mutable_shape()->add_dim()->set_dim_value(size);
+}
+
+// Square size x size matrix of floats, the identity matrix or all ones.
+static void SetMatrix(ONNX_NAMESPACE::TensorProto& tensor, int64_t size, bool identity) {
+  tensor.set_data_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  tensor.add_dims(size);
+  tensor.add_dims(size);
+  std::vector<float> values(size * size, identity ? 0.0f : 1.0f);
+  for (int64_t i = 0; identity && i < size; i++) {
+    values[i * size + i] = 1.0f;
+  }
+  tensor.set_raw_data(values.data(), values.size() * sizeof(float));
+}
+
+// Model with input "x" and output "y", computing y = x * w * ... * w as a chain
+// of MatMul nodes with the identity matrix w. ONNX Runtime checks whether a run was
+// terminated between nodes, so a long chain of them can be stopped at any time.
+static std::string MatMulChainModel(int64_t size, int nodes) {
+  ONNX_NAMESPACE::ModelProto model;
+  model.set_ir_version(ONNX_NAMESPACE::IR_VERSION);
+  model.add_opset_import()->set_version(10);
+  auto* graph = model.mutable_graph();
+  graph->set_name("matmul_chain");
+  SetFloatTensor(*graph->add_input(), "x", size);
+  SetFloatTensor(*graph->add_output(), "y", size);
+  auto* w = graph->add_initializer();
+  w->set_name("w");
+  SetMatrix(*w, size, true);
+  std::string previous = "x";
+  for (int i = 0; i < nodes; i++) {
+    auto* node = graph->add_node();
+    node->set_op_type("MatMul");
+    node->add_input(previous);
+    node->add_input("w");
+    previous = i == nodes - 1 ? "y" : "y" + std::to_string(i);
+    node->add_output(previous);
+  }
+  return model.SerializeAsString();
+}
+
+TEST(InProcessEnclave, TerminatesRunPastDeadline) {
+  // 5000 multiplications of 512x512 matrices are over a TFLOP, which takes
+  // seconds even with all cores of a large machine.
+  constexpr int64_t kSize = 512;
+  constexpr int kNodes = 5000;
+  constexpr auto kTimeout = std::chrono::milliseconds(100);
+
+  const char* enclave_path = std::getenv("CONFONNX_IN_PROCESS_ENCLAVE_PATH");
+  ASSERT_NE(enclave_path, nullptr) << "CONFONNX_IN_PROCESS_ENCLAVE_PATH not set";
+
+  const auto env = std::make_shared<server::ServerEnvironment>(spdlog::level::level_enum::info,
+                                                               spdlog::sinks_init_list{std::make_shared<spdlog::sinks::stdout_sink_mt>()},
+                                                               "");
+
+  std::string model = MatMulChainModel(kSize, kNodes);
+  std::vector<uint8_t> service_id;
+  confmsg::internal::SHA256(confmsg::CBuffer(reinterpret_cast<const uint8_t*>(model.data()), model.size()), service_id);
+  std::string model_path = std::tmpnam(nullptr);
+  std::ofstream(model_path, std::ios::binary) << model;
+
+  server::Enclave enclave(enclave_path, false, false, true, env, KeyVaultConfig(), KeyVaultConfig());
+  enclave.Initialize(model_path, env);
+  std::remove(model_path.c_str());
+  enclave.StartDeadlineWatchdog(std::chrono::milliseconds(5), env);
+
+  // No expected enclave identity, there are no quotes in-process.
+  confmsg::Client client(confmsg::RandomKeyProvider::Create(KEY_SIZE), "", {}, service_id, true);
+  std::vector<uint8_t> request_buf(kSize * kSize * sizeof(float) + 1024);
+  std::vector<uint8_t> response_buf(MAX_OUTPUT_SIZE);
+  size_t request_size;
+  size_t response_size;
+  client.MakeKeyRequest(request_buf.data(), &request_size, request_buf.size());
+  enclave.HandleRequest("key", RequestType::Score, request_buf.data(), request_size,
+                        response_buf.data(), &response_size, env);
+  ASSERT_TRUE(client.HandleMessage(response_buf.data(), response_size).IsKeyResponse());
+
+  PredictRequest request;
+  SetMatrix((*request.mutable_inputs())["x"], kSize, false);
+  std::vector<uint8_t> plaintext(request.ByteSizeLong());
+  ASSERT_TRUE(request.SerializeToArray(plaintext.data(), static_cast<int>(plaintext.size())));
+  client.MakeRequest(plaintext, request_buf.data(), &request_size, request_buf.size());
+
+  // The deadline is still ahead when the run starts, so only the watchdog terminating
+  // the run (RunWatchdog::TerminateExpired) can make it fail with DEADLINE_EXCEEDED_ERROR.
+  auto start = std::chrono::steady_clock::now();
+  try {
+    enclave.HandleRequest("score", RequestType::Score, request_buf.data(), request_size,
+                          response_buf.data(), &response_size, env, kTimeout);
+    FAIL() << "Run finished despite the deadline";
+  } catch (const EnclaveCallError& e) {
+    EXPECT_EQ(e.status, DEADLINE_EXCEEDED_ERROR);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, kTimeout);
+  EXPECT_LT(elapsed, std::chrono::seconds(1));
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "server/shared/log_ring.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+// Ring memory with the alignment of LogRecord.
+class LogRingMemory {
+ public:
+  explicit LogRingMemory(uint64_t capacity)
+      : capacity_(capacity), memory_(LogRingSize(capacity) / sizeof(uint64_t)) {}
+
+  void* Get() { return memory_.data(); }
+  uint64_t Capacity() const { return capacity_; }
+
+ private:
+  uint64_t capacity_;
+  std::vector<uint64_t> memory_;
+};
+
+static bool Push(LogRingWriter& writer, uint32_t level, const std::string& text) {
+  return writer.Push(level, text.data(), text.size());
+}
+
+TEST(LogRing, Capacity) {
+  uint64_t capacity;
+  EXPECT_TRUE(LogRingCapacity(LogRingSize(8), capacity));
+  EXPECT_EQ(capacity, 8u);
+  EXPECT_FALSE(LogRingCapacity(LogRingSize(6), capacity));
+  EXPECT_FALSE(LogRingCapacity(LogRingSize(8) + 1, capacity));
+  EXPECT_FALSE(LogRingCapacity(sizeof(LogRingHeader), capacity));
+}
+
+TEST(LogRing, Wraparound) {
+  LogRingMemory memory(4);
+  LogRingReader reader(memory.Get(), memory.Capacity());
+  LogRingWriter writer(memory.Get(), memory.Capacity());
+
+  // Several times around the ring, with the reader one record behind.
+  uint32_t level;
+  std::string text;
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(Push(writer, i % 6, "message " + std::to_string(i)));
+    if (i > 0) {
+      ASSERT_TRUE(reader.Pop(level, text));
+      EXPECT_EQ(level, static_cast<uint32_t>((i - 1) % 6));
+      EXPECT_EQ(text, "message " + std::to_string(i - 1));
+    }
+  }
+  ASSERT_TRUE(reader.Pop(level, text));
+  EXPECT_EQ(text, "message 19");
+  EXPECT_FALSE(reader.Pop(level, text));
+  EXPECT_EQ(reader.Dropped(), 0u);
+}
+
+TEST(LogRing, FullRingDrops) {
+  LogRingMemory memory(4);
+  LogRingReader reader(memory.Get(), memory.Capacity());
+  LogRingWriter writer(memory.Get(), memory.Capacity());
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(Push(writer, 0, std::to_string(i)));
+  }
+  EXPECT_FALSE(Push(writer, 0, "4"));
+  EXPECT_FALSE(Push(writer, 0, "5"));
+  EXPECT_EQ(reader.Dropped(), 2u);
+
+  // Dropped records don't take a position, the ring continues after the last written one.
+  uint32_t level;
+  std::string text;
+  ASSERT_TRUE(reader.Pop(level, text));
+  EXPECT_EQ(text, "0");
+  ASSERT_TRUE(Push(writer, 0, "6"));
+  for (const char* expected : {"1", "2", "3", "6"}) {
+    ASSERT_TRUE(reader.Pop(level, text));
+    EXPECT_EQ(text, expected);
+  }
+  EXPECT_FALSE(reader.Pop(level, text));
+  EXPECT_EQ(reader.Dropped(), 2u);
+}
+
+TEST(LogRing, OversizedRecordIsTruncated) {
+  LogRingMemory memory(2);
+  LogRingReader reader(memory.Get(), memory.Capacity());
+  LogRingWriter writer(memory.Get(), memory.Capacity());
+
+  const size_t max_length = sizeof(LogRecord::text);
+  std::string exact(max_length, 'a');
+  std::string oversized = std::string(max_length, 'b') + "tail";
+  ASSERT_TRUE(Push(writer, 1, exact));
+  ASSERT_TRUE(Push(writer, 2, oversized));
+
+  uint32_t level;
+  std::string text;
+  ASSERT_TRUE(reader.Pop(level, text));
+  EXPECT_EQ(text, exact);
+  ASSERT_TRUE(reader.Pop(level, text));
+  EXPECT_EQ(level, 2u);
+  EXPECT_EQ(text, oversized.substr(0, max_length));
+  EXPECT_EQ(reader.Dropped(), 0u);
+}
+
+TEST(LogRing, ConcurrentWriters) {
+  constexpr int kWriters = 4;
+  constexpr int kRecordsPerWriter = 5000;
+  LogRingMemory memory(64);
+  LogRingReader reader(memory.Get(), memory.Capacity());
+  LogRingWriter writer(memory.Get(), memory.Capacity());
+
+  std::vector<int> written(kWriters, 0);
+  std::vector<std::thread> threads;
+  for (int w = 0; w < kWriters; w++) {
+    threads.emplace_back([&writer, &written, w] {
+      for (int i = 0; i < kRecordsPerWriter; i++) {
+        if (Push(writer, w, std::to_string(i))) {
+          written[w]++;
+        }
+      }
+    });
+  }
+
+  // Each writer claims positions in order, so its records arrive in order
+  // with gaps only where records were dropped.
+  std::vector<int> last(kWriters, -1);
+  std::vector<int> read(kWriters, 0);
+  uint32_t level;
+  std::string text;
+  auto drain = [&] {
+    while (reader.Pop(level, text)) {
+      ASSERT_LT(level, static_cast<uint32_t>(kWriters));
+      int i = std::stoi(text);
+      EXPECT_GT(i, last[level]);
+      last[level] = i;
+      read[level]++;
+    }
+  };
+  for (int polls = 0; polls < 1000; polls++) {
+    drain();
+    std::this_thread::yield();
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  drain();
+
+  uint64_t total_read = 0;
+  for (int w = 0; w < kWriters; w++) {
+    EXPECT_EQ(read[w], written[w]);
+    total_read += read[w];
+  }
+  EXPECT_EQ(total_read + reader.Dropped(), static_cast<uint64_t>(kWriters * kRecordsPerWriter));
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
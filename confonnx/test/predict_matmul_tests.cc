@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <confmsg/client/api.h>
+#include <confmsg/shared/crypto.h>
+#include <confmsg/test/openenclave_debug_key.h>
+
+#include "server/host/core/context.h"
+#include "server/host/environment.h"
+#include "server/host/enclave.h"
+#include "server/enclave/key_vault_provider.h"
+#include "server/host/request_handler.h"
+#include "server/shared/util.h"
+#include "server/shared/request_type.h"
+#include "test/test_config.h"
+#include "test/helpers/helpers.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+// Runs a request through the full inference path (HTTP handler, ECALL,
+// decryption, conversion, run, encryption) with a model that does almost no work.
+// bench/e2e_bench.cc --handler measures the same path.
+TEST(PredictRequest, MatMul1) {
+  std::string model_path = TEST_DATA_PATH + "/matmul_1.onnx";
+
+  PredictRequest request;
+  onnx::TensorProto& x = (*request.mutable_inputs())["X"];
+  x.set_data_type(onnx::TensorProto_DataType_FLOAT);
+  x.add_dims(3);
+  x.add_dims(2);
+  const float x_data[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+  x.set_raw_data(x_data, sizeof(x_data));
+
+  size_t proto_size = request.ByteSizeLong();
+  std::vector<uint8_t> predict_request_buf(proto_size);
+  if (!request.SerializeToArray(predict_request_buf.data(), proto_size)) {
+    throw std::runtime_error("protobuf serialization error");
+  }
+
+  const auto env = std::make_shared<server::ServerEnvironment>(spdlog::level::level_enum::warn,
+                                                               spdlog::sinks_init_list{std::make_shared<spdlog::sinks::null_sink_mt>()},
+                                                               "");
+
+  bool debug = true;
+  bool simulate = false;
+  server::Enclave enclave(SERVER_ENCLAVE_PATH, debug, simulate, false, env,
+                          KeyVaultConfig(), KeyVaultConfig(), false);
+  enclave.Initialize(model_path, env);
+
+  auto key_provider = confmsg::RandomKeyProvider::Create(KEY_SIZE);
+  confmsg::Client client(std::move(key_provider),
+                         OE_DEBUG_SIGN_PUBLIC_KEY,
+                         {},
+                         HashModelFile(model_path),
+                         true);
+
+  HttpContext context;
+
+  size_t extra = 1024;
+  std::vector<uint8_t> key_request_buf(extra);
+  size_t key_request_size;
+  client.MakeKeyRequest(key_request_buf.data(), &key_request_size, key_request_buf.size());
+  context.request.body().assign(key_request_buf.data(), key_request_size);
+  server::HandleRequest(context, RequestType::Score, enclave, env);
+  ASSERT_EQ(context.response.result_int(), 200);
+  ASSERT_TRUE(client.HandleMessage(context.response.body().data(), context.response.body().size()).IsKeyResponse());
+
+  std::vector<uint8_t> request_buf(proto_size + extra);
+  size_t request_size;
+  client.MakeRequest(predict_request_buf, request_buf.data(), &request_size, request_buf.size());
+  context.request.body().assign(request_buf.data(), request_size);
+  server::HandleRequest(context, RequestType::Score, enclave, env);
+  ASSERT_EQ(context.response.result_int(), 200);
+  confmsg::Client::Result r = client.HandleMessage(context.response.body().data(), context.response.body().size());
+  ASSERT_TRUE(r.IsResponse());
+
+  PredictResponse response;
+  ASSERT_TRUE(response.ParseFromArray(r.GetPayload().data(), r.GetPayload().size()));
+  ASSERT_TRUE(response.outputs().count("Y") == 1);
+  const onnx::TensorProto& y = response.outputs().at("Y");
+  ASSERT_EQ(y.dims_size(), 2);
+  EXPECT_EQ(y.dims(0), 3);
+  EXPECT_EQ(y.dims(1), 1);
+  std::vector<float> y_data(y.float_data().begin(), y.float_data().end());
+  if (y.has_raw_data()) {
+    y_data.resize(y.raw_data().size() / sizeof(float));
+    std::memcpy(y_data.data(), y.raw_data().data(), y_data.size() * sizeof(float));
+  }
+  EXPECT_EQ(y_data, std::vector<float>({5.0f, 11.0f, 17.0f}));
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <chrono>
 #include <iostream>
 #include <fstream>
 
@@ -74,6 +75,7 @@ TEST_P(InferenceRequest, SqueezeNet) {
 
   PredictRequest request = TensorProtoToRequest(model, {input_path});
   PredictResponse expected_response = TensorProtoToResponse(model, {expected_output_path});
+  expected_response.set_model_version(1);
 
   std::string auth_key = enable_auth ? "foo" : "";
 
@@ -115,7 +117,7 @@ TEST_P(InferenceRequest, SqueezeNet) {
 
   bool debug = true;
   bool simulate = false;
-  server::Enclave enclave(SERVER_ENCLAVE_PATH, debug, simulate, env,
+  server::Enclave enclave(SERVER_ENCLAVE_PATH, debug, simulate, false, env,
                           KeyVaultConfig(service_kvc), KeyVaultConfig(model_kvc),
                           use_model_key_provisioning);
   enclave.Initialize(model_path, env);
@@ -148,24 +150,36 @@ TEST_P(InferenceRequest, SqueezeNet) {
 
   // Check if wrong auth key results in error
   if (!auth_key.empty()) {
-    context.request.body() = "";
+    context.request.body().assign(std::string());
     context.request.set(http::field::authorization, "Bearer invalidkey");
     server::HandleRequest(context, RequestType::Score, enclave, env);
     EXPECT_EQ(context.response.result_int(), 401);
   }
 
+  // Check if an expired deadline results in error before the enclave is called
+  context.request.body().assign(std::string());
+  if (!auth_key.empty()) {
+    context.request.set(http::field::authorization, "Bearer " + auth_key);
+  }
+  // The deadline is counted from read_start, as if the request had been read 2 ms ago.
+  context.read_start = std::chrono::steady_clock::now() - std::chrono::milliseconds(2);
+  context.request.set("x-ms-deadline-ms", "1");
+  server::HandleRequest(context, RequestType::Score, enclave, env);
+  EXPECT_EQ(context.response.result_int(), 504);
+  context.request.erase("x-ms-deadline-ms");
+
   // Send key request
   std::string key_request_body((char*)key_request_buf.data(), key_request_size);
-  context.request.body() = key_request_body;
+  context.request.body().assign(key_request_body);
   if (!auth_key.empty()) {
     context.request.set(http::field::authorization, "Bearer " + auth_key);
   }
   server::HandleRequest(context, RequestType::Score, enclave, env);
   if (context.response.result_int() != 200) {
-    std::cerr << context.response.body() << std::endl;
+    std::cerr << context.response.body().str() << std::endl;
   }
   EXPECT_EQ(context.response.result_int(), 200);
-  confmsg::Client::Result key_result = client.HandleMessage((const uint8_t*)context.response.body().c_str(), context.response.body().size());
+  confmsg::Client::Result key_result = client.HandleMessage(context.response.body().data(), context.response.body().size());
   EXPECT_TRUE(key_result.IsKeyResponse());
 
   // Provision model key
@@ -178,16 +192,16 @@ TEST_P(InferenceRequest, SqueezeNet) {
 
     // Send model key provisioning request
     std::string request_body((char*)request_buf.data(), request_size);
-    context.request.body() = request_body;
+    context.request.body().assign(request_body);
     if (!auth_key.empty()) {
       context.request.set(http::field::authorization, "Bearer " + auth_key);
     }
     server::HandleRequest(context, RequestType::ProvisionModelKey, enclave, env);
     if (context.response.result_int() != 200) {
-      std::cerr << context.response.body() << std::endl;
+      std::cerr << context.response.body().str() << std::endl;
     }
     EXPECT_EQ(context.response.result_int(), 200);
-    confmsg::Client::Result r = client.HandleMessage((const uint8_t*)context.response.body().c_str(), context.response.body().size());
+    confmsg::Client::Result r = client.HandleMessage(context.response.body().data(), context.response.body().size());
     EXPECT_TRUE(r.IsResponse());
   }
 
@@ -198,16 +212,16 @@ TEST_P(InferenceRequest, SqueezeNet) {
 
   // Send inference request
   std::string request_body((char*)request_buf.data(), request_size);
-  context.request.body() = request_body;
+  context.request.body().assign(request_body);
   if (!auth_key.empty()) {
     context.request.set(http::field::authorization, "Bearer " + auth_key);
   }
   server::HandleRequest(context, RequestType::Score, enclave, env);
   if (context.response.result_int() != 200) {
-    std::cerr << context.response.body() << std::endl;
+    std::cerr << context.response.body().str() << std::endl;
   }
   EXPECT_EQ(context.response.result_int(), 200);
-  confmsg::Client::Result r = client.HandleMessage((const uint8_t*)context.response.body().c_str(), context.response.body().size());
+  confmsg::Client::Result r = client.HandleMessage(context.response.body().data(), context.response.body().size());
   EXPECT_TRUE(r.IsResponse());
   PredictResponse actual_response;
   actual_response.ParseFromArray(r.GetPayload().data(), r.GetPayload().size());
@@ -0,0 +1,268 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "server/host/core/connection_limit.h"
+#include "server/host/core/rpc_session.h"
+#include "test/helpers/loopback.h"
+
+namespace onnxruntime {
+namespace server {
+namespace test {
+
+// Serves an RPC session with the handler for each connection.
+static LoopbackServer::ConnectionFn RpcSessions(RpcHandlerFn handler, const RpcOptions& options) {
+  auto shared_handler = std::make_shared<const RpcHandlerFn>(std::move(handler));
+  return [shared_handler, options](tcp::socket&& socket, ConnectionLimit::Slot&& connection) {
+    std::make_shared<RpcSession>(shared_handler, options, std::move(socket), std::move(connection))->Run();
+  };
+}
+
+static std::string RequestFrame(uint64_t tag, uint8_t request_type, uint32_t timeout_ms, const std::string& payload) {
+  std::string frame(kRpcHeaderSize, '\0');
+  uint32_t size = static_cast<uint32_t>(payload.size());
+  for (int i = 0; i < 4; i++) {
+    frame[i] = static_cast<char>(size >> (8 * i));
+  }
+  frame[4] = static_cast<char>(request_type);
+  for (int i = 0; i < 3; i++) {
+    frame[5 + i] = static_cast<char>(timeout_ms >> (8 * i));
+  }
+  for (int i = 0; i < 8; i++) {
+    frame[8 + i] = static_cast<char>(tag >> (8 * i));
+  }
+  return frame + payload;
+}
+
+struct Response {
+  int32_t status;
+  std::string payload;
+};
+
+// Reads one response frame, returns false if the connection was closed.
+static bool ReadResponse(LoopbackClient& client, uint64_t& tag, Response& response) {
+  std::array<uint8_t, kRpcHeaderSize> header;
+  if (!client.Read(header.data(), header.size())) {
+    return false;
+  }
+  uint32_t size = 0;
+  uint32_t status = 0;
+  tag = 0;
+  for (int i = 0; i < 4; i++) {
+    size |= uint32_t(header[i]) << (8 * i);
+    status |= uint32_t(header[4 + i]) << (8 * i);
+  }
+  for (int i = 0; i < 8; i++) {
+    tag |= uint64_t(header[8 + i]) << (8 * i);
+  }
+  response.status = static_cast<int32_t>(status);
+  response.payload.resize(size);
+  return client.Read(&response.payload[0], size);
+}
+
+// Echoes the payload with the request type and timeout, as "<type> <timeout> <payload>".
+static void Echo(const RpcRequest& request, RpcResponse& response) {
+  std::string payload(reinterpret_cast<const char*>(request.payload.data()), request.payload.size());
+  response.status = request.request_type;
+  response.payload.assign(std::to_string(request.request_type) + " " + std::to_string(request.timeout_ms) + " " + payload);
+}
+
+TEST(RpcSession, PipelinedRoundTrip) {
+  LoopbackServer server(RpcSessions(Echo, RpcOptions{}));
+  LoopbackClient client(server.Port());
+
+  // All requests in one write, with a large tag and timeout to check the byte order.
+  client.Write(RequestFrame(1, 1, 0, "first") +
+               RequestFrame(0x0102030405060708, 3, 0xabcdef, "") +
+               RequestFrame(3, 0, 1000, std::string(100000, 'x')));
+
+  std::map<uint64_t, Response> responses;
+  for (int i = 0; i < 3; i++) {
+    uint64_t tag;
+    Response response;
+    ASSERT_TRUE(ReadResponse(client, tag, response));
+    responses[tag] = response;
+  }
+  ASSERT_EQ(responses.size(), 3u);
+  EXPECT_EQ(responses[1].status, 1);
+  EXPECT_EQ(responses[1].payload, "1 0 first");
+  EXPECT_EQ(responses[0x0102030405060708].status, 3);
+  EXPECT_EQ(responses[0x0102030405060708].payload, "3 11259375 ");
+  EXPECT_EQ(responses[3].status, 0);
+  EXPECT_EQ(responses[3].payload, "0 1000 " + std::string(100000, 'x'));
+
+  // Closing the write side still delivers the responses, then the server closes.
+  client.Write(RequestFrame(4, 2, 0, "last"));
+  client.ShutdownSend();
+  uint64_t tag;
+  Response response;
+  ASSERT_TRUE(ReadResponse(client, tag, response));
+  EXPECT_EQ(tag, 4u);
+  EXPECT_EQ(response.payload, "2 0 last");
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_EQ(received, 0u);
+}
+
+TEST(RpcSession, InFlightLimit) {
+  // Requests that are handled or whose responses are not written yet count against
+  // the limit, the session must still answer all of them.
+  std::atomic<int> handling{0};
+  std::atomic<int> max_handling{0};
+  RpcOptions options;
+  options.max_in_flight = 2;
+  LoopbackServer server(RpcSessions(
+      [&](const RpcRequest& request, RpcResponse& response) {
+        int n = ++handling;
+        int max = max_handling.load();
+        while (n > max && !max_handling.compare_exchange_weak(max, n)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        --handling;
+        Echo(request, response);
+      },
+      options));
+  LoopbackClient client(server.Port());
+
+  std::string frames;
+  for (uint64_t tag = 0; tag < 10; tag++) {
+    frames += RequestFrame(tag, 1, 0, std::to_string(tag));
+  }
+  client.Write(frames);
+
+  std::map<uint64_t, Response> responses;
+  for (int i = 0; i < 10; i++) {
+    uint64_t tag;
+    Response response;
+    ASSERT_TRUE(ReadResponse(client, tag, response));
+    responses[tag] = response;
+  }
+  ASSERT_EQ(responses.size(), 10u);
+  for (uint64_t tag = 0; tag < 10; tag++) {
+    EXPECT_EQ(responses[tag].payload, "1 0 " + std::to_string(tag));
+  }
+  EXPECT_LE(max_handling.load(), 2);
+}
+
+TEST(RpcSession, ProtocolErrorsCloseConnection) {
+  RpcOptions options;
+  options.max_payload_size = 16;
+  options.max_request_type = 3;
+  LoopbackServer server(RpcSessions(Echo, options));
+  size_t received;
+
+  {
+    LoopbackClient client(server.Port());
+    client.Write(RequestFrame(1, 4, 0, "unknown type"));
+    ASSERT_TRUE(client.ReadUntilClosed(received));
+    EXPECT_EQ(received, 0u);
+  }
+  {
+    LoopbackClient client(server.Port());
+    client.Write(RequestFrame(1, 1, 0, std::string(17, 'x')));
+    ASSERT_TRUE(client.ReadUntilClosed(received));
+    EXPECT_EQ(received, 0u);
+  }
+}
+
+TEST(RpcSession, IdleTimeout) {
+  RpcOptions options;
+  options.idle_timeout = std::chrono::milliseconds(50);
+  LoopbackServer server(RpcSessions(Echo, options));
+  LoopbackClient client(server.Port());
+
+  // A request resets the idle time, the connection is closed once it is idle again.
+  client.Write(RequestFrame(1, 1, 0, "ping"));
+  uint64_t tag;
+  Response response;
+  ASSERT_TRUE(ReadResponse(client, tag, response));
+  auto start = std::chrono::steady_clock::now();
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_EQ(received, 0u);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+}
+
+TEST(RpcSession, ReadTimeout) {
+  RpcOptions options;
+  options.idle_timeout = std::chrono::seconds(60);
+  options.read_timeout = std::chrono::milliseconds(50);
+  LoopbackServer server(RpcSessions(Echo, options));
+  LoopbackClient client(server.Port());
+
+  // Only part of the frame arrives.
+  std::string frame = RequestFrame(1, 1, 0, "incomplete");
+  client.Write(frame.substr(0, frame.size() - 1));
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_EQ(received, 0u);
+}
+
+TEST(RpcSession, ReadTimeoutPerFrame) {
+  // Part of a frame is always buffered, in total for longer than the read timeout,
+  // but every frame is completed within a third of it.
+  constexpr auto kReadTimeout = std::chrono::milliseconds(600);
+  constexpr int kFrames = 6;
+  RpcOptions options;
+  options.read_timeout = kReadTimeout;
+  LoopbackServer server(RpcSessions(Echo, options));
+  LoopbackClient client(server.Port());
+
+  std::string frames;
+  for (int tag = 0; tag < kFrames; tag++) {
+    frames += RequestFrame(tag, 1, 0, "frame");
+  }
+  size_t frame_size = frames.size() / kFrames;
+  for (size_t offset = 0; offset < frames.size(); offset += frame_size) {
+    size_t end = std::min(frames.size(), offset + frame_size + frame_size / 2);
+    size_t start = offset == 0 ? 0 : offset + frame_size / 2;
+    client.Write(frames.substr(start, end - start));
+    std::this_thread::sleep_for(kReadTimeout / 3);
+  }
+  for (int i = 0; i < kFrames; i++) {
+    uint64_t tag;
+    Response response;
+    ASSERT_TRUE(ReadResponse(client, tag, response));
+    EXPECT_EQ(response.payload, "1 0 frame");
+  }
+}
+
+TEST(RpcSession, WriteTimeout) {
+  // Responses much larger than the socket buffers, which the client doesn't read.
+  constexpr size_t kResponseSize = 16 * 1024 * 1024;
+  constexpr int kRequests = 4;
+  RpcOptions options;
+  options.write_timeout = std::chrono::milliseconds(100);
+  LoopbackServer server(RpcSessions(
+      [](const RpcRequest&, RpcResponse& response) {
+        response.payload.assign(std::string(kResponseSize, 'x'));
+      },
+      options));
+  LoopbackClient client(server.Port());
+
+  std::string frames;
+  for (int tag = 0; tag < kRequests; tag++) {
+    frames += RequestFrame(tag, 1, 0, "");
+  }
+  client.Write(frames);
+  ASSERT_TRUE(server.WaitUntilClosed());
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_LT(received, kRequests * (kRpcHeaderSize + kResponseSize));
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "server/host/core/connection_limit.h"
+#include "server/host/core/routes.h"
+#include "server/host/core/session.h"
+#include "test/helpers/loopback.h"
+
+namespace onnxruntime {
+namespace server {
+
+TEST(ConnectionLimit, LimitsOpenConnections) {
+  auto limit = std::make_shared<ConnectionLimit>(2);
+  ConnectionLimit::Slot first;
+  ConnectionLimit::Slot second;
+  ConnectionLimit::Slot third;
+  EXPECT_TRUE(limit->TryAcquire(first));
+  EXPECT_TRUE(limit->TryAcquire(second));
+  EXPECT_FALSE(limit->TryAcquire(third));
+  EXPECT_EQ(limit->GetOpenConnections(), 2u);
+
+  // Slots are released on destruction and when assigned over.
+  first = ConnectionLimit::Slot();
+  EXPECT_EQ(limit->GetOpenConnections(), 1u);
+  EXPECT_TRUE(limit->TryAcquire(third));
+  {
+    ConnectionLimit::Slot moved(std::move(third));
+    EXPECT_EQ(limit->GetOpenConnections(), 2u);
+  }
+  EXPECT_EQ(limit->GetOpenConnections(), 1u);
+}
+
+TEST(ConnectionLimit, ZeroIsUnlimited) {
+  auto limit = std::make_shared<ConnectionLimit>(0);
+  std::vector<ConnectionLimit::Slot> slots(100);
+  for (auto& slot : slots) {
+    EXPECT_TRUE(limit->TryAcquire(slot));
+  }
+  EXPECT_EQ(limit->GetOpenConnections(), 100u);
+  slots.clear();
+  EXPECT_EQ(limit->GetOpenConnections(), 0u);
+}
+
+namespace test {
+
+// Response body of GET /big, much larger than the socket buffers.
+constexpr size_t kBigBodySize = 16 * 1024 * 1024;
+
+// Serves an HTTP session for each connection, with the health check at "/" and GET /big.
+static LoopbackServer::ConnectionFn HttpSessions(const HttpSessionOptions& options) {
+  auto routes = std::make_shared<Routes>();
+  routes->RegisterController(http::verb::get, "/big", [](HttpContext& context) {
+    context.response.body().assign(std::string(kBigBodySize, 'x'));
+  });
+  routes->RegisterErrorCallback([](HttpContext& context) {
+    context.response.result(context.error_code);
+  });
+  return [routes, options](tcp::socket&& socket, ConnectionLimit::Slot&& connection) {
+    std::make_shared<HttpSession>(routes, options, std::move(socket), std::move(connection))->Run();
+  };
+}
+
+TEST(HttpSession, IdleTimeout) {
+  HttpSessionOptions options;
+  options.idle_timeout = std::chrono::milliseconds(50);
+  LoopbackServer server(HttpSessions(options));
+  LoopbackClient client(server.Port());
+
+  // The idle time starts after the response is written.
+  const std::string response_start = "HTTP/1.1 200 OK";
+  client.Write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  std::string response(response_start.size(), '\0');
+  ASSERT_TRUE(client.Read(&response[0], response.size()));
+  EXPECT_EQ(response, response_start);
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(client.ReadUntilClosed());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+}
+
+TEST(HttpSession, HeaderTimeout) {
+  HttpSessionOptions options;
+  options.idle_timeout = std::chrono::seconds(60);
+  options.header_timeout = std::chrono::milliseconds(50);
+  LoopbackServer server(HttpSessions(options));
+  LoopbackClient client(server.Port());
+
+  client.Write("GET / HTTP/1.1\r\nHost: local");
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_EQ(received, 0u);
+}
+
+TEST(HttpSession, BodyTimeout) {
+  HttpSessionOptions options;
+  options.body_timeout = std::chrono::milliseconds(50);
+  LoopbackServer server(HttpSessions(options));
+  LoopbackClient client(server.Port());
+
+  client.Write("POST /score HTTP/1.1\r\nHost: localhost\r\nContent-Length: 10\r\n\r\n12345");
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_EQ(received, 0u);
+}
+
+TEST(HttpSession, WriteTimeout) {
+  constexpr int kRequests = 4;
+  HttpSessionOptions options;
+  options.write_timeout = std::chrono::milliseconds(100);
+  LoopbackServer server(HttpSessions(options));
+  LoopbackClient client(server.Port());
+
+  // Pipelined requests whose responses the client doesn't read.
+  std::string requests;
+  for (int i = 0; i < kRequests; i++) {
+    requests += "GET /big HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  }
+  client.Write(requests);
+  ASSERT_TRUE(server.WaitUntilClosed());
+  size_t received;
+  ASSERT_TRUE(client.ReadUntilClosed(received));
+  EXPECT_LT(received, kRequests * kBigBodySize);
+}
+
+}  // namespace test
+}  // namespace server
+}  // namespace onnxruntime
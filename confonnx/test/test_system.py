@@ -11,7 +11,8 @@ import numpy as np
 
 import confonnx.main
 import confonnx.encrypt_model
-from confonnx.client import Client
+import confonnx.predict_pb2 as predict_pb2
+from confonnx.client import Client, RequestError
 import tensorproto_diff
 from utils import Server, load_json, save_json, assert_output_allclose, random_akv_key_name, delete_akv_key
 
@@ -128,6 +129,18 @@ def test_api_basic():
 
     assert_output_allclose(output, model['ref_output'])
 
+def test_api_binary_format():
+    model = MATMUL_1
+    port = 8001
+
+    client = Client(f'http://localhost:{port}/', enclave_allow_debug=True)
+
+    with Server(model_path=model['model'], port=port):
+        output = client.predict_binary(model['input'])
+
+    assert_output_allclose(output, model['ref_output'])
+    assert client.model_version == 1
+
 def test_api_invalid_key():
     model = MATMUL_1
     port = 8001
@@ -163,6 +176,84 @@ def test_api_local_key_rollover():
     assert client.key_rollover_count in [2, 3]
     assert client.key_invalid_count == 0
 
+def test_api_update_model(tmp_path):
+    old_model = SQUEEZENET
+    new_model = MATMUL_1
+    port = 8001
+    encrypted_model_path = tmp_path / 'model.onnx.enc'
+    encrypted_update_path = tmp_path / 'update.onnx.enc'
+
+    key = confonnx.encrypt_model.generate_key()
+    confonnx.encrypt_model.encrypt_model(old_model['model'], encrypted_model_path, key=key)
+    encrypted_replay_path = tmp_path / 'replay.onnx.enc'
+    confonnx.encrypt_model.encrypt_model(new_model['model'], encrypted_update_path, key=key, update_version=2)
+    confonnx.encrypt_model.encrypt_model(old_model['model'], encrypted_replay_path, key=key, update_version=2)
+
+    client = Client(f'http://localhost:{port}/', enclave_allow_debug=True)
+
+    with Server(model_path=encrypted_model_path, port=port, use_model_key_provisioning=True):
+        client.provision_model_key(key)
+        client.predict({'data_0': tensorproto_diff.load_tensorproto(old_model['input']['data_0'])})
+        assert client.model_version == 1
+
+        with open(encrypted_update_path, 'rb') as fp:
+            encrypted_update = fp.read()
+        assert client.update_model(encrypted_update) == 2
+
+        # Replaying an update or reusing its version must not roll back the model.
+        with open(encrypted_replay_path, 'rb') as fp:
+            encrypted_replay = fp.read()
+        for payload in [encrypted_update, encrypted_replay]:
+            with pytest.raises(RequestError):
+                client.update_model(payload)
+
+        output = client.predict(new_model['input'])
+        assert client.model_version == 2
+
+    assert_output_allclose(output, new_model['ref_output'])
+
+def test_api_post_processing():
+    model = SQUEEZENET
+    port = 8001
+    k = 5
+
+    data = tensorproto_diff.load_tensorproto(model['input']['data_0'])
+    ref_output = tensorproto_diff.load_tensorproto(model['ref_output']['softmaxout_1'])
+    ref_output = ref_output.reshape(ref_output.shape[0], -1)
+    ref_indices = np.argsort(-ref_output, axis=-1, kind='stable')[..., :k]
+
+    client = Client(f'http://localhost:{port}/', enclave_allow_debug=True)
+    post_processing = {
+        'softmaxout_1': predict_pb2.PostProcessing(type=predict_pb2.PostProcessing.TOP_K, k=k)
+    }
+
+    with Server(model_path=model['model'], port=port):
+        output = client.predict({'data_0': data}, post_processing)
+
+    assert output['softmaxout_1'].shape == ref_indices.shape
+    np.testing.assert_array_equal(output['softmaxout_1_indices'], ref_indices)
+    np.testing.assert_allclose(output['softmaxout_1'],
+                               np.take_along_axis(ref_output, ref_indices, axis=-1), rtol=1e-5)
+
+@pytest.mark.parametrize('encoding', [
+    predict_pb2.WireEncoding(type=predict_pb2.WireEncoding.FLOAT16),
+    predict_pb2.WireEncoding(type=predict_pb2.WireEncoding.BFLOAT16),
+    predict_pb2.WireEncoding(type=predict_pb2.WireEncoding.INT8, scale=0.5)
+])
+def test_api_wire_encoding(encoding):
+    model = MATMUL_1
+    port = 8001
+
+    client = Client(f'http://localhost:{port}/', enclave_allow_debug=True)
+
+    with Server(model_path=model['model'], port=port):
+        output = client.predict(model['input'],
+                                input_encodings={'X': encoding},
+                                output_encodings={'Y': encoding})
+
+    # All values of the test model are exactly representable in each encoding.
+    assert_output_allclose(output, model['ref_output'])
+
 akv = pytest.mark.skipif(
     not os.getenv('CONFONNX_TEST_APP_ID'), reason="CONFONNX_TEST_* env var missing"
 )
@@ -4,11 +4,13 @@
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <string>
 
 #include <confmsg/shared/util.h>
 #include <confmsg/shared/crypto.h>
 
-std::vector<uint8_t> EncryptModelFile(const std::vector<uint8_t>& key, const std::string& in_filename, const std::string& out_filename) {
+// update_version is 0 for the initial model.
+std::vector<uint8_t> EncryptModelFile(const std::vector<uint8_t>& key, const std::string& in_filename, const std::string& out_filename, uint32_t update_version) {
   std::ifstream fin(in_filename, std::ios::in | std::ios::binary);
   if (!fin) throw std::runtime_error("Can't open file: " + in_filename);
   fin.seekg(0, std::ios_base::end);
@@ -19,27 +21,50 @@ std::vector<uint8_t> EncryptModelFile(const std::vector<uint8_t>& key, const std
   fin.close();
 
   confmsg::CBuffer plain(buffer, buf_sz);
+  bool update = update_version > 0;
   std::vector<uint8_t> iv(IV_SIZE, 0);
+  std::vector<uint8_t> version;
   std::vector<uint8_t> cipher, tag;
 
   confmsg::InitCrypto();
-  confmsg::internal::Encrypt(key, iv, plain, confmsg::CBuffer(), cipher, tag);
+  // Model updates reuse the model key and therefore need a fresh IV.
+  // The big-endian version is authenticated so that the server can reject
+  // replayed older updates. Both are prepended to the ciphertext.
+  if (update) {
+    confmsg::Randomize(iv, IV_SIZE);
+    version = {uint8_t(update_version >> 24), uint8_t(update_version >> 16),
+               uint8_t(update_version >> 8), uint8_t(update_version)};
+  }
+  confmsg::internal::Encrypt(key, iv, plain, version, cipher, tag);
 
   std::ofstream fout(out_filename, std::ios::out | std::ios::binary);
   if (!fout) throw std::runtime_error("Can't open file: " + in_filename);
+  if (update) {
+    fout.write((char*)version.data(), version.size());
+    fout.write((char*)iv.data(), iv.size());
+  }
   fout.write((char*)cipher.data(), cipher.size());
   fout.write((char*)tag.data(), tag.size());
   fout.close();
 
   std::vector<uint8_t> model_hash;
-  confmsg::internal::SHA256({cipher, tag}, model_hash);
+  if (update) {
+    confmsg::internal::SHA256({version, iv, cipher, tag}, model_hash);
+  } else {
+    confmsg::internal::SHA256({cipher, tag}, model_hash);
+  }
   return model_hash;
 }
 
 int main(int argc, const char** argv) {
   try {
-    if (argc != 4) {
-      std::cout << "Usage: " << argv[0] << " <key|key-file> <in-file> <out-file>" << std::endl;
+    uint32_t update_version = 0;
+    if (argc == 6 && std::string(argv[4]) == "--update") {
+      update_version = std::stoul(argv[5]);
+    }
+    if (argc != 4 && update_version == 0) {
+      std::cout << "Usage: " << argv[0] << " <key|key-file> <in-file> <out-file> [--update <version>]" << std::endl;
+      std::cout << "  <version> must be greater than the version currently served, the initial model is version 1." << std::endl;
       return 1;
     }
 
@@ -57,7 +82,7 @@ int main(int argc, const char** argv) {
 
     std::vector<uint8_t> key = confmsg::Hex2Buffer(key_hex);
 
-    std::vector<uint8_t> model_hash = EncryptModelFile(key, in_filename, out_filename);
+    std::vector<uint8_t> model_hash = EncryptModelFile(key, in_filename, out_filename, update_version);
     std::cout << "model hash: " << confmsg::Buffer2Hex(model_hash) << std::endl;
 
     return 0;
@@ -0,0 +1,802 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Load generator for the /score endpoint. Requests are encrypted with confmsg
+// like the Python client does, but sent over a pool of keep-alive connections
+// from asynchronous workers so that the server and not the client is the bottleneck.
+//
+// Closed loop (default): every connection sends its next request as soon as the
+// previous response arrived, the offered load adapts to the server.
+// Open loop (--rate): requests arrive at a fixed rate independent of responses.
+// Latency is measured from the scheduled arrival time, so that queueing on a
+// saturated server is not hidden (coordinated omission).
+//
+// Each connection has its own confmsg session. The key exchange is repeated
+// when the server signals an outdated key or rejects the request with a crypto error.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include "boost/program_options.hpp"
+#include <nlohmann/json.hpp>
+
+#include <confmsg/client/api.h>
+#include <confmsg/shared/crypto.h>
+#include <confmsg/shared/util.h>
+
+#include "server/shared/status.h"
+#include "test/helpers/onnx_protobuf.h"
+#include "test/helpers/predict_protobuf.h"
+
+namespace onnxruntime {
+namespace server {
+namespace loadgen {
+
+namespace po = boost::program_options;
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string url = "http://localhost:8001/";
+  std::string auth_key;
+  std::vector<std::string> pb_in;
+  std::vector<std::string> pb_in_names;
+  std::string model_info;
+  int64_t batch_size = 1;
+  int connections = 8;
+  int threads = 1;
+  double rate = 0;  // requests/s, 0 for closed loop
+  double duration = 30;
+  double warmup = 5;
+  std::string enclave_signing_key_file;
+  std::string enclave_hash;
+  std::string enclave_model_hash;
+  bool enclave_allow_debug = false;
+  std::string hdr_out;
+};
+
+/**
+ * Log-linear latency histogram in microseconds, in the spirit of HdrHistogram:
+ * values below 128 are exact, larger values are bucketed with 64 sub-buckets per
+ * power of two (< 1.6% relative error). Recording is O(1) and allocation-free.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() : counts_(kBucketCount, 0) {}
+
+  void Record(uint64_t us) {
+    counts_[Index(std::min(us, kMaxValue))]++;
+    total_++;
+    sum_ += us;
+    max_ = std::max(max_, us);
+  }
+
+  void Add(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; i++) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return total_; }
+  uint64_t Max() const { return max_; }
+  double Mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+
+  uint64_t Percentile(double p) const {
+    uint64_t target = static_cast<uint64_t>(std::ceil(p / 100 * total_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+      seen += counts_[i];
+      if (seen >= std::max<uint64_t>(target, 1)) {
+        return std::min(HighestEquivalent(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  // Percentile distribution in the text format of HdrHistogram, values in milliseconds.
+  void WritePercentiles(std::ostream& out) const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    out << line;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+      if (counts_[i] == 0) {
+        continue;
+      }
+      seen += counts_[i];
+      double q = static_cast<double>(seen) / total_;
+      double value_ms = std::min(HighestEquivalent(i), max_) / 1000.0;
+      if (seen == total_) {
+        std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu\n", value_ms, q, static_cast<unsigned long long>(seen));
+      } else {
+        std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu %14.2f\n", value_ms, q, static_cast<unsigned long long>(seen), 1 / (1 - q));
+      }
+      out << line;
+    }
+    std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, Max            = %12.3f]\n", Mean() / 1000.0, max_ / 1000.0);
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Total count    = %12llu]\n", static_cast<unsigned long long>(total_));
+    out << line;
+  }
+
+ private:
+  static constexpr int kSubBucketBits = 6;
+  static constexpr uint64_t kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr uint64_t kLinearLimit = 2 * kSubBucketCount;
+  static constexpr int kMaxShift = 34;  // > 4 hours
+  static constexpr uint64_t kMaxValue = (2 * kSubBucketCount << kMaxShift) - 1;
+  static constexpr size_t kBucketCount = kLinearLimit + kMaxShift * kSubBucketCount;
+
+  static size_t Index(uint64_t v) {
+    if (v < kLinearLimit) {
+      return v;
+    }
+    int shift = 63 - __builtin_clzll(v) - kSubBucketBits;
+    uint64_t sub = v >> shift;  // in [kSubBucketCount, 2 * kSubBucketCount)
+    return kLinearLimit + (shift - 1) * kSubBucketCount + (sub - kSubBucketCount);
+  }
+
+  static uint64_t HighestEquivalent(size_t index) {
+    if (index < kLinearLimit) {
+      return index;
+    }
+    int shift = static_cast<int>((index - kLinearLimit) / kSubBucketCount) + 1;
+    uint64_t sub = (index - kLinearLimit) % kSubBucketCount + kSubBucketCount;
+    return ((sub + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t total_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+};
+
+struct Stats {
+  LatencyHistogram latency;
+  uint64_t completed = 0;
+  uint64_t key_exchanges = 0;
+  uint64_t key_retries = 0;
+  std::map<std::string, uint64_t> connection_errors;  // by error message
+  std::map<int, uint64_t> http_errors;
+  // When the last measured request finished, requests sent before the end
+  // of the measurement may finish after it.
+  Clock::time_point last_completion;
+
+  void Add(const Stats& other) {
+    latency.Add(other.latency);
+    completed += other.completed;
+    key_exchanges += other.key_exchanges;
+    key_retries += other.key_retries;
+    for (const auto& e : other.connection_errors) {
+      connection_errors[e.first] += e.second;
+    }
+    for (const auto& e : other.http_errors) {
+      http_errors[e.first] += e.second;
+    }
+    last_completion = std::max(last_completion, other.last_completion);
+  }
+};
+
+// State shared read-only by all workers.
+struct Target {
+  std::string host;
+  std::string port;
+  std::string score_path;
+  std::string authorization;
+  std::vector<uint8_t> plaintext;
+  std::string enclave_signing_key;
+  std::vector<uint8_t> enclave_hash;
+  std::vector<uint8_t> service_id;
+  bool allow_debug;
+  Clock::time_point measure_start;
+  Clock::time_point end;
+};
+
+class Worker;
+
+class Connection : public std::enable_shared_from_this<Connection> {
+ public:
+  static constexpr Clock::duration kMinReconnectDelay = std::chrono::milliseconds(100);
+  static constexpr Clock::duration kMaxReconnectDelay = std::chrono::seconds(5);
+
+  Connection(Worker& worker, const Target& target);
+
+  void Connect(const tcp::resolver::results_type& endpoints);
+  void Send(Clock::time_point scheduled);
+  void Close();
+  bool IsOpen() const { return socket_.is_open(); }
+
+ private:
+  void SendMessage(bool key_request);
+  void OnResponse(bool key_request, beast::error_code ec);
+  void Fail(beast::error_code ec);
+  void Done(bool measured);
+
+  Worker& worker_;
+  const Target& target_;
+  tcp::socket socket_;
+  tcp::resolver::results_type endpoints_;
+  confmsg::Client client_;
+  beast::flat_buffer buffer_;
+  http::request<http::string_body> req_;
+  http::response<http::string_body> res_;
+  std::vector<uint8_t> msg_;
+  Clock::time_point scheduled_;
+  // Delay before reconnecting after an error, doubled on every failed attempt.
+  Clock::duration reconnect_delay_ = kMinReconnectDelay;
+  bool key_outdated_ = true;
+  bool retried_ = false;
+};
+
+/**
+ * Runs a share of the connections on its own io_context and thread,
+ * workers don't share any mutable state.
+ */
+class Worker {
+ public:
+  Worker(const Target& target, int connections, double rate)
+      : target_(target), resolver_(io_), arrival_timer_(io_), end_timer_(io_), rate_(rate) {
+    for (int i = 0; i < connections; i++) {
+      connections_.push_back(std::make_shared<Connection>(*this, target));
+    }
+  }
+
+  void Run() {
+    auto endpoints = resolver_.resolve(target_.host, target_.port);
+    for (auto& c : connections_) {
+      c->Connect(endpoints);
+    }
+    if (rate_ > 0) {
+      next_arrival_ = Clock::now();
+      ScheduleArrival();
+    }
+    end_timer_.expires_at(target_.end);
+    end_timer_.async_wait([this](beast::error_code) { Stop(); });
+    try {
+      io_.run();
+    } catch (...) {
+      // E.g. attestation or decryption failures, abort this worker and report after joining.
+      error_ = std::current_exception();
+    }
+  }
+
+  net::io_context& Io() { return io_; }
+  Stats& GetStats() { return stats_; }
+  bool Stopping() const { return stopping_; }
+  std::exception_ptr Error() const { return error_; }
+
+  // Called by connections when they are ready for the next request.
+  void OnIdle(const std::shared_ptr<Connection>& c) {
+    if (stopping_) {
+      c->Close();
+      return;
+    }
+    if (rate_ <= 0) {
+      c->Send(Clock::now());
+    } else if (!pending_.empty()) {
+      Clock::time_point scheduled = pending_.front();
+      pending_.pop_front();
+      c->Send(scheduled);
+    } else {
+      idle_.push_back(c);
+    }
+  }
+
+ private:
+  void ScheduleArrival() {
+    // Generate all arrivals that are due, the timer may fire late under load.
+    auto now = Clock::now();
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / rate_));
+    while (next_arrival_ <= now) {
+      if (!idle_.empty()) {
+        auto c = idle_.front();
+        idle_.pop_front();
+        c->Send(next_arrival_);
+      } else {
+        pending_.push_back(next_arrival_);
+      }
+      next_arrival_ += interval;
+    }
+    arrival_timer_.expires_at(next_arrival_);
+    arrival_timer_.async_wait([this](beast::error_code ec) {
+      if (!ec && !stopping_) {
+        ScheduleArrival();
+      }
+    });
+  }
+
+  void Stop() {
+    stopping_ = true;
+    arrival_timer_.cancel();
+    for (auto& c : idle_) {
+      c->Close();
+    }
+    idle_.clear();
+    // Requests that were never sent are neither completed nor errors,
+    // but show up as reduced throughput.
+    pending_.clear();
+    // Don't wait forever for in-flight requests of a stuck server.
+    end_timer_.expires_after(std::chrono::seconds(10));
+    end_timer_.async_wait([this](beast::error_code ec) {
+      if (!ec) {
+        io_.stop();
+      }
+    });
+    // run() returns once all connections are closed and the drain timer is done,
+    // so cancel the timer when the last connection closed.
+    CheckDrained();
+  }
+
+ public:
+  // Called by connections after closing.
+  void CheckDrained() {
+    if (!stopping_) {
+      return;
+    }
+    bool open = std::any_of(connections_.begin(), connections_.end(), [](const auto& c) { return c->IsOpen(); });
+    if (!open) {
+      end_timer_.cancel();
+    }
+  }
+
+ private:
+  const Target& target_;
+  net::io_context io_;
+  tcp::resolver resolver_;
+  net::steady_timer arrival_timer_;
+  net::steady_timer end_timer_;
+  double rate_;
+  Clock::time_point next_arrival_;
+  std::vector<std::shared_ptr<Connection>> connections_;
+  std::deque<std::shared_ptr<Connection>> idle_;
+  std::deque<Clock::time_point> pending_;
+  bool stopping_ = false;
+  Stats stats_;
+  std::exception_ptr error_;
+};
+
+Connection::Connection(Worker& worker, const Target& target)
+    : worker_(worker),
+      target_(target),
+      socket_(worker.Io()),
+      client_(confmsg::RandomKeyProvider::Create(KEY_SIZE),
+              target.enclave_signing_key, target.enclave_hash, target.service_id, target.allow_debug) {
+  req_.method(http::verb::post);
+  req_.target(target.score_path);
+  req_.version(11);
+  req_.set(http::field::host, target.host);
+  req_.set(http::field::content_type, "application/octet-stream");
+  req_.set(http::field::accept, "application/octet-stream");
+  if (!target.authorization.empty()) {
+    req_.set(http::field::authorization, target.authorization);
+  }
+  req_.keep_alive(true);
+}
+
+void Connection::Connect(const tcp::resolver::results_type& endpoints) {
+  endpoints_ = endpoints;
+  auto self = shared_from_this();
+  net::async_connect(socket_, endpoints, [self](beast::error_code ec, const tcp::endpoint&) {
+    if (ec) {
+      self->Fail(ec);
+      return;
+    }
+    self->socket_.set_option(tcp::no_delay(true), ec);
+    self->worker_.OnIdle(self);
+  });
+}
+
+void Connection::Send(Clock::time_point scheduled) {
+  scheduled_ = scheduled;
+  retried_ = false;
+  SendMessage(key_outdated_);
+}
+
+void Connection::SendMessage(bool key_request) {
+  size_t msg_size;
+  if (key_request) {
+    msg_.resize(1024);
+    client_.MakeKeyRequest(msg_.data(), &msg_size, msg_.size());
+  } else {
+    msg_.resize(target_.plaintext.size() + 1024);
+    client_.MakeRequest(target_.plaintext, msg_.data(), &msg_size, msg_.size());
+  }
+  req_.body().assign(reinterpret_cast<const char*>(msg_.data()), msg_size);
+  req_.prepare_payload();
+
+  auto self = shared_from_this();
+  http::async_write(socket_, req_, [self, key_request](beast::error_code ec, size_t) {
+    if (ec) {
+      self->Fail(ec);
+      return;
+    }
+    self->res_ = {};
+    http::async_read(self->socket_, self->buffer_, self->res_, [self, key_request](beast::error_code ec, size_t) {
+      self->OnResponse(key_request, ec);
+    });
+  });
+}
+
+void Connection::OnResponse(bool key_request, beast::error_code ec) {
+  if (ec) {
+    Fail(ec);
+    return;
+  }
+  Stats& stats = worker_.GetStats();
+  bool measured = scheduled_ >= target_.measure_start;
+
+  if (res_.result() != http::status::ok) {
+    int error_code = -1;
+    try {
+      error_code = nlohmann::json::parse(res_.body()).at("error_code").get<int>();
+    } catch (const std::exception&) {
+      // Not a JSON error, e.g. from a proxy.
+    }
+    if (error_code == CRYPTO_ERROR && !retried_) {
+      // The server rolled over its key since our last key exchange, retry once with a new key.
+      retried_ = true;
+      key_outdated_ = true;
+      stats.key_retries++;
+      SendMessage(true);
+      return;
+    }
+    if (measured) {
+      stats.http_errors[res_.result_int()]++;
+    }
+    Done(measured);
+    return;
+  }
+
+  confmsg::Client::Result result = client_.HandleMessage(reinterpret_cast<const uint8_t*>(res_.body().data()), res_.body().size());
+  if (key_request) {
+    key_outdated_ = false;
+    stats.key_exchanges++;
+    SendMessage(false);
+    return;
+  }
+  key_outdated_ = result.IsKeyOutdated();
+
+  if (measured) {
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled_);
+    stats.latency.Record(latency.count());
+    stats.completed++;
+  }
+  Done(measured);
+}
+
+void Connection::Done(bool measured) {
+  if (measured) {
+    worker_.GetStats().last_completion = Clock::now();
+  }
+  // The server answered, so the connection is healthy again.
+  reconnect_delay_ = kMinReconnectDelay;
+  if (worker_.Stopping()) {
+    Close();
+    return;
+  }
+  if (!res_.keep_alive()) {
+    beast::error_code ec;
+    socket_.close(ec);
+    Connect(endpoints_);
+    return;
+  }
+  worker_.OnIdle(shared_from_this());
+}
+
+void Connection::Fail(beast::error_code ec) {
+  if (worker_.Stopping()) {
+    Close();
+    return;
+  }
+  // Errors are counted and reported at the end, printing each one would flood
+  // the output while the server is unreachable.
+  if (scheduled_ >= target_.measure_start) {
+    worker_.GetStats().connection_errors[ec.message()]++;
+  }
+  beast::error_code ignored;
+  socket_.close(ignored);
+  // A new connection doesn't invalidate the confmsg session.
+  auto self = shared_from_this();
+  auto timer = std::make_shared<net::steady_timer>(worker_.Io(), reconnect_delay_);
+  reconnect_delay_ = std::min(2 * reconnect_delay_, kMaxReconnectDelay);
+  timer->async_wait([self, timer](beast::error_code) {
+    if (self->worker_.Stopping()) {
+      self->Close();
+      return;
+    }
+    self->Connect(self->endpoints_);
+  });
+}
+
+void Connection::Close() {
+  beast::error_code ec;
+  socket_.shutdown(tcp::socket::shutdown_both, ec);
+  socket_.close(ec);
+  worker_.CheckDrained();
+}
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+static onnx::TensorProto_DataType ParseDataType(const std::string& type) {
+  static const std::map<std::string, onnx::TensorProto_DataType> types = {
+      {"float32", onnx::TensorProto_DataType_FLOAT},
+      {"float64", onnx::TensorProto_DataType_DOUBLE},
+      {"float16", onnx::TensorProto_DataType_FLOAT16},
+      {"bfloat16", onnx::TensorProto_DataType_BFLOAT16},
+      {"int8", onnx::TensorProto_DataType_INT8},
+      {"int16", onnx::TensorProto_DataType_INT16},
+      {"int32", onnx::TensorProto_DataType_INT32},
+      {"int64", onnx::TensorProto_DataType_INT64},
+      {"uint8", onnx::TensorProto_DataType_UINT8},
+      {"uint16", onnx::TensorProto_DataType_UINT16},
+      {"uint32", onnx::TensorProto_DataType_UINT32},
+      {"uint64", onnx::TensorProto_DataType_UINT64},
+      {"bool", onnx::TensorProto_DataType_BOOL},
+  };
+  auto it = types.find(type);
+  if (it == types.end()) {
+    throw std::runtime_error("Unsupported input type " + type);
+  }
+  return it->second;
+}
+
+static size_t ElementSize(onnx::TensorProto_DataType type) {
+  switch (type) {
+    case onnx::TensorProto_DataType_DOUBLE:
+    case onnx::TensorProto_DataType_INT64:
+    case onnx::TensorProto_DataType_UINT64:
+      return 8;
+    case onnx::TensorProto_DataType_FLOAT:
+    case onnx::TensorProto_DataType_INT32:
+    case onnx::TensorProto_DataType_UINT32:
+      return 4;
+    case onnx::TensorProto_DataType_FLOAT16:
+    case onnx::TensorProto_DataType_BFLOAT16:
+    case onnx::TensorProto_DataType_INT16:
+    case onnx::TensorProto_DataType_UINT16:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+// Random inputs from a model info file as written by confonnx.get_model_info.
+// Symbolic dimensions are set to batch_size.
+static void InputsFromModelInfo(const std::string& path, int64_t batch_size, PredictRequest& request) {
+  auto info = nlohmann::json::parse(ReadFile(path));
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> float_dist(-1.0f, 1.0f);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  for (const auto& input : info.at("inputs").items()) {
+    onnx::TensorProto_DataType type = ParseDataType(input.value().at("type").get<std::string>());
+    onnx::TensorProto& tensor = (*request.mutable_inputs())[input.key()];
+    tensor.set_data_type(type);
+    size_t count = 1;
+    for (const auto& dim : input.value().at("shape")) {
+      int64_t d = dim.is_number_integer() ? dim.get<int64_t>() : batch_size;
+      tensor.add_dims(d);
+      count *= d;
+    }
+    std::string data(count * ElementSize(type), '\0');
+    if (type == onnx::TensorProto_DataType_FLOAT) {
+      float* p = reinterpret_cast<float*>(&data[0]);
+      for (size_t i = 0; i < count; i++) {
+        p[i] = float_dist(rng);
+      }
+    } else if (type != onnx::TensorProto_DataType_BOOL) {
+      for (char& c : data) {
+        c = static_cast<char>(byte_dist(rng));
+      }
+    }
+    tensor.set_raw_data(std::move(data));
+  }
+}
+
+static void InputsFromPbFiles(const std::vector<std::string>& files, const std::vector<std::string>& names,
+                              PredictRequest& request) {
+  if (!names.empty() && names.size() != files.size()) {
+    throw std::runtime_error("--pb-in-names must have one name per --pb-in file");
+  }
+  for (size_t i = 0; i < files.size(); i++) {
+    onnx::TensorProto tensor;
+    if (!tensor.ParseFromString(ReadFile(files[i]))) {
+      throw std::runtime_error("Cannot parse TensorProto from " + files[i]);
+    }
+    std::string name = names.empty() ? tensor.name() : names[i];
+    if (name.empty()) {
+      throw std::runtime_error(files[i] + " has no tensor name, use --pb-in-names");
+    }
+    tensor.clear_name();
+    (*request.mutable_inputs())[name] = std::move(tensor);
+  }
+}
+
+static Target MakeTarget(const Options& options) {
+  Target target;
+  const std::string scheme = "http://";
+  if (options.url.compare(0, scheme.size(), scheme) != 0) {
+    throw std::runtime_error("Only http:// URLs are supported");
+  }
+  std::string rest = options.url.substr(scheme.size());
+  size_t slash = rest.find('/');
+  std::string authority = rest.substr(0, slash);
+  std::string base = slash == std::string::npos ? "/" : rest.substr(slash);
+  if (base.back() != '/') {
+    base += '/';
+  }
+  size_t colon = authority.rfind(':');
+  target.host = authority.substr(0, colon);
+  target.port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+  target.score_path = base + "score";
+  if (!options.auth_key.empty()) {
+    target.authorization = "Bearer " + options.auth_key;
+  }
+
+  PredictRequest request;
+  if (!options.pb_in.empty()) {
+    InputsFromPbFiles(options.pb_in, options.pb_in_names, request);
+  } else if (!options.model_info.empty()) {
+    InputsFromModelInfo(options.model_info, options.batch_size, request);
+  } else {
+    throw std::runtime_error("Either --pb-in or --model-info is required");
+  }
+  target.plaintext.resize(request.ByteSizeLong());
+  if (!request.SerializeToArray(target.plaintext.data(), static_cast<int>(target.plaintext.size()))) {
+    throw std::runtime_error("protobuf serialization error");
+  }
+
+  if (!options.enclave_signing_key_file.empty()) {
+    target.enclave_signing_key = ReadFile(options.enclave_signing_key_file);
+  }
+  if (!options.enclave_hash.empty()) {
+    target.enclave_hash = confmsg::Hex2Buffer(options.enclave_hash);
+  }
+  if (!options.enclave_model_hash.empty()) {
+    target.service_id = confmsg::Hex2Buffer(options.enclave_model_hash);
+  }
+  target.allow_debug = options.enclave_allow_debug;
+  return target;
+}
+
+static void Report(const Stats& stats, double seconds) {
+  std::printf("Completed:       %llu requests in %.1f s\n", static_cast<unsigned long long>(stats.completed), seconds);
+  std::printf("Throughput:      %.1f req/s\n", stats.completed / seconds);
+  std::printf("Key exchanges:   %llu (%llu retries after crypto errors)\n",
+              static_cast<unsigned long long>(stats.key_exchanges), static_cast<unsigned long long>(stats.key_retries));
+  uint64_t connection_errors = 0;
+  for (const auto& e : stats.connection_errors) {
+    connection_errors += e.second;
+  }
+  std::printf("Conn. errors:    %llu\n", static_cast<unsigned long long>(connection_errors));
+  for (const auto& e : stats.connection_errors) {
+    std::printf("  %s: %llu\n", e.first.c_str(), static_cast<unsigned long long>(e.second));
+  }
+  for (const auto& e : stats.http_errors) {
+    std::printf("HTTP %d:        %llu\n", e.first, static_cast<unsigned long long>(e.second));
+  }
+  const auto& h = stats.latency;
+  std::printf("Latency (ms):    mean %.3f  p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  p99.99 %.3f  max %.3f\n",
+              h.Mean() / 1000, h.Percentile(50) / 1000.0, h.Percentile(90) / 1000.0, h.Percentile(99) / 1000.0,
+              h.Percentile(99.9) / 1000.0, h.Percentile(99.99) / 1000.0, h.Max() / 1000.0);
+}
+
+static int Run(const Options& options) {
+  confmsg::InitCrypto();
+  Target target = MakeTarget(options);
+  int threads = std::max(1, std::min(options.threads, options.connections));
+
+  auto start = Clock::now();
+  target.measure_start = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+  target.end = target.measure_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < threads; i++) {
+    int connections = options.connections / threads + (i < options.connections % threads ? 1 : 0);
+    workers.push_back(std::make_unique<Worker>(target, connections, options.rate / threads));
+  }
+  std::vector<std::thread> worker_threads;
+  for (auto& w : workers) {
+    worker_threads.emplace_back([&w]() { w->Run(); });
+  }
+  for (auto& t : worker_threads) {
+    t.join();
+  }
+  for (auto& w : workers) {
+    if (w->Error()) {
+      std::rethrow_exception(w->Error());
+    }
+  }
+
+  Stats stats;
+  for (auto& w : workers) {
+    stats.Add(w->GetStats());
+  }
+  // Measured requests are those sent during the measurement, which includes
+  // the time the last of them took to complete after its end.
+  auto measure_end = std::max(target.end, stats.last_completion);
+  Report(stats, std::chrono::duration<double>(measure_end - target.measure_start).count());
+  if (!options.hdr_out.empty()) {
+    std::ofstream out(options.hdr_out);
+    stats.latency.WritePercentiles(out);
+  }
+  return stats.completed > 0 ? 0 : 1;
+}
+
+}  // namespace loadgen
+}  // namespace server
+}  // namespace onnxruntime
+
+int main(int argc, char** argv) {
+  using namespace onnxruntime::server::loadgen;
+  Options options;
+  po::options_description desc("Load generator for the confonnx /score endpoint");
+  desc.add_options()("help,h", "Shows a help message and exits");
+  desc.add_options()("url", po::value(&options.url)->default_value(options.url), "Server URL");
+  desc.add_options()("auth-key", po::value(&options.auth_key), "Authentication key (HTTP Bearer)");
+  desc.add_options()("pb-in", po::value(&options.pb_in)->multitoken(), "TensorProto input files");
+  desc.add_options()("pb-in-names", po::value(&options.pb_in_names)->multitoken(), "Graph input name for each TensorProto input file (default: tensor names)");
+  desc.add_options()("model-info", po::value(&options.model_info), "Model info JSON file from confonnx.get_model_info, for random inputs");
+  desc.add_options()("batch-size", po::value(&options.batch_size)->default_value(options.batch_size), "Value of symbolic dimensions with --model-info");
+  desc.add_options()("connections", po::value(&options.connections)->default_value(options.connections), "Number of keep-alive connections");
+  desc.add_options()("threads", po::value(&options.threads)->default_value(options.threads), "Number of client threads, connections are split between them");
+  desc.add_options()("rate", po::value(&options.rate)->default_value(options.rate), "Open loop: requests per second (default: closed loop)");
+  desc.add_options()("duration", po::value(&options.duration)->default_value(options.duration), "Measurement duration in seconds");
+  desc.add_options()("warmup", po::value(&options.warmup)->default_value(options.warmup), "Unmeasured warm-up duration in seconds");
+  desc.add_options()("enclave-signing-key-file", po::value(&options.enclave_signing_key_file), "Path to expected enclave signing public key (PEM format)");
+  desc.add_options()("enclave-hash", po::value(&options.enclave_hash), "Expected enclave hash (hex encoded)");
+  desc.add_options()("enclave-model-hash", po::value(&options.enclave_model_hash), "Expected enclave model hash (hex encoded)");
+  desc.add_options()("enclave-allow-debug", po::bool_switch(&options.enclave_allow_debug), "Allow debug-enabled enclaves");
+  desc.add_options()("hdr-out", po::value(&options.hdr_out), "Write the latency percentile distribution in HdrHistogram text format");
+
+  try {
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      std::cout << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << std::endl
+              << desc << std::endl;
+    return 1;
+  }
+
+  try {
+    return Run(options);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 2;
+  }
+}
@@ -42,12 +42,19 @@ Server::~Server() {
 bool Server::RefreshKey(bool sync_only) {
   bool refreshed = key_provider->RefreshKey(sync_only);
   if (refreshed) {
+    std::lock_guard<std::mutex> lock(identity_mutex);
     MakePublicKeys();
     UpdateEvidence();
   }
   return refreshed;
 }
 
+void Server::SetServiceIdentifier(const std::vector<uint8_t>& new_service_identifier) {
+  std::lock_guard<std::mutex> lock(identity_mutex);
+  service_identifier = new_service_identifier;
+  UpdateEvidence();
+}
+
 void Server::UpdateEvidence() {
   // TODO skip if in simulation mode, otherwise we'll crash
   //      https://github.com/openenclave/openenclave/issues/3173
@@ -82,6 +89,8 @@ void Server::HandleKeyRequest(const KeyRequest* r, uint8_t* out_msg, size_t* out
     throw CryptoError("invalid client nonce");
   }
 
+  std::lock_guard<std::mutex> lock(identity_mutex);
+
   flatbuffers::FlatBufferBuilder builder;
 
   std::vector<uint8_t> msg;
@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <chrono>
+#include <mutex>
 
 #include <confmsg/shared/buffer.h>
 #include <confmsg/shared/crypto.h>
@@ -32,11 +33,15 @@ class Server {
   Server(const std::vector<uint8_t>& service_identifier, Callback f, std::unique_ptr<KeyProvider>&& kp);
   Server(const Server&) = delete;
   Server& operator=(const Server&) = delete;
-  Server(Server&&) = default;
+  Server(Server&&) = delete;
   ~Server();
 
   bool RefreshKey(bool sync_only);
 
+  // Replaces the service identifier returned in key responses and bound
+  // into the attestation evidence, e.g. after the served model changed.
+  void SetServiceIdentifier(const std::vector<uint8_t>& service_identifier);
+
   std::chrono::time_point<std::chrono::system_clock> GetLastKeyRefresh() const;
 
   void RespondToMessage(const uint8_t* in_msg, size_t in_msg_size, uint8_t* out_msg, size_t* out_msg_size, size_t max_out_msg_size);
@@ -54,6 +59,8 @@ class Server {
   std::vector<uint8_t> public_signing_key;
   std::vector<uint8_t> service_identifier;
   std::vector<std::pair<EvidenceType, std::vector<uint8_t>>> evidence;
+  // Guards the public keys, service identifier and evidence.
+  std::mutex identity_mutex;
 
   Callback request_callback;
 